@@ -1,37 +1,33 @@
 #include "backend/TurboSanta.h"
 #include "backend/clocktroller/clocktroller.h"
-#include "backend/debugger/great_library.h"
 #include "backend/graphics/screen.h"
 
 using back_end::clocktroller::Clocktroller;
-using back_end::debugger::GreatLibrary;
+using back_end::graphics::PixelFormat;
 using back_end::graphics::Screen;
 using back_end::graphics::ScreenRaster;
 using std::unique_ptr;
 
+// Hands each frame to the callback as it was drawn, in the format asked for,
+// without copying it.
 class TurboScreen : public Screen {
   public:
-    TurboScreen(void(*videoCallback)(const signed char* bitmap, int length)) : videoCallback_(videoCallback), bitmap(new  signed char[ScreenRaster::kScreenHeight * ScreenRaster::kScreenWidth]) {}
+    TurboScreen(void(*videoCallback)(const signed char* bitmap, int length)) : videoCallback_(videoCallback) {}
     virtual void Draw(const ScreenRaster& raster) {
-      for (int y = 0; y < ScreenRaster::kScreenHeight; y++) {
-        for (int x = 0; x < ScreenRaster::kScreenWidth; x++) {
-          bitmap.get()[x + y * ScreenRaster::kScreenWidth] = (signed)raster.Get(y, x);
-        }
-      }
-      videoCallback_(bitmap.get(), ScreenRaster::kScreenWidth * ScreenRaster::kScreenHeight);
+      videoCallback_(reinterpret_cast<const signed char*>(raster.data()), raster.size());
     }
   private:
     void(*videoCallback_)(const signed char* bitmap, int length);
-    unique_ptr<signed char> bitmap;
 };
 
 TurboSanta::TurboSanta() {}
 TurboSanta::~TurboSanta() {}
 
-void TurboSanta::init(unsigned char* rom, int length, void(*videoCallback)(const signed char* bitmap, int length)) {
+void TurboSanta::init(unsigned char* rom, int length, void(*videoCallback)(const signed char* bitmap, int length),
+                      PixelFormat format, unsigned char* const* frame_buffers) {
   turbo_screen = unique_ptr<Screen>(new TurboScreen(videoCallback));
-  // TODO(Brendan): This great library never gets deallocated. Fix it.
-  clocktroller = unique_ptr<Clocktroller>(new Clocktroller(turbo_screen.get(), new GreatLibrary(), rom, length, true));
+  clocktroller = unique_ptr<Clocktroller>(new Clocktroller(turbo_screen.get(), format, frame_buffers));
+  clocktroller->Init(rom, length);
 }
 
 void TurboSanta::handleInput(unsigned char inputMap) {
@@ -39,12 +35,25 @@ void TurboSanta::handleInput(unsigned char inputMap) {
 }
 
 void TurboSanta::launch() {
-  clocktroller->Start();
+  clocktroller->Run();
+}
+
+int TurboSanta::saveStateSize() {
+  return clocktroller->SaveStateSize();
+}
+
+int TurboSanta::saveState(unsigned char* state, int length) {
+  return clocktroller->SaveState(state, length);
+}
+
+bool TurboSanta::loadState(const unsigned char* state, int length) {
+  return clocktroller->LoadState(state, length);
 }
 
 void TurboSanta::stop() {
   if (clocktroller != nullptr) {
-    clocktroller->Terminate();
+    clocktroller->Kill();
+    clocktroller->Wait();
   }
 }
 
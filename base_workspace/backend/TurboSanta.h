@@ -4,25 +4,34 @@
 #include <functional>
 #include <memory>
 
+#include "backend/graphics/screen.h"
+
 namespace back_end {
 namespace clocktroller {
   class Clocktroller;
 }
 }
-namespace back_end {
-namespace graphics {
-  class Screen;
-}
-}
 
 class TurboSanta {
 	public:
     TurboSanta();
     ~TurboSanta();
-		void init(unsigned char* rom, int length, void(*videoCallback)(const signed char* bitmap, int length));
+    // videoCallback gets each frame in format, length bytes of it, and may
+    // only use it until it returns. The frames are drawn into frame_buffers,
+    // three buffers of ScreenRaster::FrameBytes(format) bytes, if given.
+		void init(unsigned char* rom, int length, void(*videoCallback)(const signed char* bitmap, int length),
+              back_end::graphics::PixelFormat format = back_end::graphics::SHADE8,
+              unsigned char* const* frame_buffers = nullptr);
 		void launch();
     void stop();
 		void handleInput(unsigned char inputMap);
+    // Save states of the whole machine, which can be made and loaded while
+    // running. saveState writes one into state and returns its length, or 0
+    // if it needs more than length bytes; see saveStateSize. loadState
+    // returns false if state is not one from this ROM.
+    int saveStateSize();
+    int saveState(unsigned char* state, int length);
+    bool loadState(const unsigned char* state, int length);
   private:
     std::unique_ptr<back_end::clocktroller::Clocktroller> clocktroller;
     std::unique_ptr<back_end::graphics::Screen> turbo_screen;
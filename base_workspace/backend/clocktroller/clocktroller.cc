@@ -1,5 +1,8 @@
 #include "backend/clocktroller/clocktroller.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "submodules/glog/src/glog/logging.h"
 
 namespace back_end {
@@ -9,9 +12,33 @@ using std::unique_ptr;
 using graphics::GraphicsController;
 using memory::MemoryMapper;
 using handlers::OpcodeExecutor;
+using memory::StateReader;
+using memory::StateWriter;
+
+namespace {
+// A save state starts with kStateMagic, the version, the size of the whole
+// state and the id of the ROM, so that a state that does not belong is turned
+// away before any of it is loaded. Everything else is the machine, in the
+// order Clocktroller::WriteState writes it. The version goes up whenever that
+// changes.
+const unsigned char kStateMagic[] = {'T', 'S', 'S', 'T'};
+const unsigned short kStateVersion = 1;
+const size_t kStateSizeOffset = sizeof(kStateMagic) + 2;
+const size_t kStateHeaderSize = kStateSizeOffset + 4 + 4;
 
-void Clocktroller::Init(unsigned char* rom, long length) {
+// FNV-1a over all of the ROM.
+unsigned long ROMId(const memory::ROMImage& rom) {
+  unsigned long hash = 0x811c9dc5;
+  for (long i = 0; i < rom.size(); i++) {
+    hash = ((hash ^ rom.data()[i]) * 0x01000193) & 0xffffffff;
+  }
+  return hash;
+}
+} // namespace
+
+void Clocktroller::Init(std::shared_ptr<const memory::ROMImage> rom, handlers::ExecutionMode mode) {
   unique_ptr<MemoryMapper> memory_mapper = unique_ptr<MemoryMapper>(new MemoryMapper());
+  rom_id_ = ROMId(*rom);
 
   unimplemented_module_.Init();
   memory_mapper->RegisterModule(unimplemented_module_);
@@ -22,32 +49,71 @@ void Clocktroller::Init(unsigned char* rom, long length) {
   default_module_.Init();
   memory_mapper->RegisterModule(default_module_);
 
-  dma_transfer_module_.Init(memory_mapper.get());
-  memory_mapper->RegisterModule(dma_transfer_module_);
-
-  mbc_.Init(rom, length);
+  mbc_.Init(rom);
   memory_mapper->RegisterModule(mbc_);
 
-  graphics_controller_ = unique_ptr<GraphicsController>(new GraphicsController(screen_, &primary_flags_));
+  graphics_controller_ = unique_ptr<GraphicsController>(new GraphicsController(&frame_exchange_, &primary_flags_, &scheduler_));
+  graphics_controller_->set_render_every(render_every_);
+  graphics_controller_->set_frame_hashing(frame_hashing_);
   graphics_controller_->Init();
   memory_mapper->RegisterModule(*graphics_controller_);
 
+  dma_transfer_module_.Init(memory_mapper.get(), graphics_controller_->oam_segment(), &scheduler_);
+  memory_mapper->RegisterModule(dma_transfer_module_);
+
   opcode_executor_ = unique_ptr<OpcodeExecutor>(new OpcodeExecutor(std::move(memory_mapper), &primary_flags_));
+  opcode_executor_->set_cycle_listener(this);
+  opcode_executor_->set_execution_mode(mode);
+}
+
+void Clocktroller::set_render_every(int render_every) {
+  render_every_ = render_every;
+  if (graphics_controller_ != nullptr) {
+    graphics_controller_->set_render_every(render_every);
+  }
+}
+
+void Clocktroller::set_frame_hashing(bool frame_hashing) {
+  frame_hashing_ = frame_hashing;
+  if (graphics_controller_ != nullptr) {
+    graphics_controller_->set_frame_hashing(frame_hashing);
+  }
 }
 
 void Clocktroller::Run() {
   is_paused_ = false;
   is_dead_ = false;
   if (!is_running_) {
+    frame_presenter_.Start();
     thread_ = std::thread([this]() { this->ExecutionLoop(); });
   }
   is_running_ = true;
 }
 
+void Clocktroller::Wait() {
+  thread_.join();
+  frame_presenter_.Stop();
+  LOG(INFO) << "Frames: " << frame_exchange_.published_frames() << " published, "
+            << frame_exchange_.dropped_frames() << " dropped, "
+            << frame_exchange_.duplicated_frames() << " duplicated.";
+}
+
 void Clocktroller::ExecutionLoop() {
+  // parked_ is cleared and is_paused_ looked at again before running on, so
+  // nothing runs once a pause has seen parked_ set.
+  bool parked = true;
   for (;;) {
-    if (!is_paused_) {
+    if (is_paused_) {
+      if (!parked) {
+        parked = true;
+        parked_ = true;
+      }
+    } else if (parked) {
+      parked = false;
+      parked_ = false;
+    } else {
       if (is_dead_) {
+        parked_ = true;
         return;
       }
       int ticks = opcode_executor_->ReadInstruction();
@@ -55,11 +121,170 @@ void Clocktroller::ExecutionLoop() {
         LOG(ERROR) << "Clock clock cycles were negative.";
         is_dead_ = true;
       } else {
-        graphics_controller_->Tick(ticks);
+        scheduler_.Advance(ticks);
+        SkipIdleCycles();
       }
     }
   }
 }
 
+bool Clocktroller::PauseBetweenInstructions() {
+  bool was_paused = is_paused_.exchange(true);
+  while (!parked_) {
+    std::this_thread::yield();
+  }
+  return was_paused;
+}
+
+size_t Clocktroller::SaveStateSize() {
+  bool was_paused = PauseBetweenInstructions();
+  StateWriter counter;
+  WriteState(&counter);
+  is_paused_ = was_paused;
+  return counter.size();
+}
+
+size_t Clocktroller::SaveState(unsigned char* buffer, size_t size) {
+  bool was_paused = PauseBetweenInstructions();
+  StateWriter writer(buffer, size);
+  WriteState(&writer);
+  is_paused_ = was_paused;
+  if (!writer.fits()) {
+    return 0;
+  }
+  StateWriter size_field(buffer + kStateSizeOffset, 4);
+  size_field.Write32(writer.size());
+  return writer.size();
+}
+
+std::vector<unsigned char> Clocktroller::SaveState() {
+  std::vector<unsigned char> state(SaveStateSize());
+  state.resize(SaveState(state.data(), state.size()));
+  return state;
+}
+
+bool Clocktroller::LoadState(const unsigned char* state, size_t size) {
+  bool was_paused = PauseBetweenInstructions();
+  bool loaded = ReadState(state, size);
+  is_paused_ = was_paused;
+  return loaded;
+}
+
+void Clocktroller::WriteState(StateWriter* writer) {
+  writer->WriteBytes(kStateMagic, sizeof(kStateMagic));
+  writer->Write16(kStateVersion);
+  // The size, which is only known at the end.
+  writer->Write32(0);
+  writer->Write32(rom_id_);
+  writer->Write64(scheduler_.now());
+  opcode_executor_->SaveState(writer);
+  graphics_controller_->SaveState(writer);
+}
+
+bool Clocktroller::ReadState(const unsigned char* state, size_t size) {
+  if (size < kStateHeaderSize || memcmp(state, kStateMagic, sizeof(kStateMagic)) != 0) {
+    LOG(ERROR) << "Not a save state.";
+    return false;
+  }
+  StateReader reader(state + sizeof(kStateMagic), size - sizeof(kStateMagic));
+  unsigned short version = reader.Read16();
+  if (version != kStateVersion) {
+    LOG(ERROR) << "Save state is version " << version << ", not " << kStateVersion << ".";
+    return false;
+  }
+  StateWriter counter;
+  WriteState(&counter);
+  unsigned long state_size = reader.Read32();
+  if (state_size != size || size != counter.size()) {
+    LOG(ERROR) << "Save state is " << size << " bytes, not " << counter.size() << ".";
+    return false;
+  }
+  if (reader.Read32() != rom_id_) {
+    LOG(ERROR) << "Save state is from another ROM.";
+    return false;
+  }
+
+  // Events are dropped and scheduled again by whatever they belong to.
+  uint64_t now = reader.Read64();
+  scheduler_.Reset(now);
+  opcode_executor_->LoadState(&reader);
+  graphics_controller_->LoadState(&reader);
+
+  // Nothing is known about what the CPU is doing any more.
+  polling_loop_ = PollingLoop();
+  last_pc_ = opcode_executor_->pc();
+  idle_cycles_ = IdleCycles();
+  frame_end_ = (now / graphics::kLargePeriod + 1) * graphics::kLargePeriod;
+  return true;
+}
+
+void Clocktroller::SkipIdleCycles() {
+  if (opcode_executor_->WaitingForInterrupt()) {
+    // HALT runs every kHaltCycles until an interrupt is requested, so it would
+    // see the next event at the first of those on or after it.
+    const uint64_t kHaltCycles = 4;
+    uint64_t now = scheduler_.now();
+    uint64_t next_event = scheduler_.next_event();
+    if (next_event != Scheduler::kNever && next_event > now) {
+      uint64_t cycles = (next_event - now + kHaltCycles - 1) / kHaltCycles * kHaltCycles;
+      idle_cycles_.halted += cycles;
+      scheduler_.Advance(cycles);
+    }
+  } else {
+    SkipPollingLoop();
+  }
+  CountFrames();
+}
+
+// A loop is skipped once the CPU has been round it in exactly the cycles it
+// takes, so it went straight round, and nothing it reads changed on the way.
+// Every time round from then on is the same until the horizon, so the clock
+// is moved on by as many whole times round as fit before it. Builds with the
+// threaded interpreter seldom stop at the top of the loop, so seldom skip.
+void Clocktroller::SkipPollingLoop() {
+  const unsigned short kMaxPollingLoopBytes = 16;
+  unsigned short pc = opcode_executor_->pc();
+  unsigned short last_pc = last_pc_;
+  last_pc_ = pc;
+  if (pc == polling_loop_.head) {
+    if (polling_loop_.cycles == 0) {
+      return;
+    }
+    uint64_t now = scheduler_.now();
+    if (now - polling_loop_.started == static_cast<uint64_t>(polling_loop_.cycles) &&
+        polling_loop_.horizon > now) {
+      uint64_t cycles = (polling_loop_.horizon - now) / polling_loop_.cycles * polling_loop_.cycles;
+      idle_cycles_.polling += cycles;
+      scheduler_.Advance(cycles);
+    } else {
+      // Whatever the CPU was doing, the loop may not be the same loop now.
+      polling_loop_.cycles = opcode_executor_->PollingLoopCycles();
+    }
+  } else if (pc <= last_pc && last_pc - pc <= kMaxPollingLoopBytes) {
+    // Jumped back a short way, which is where polling loops start.
+    polling_loop_.head = pc;
+    polling_loop_.cycles = opcode_executor_->PollingLoopCycles();
+  } else {
+    return;
+  }
+  polling_loop_.started = scheduler_.now();
+  polling_loop_.horizon = NextChange();
+}
+
+uint64_t Clocktroller::NextChange() {
+  return std::min(scheduler_.next_event(), graphics_controller_->next_change());
+}
+
+void Clocktroller::CountFrames() {
+  uint64_t now = scheduler_.now();
+  if (now < frame_end_) {
+    return;
+  }
+  last_frame_halted_cycles_ = idle_cycles_.halted;
+  last_frame_polling_cycles_ = idle_cycles_.polling;
+  idle_cycles_ = IdleCycles();
+  frame_end_ = (now / graphics::kLargePeriod + 1) * graphics::kLargePeriod;
+}
+
 } // namespace clocktroller
 } // namespace back_end
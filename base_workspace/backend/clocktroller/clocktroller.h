@@ -4,6 +4,10 @@
 #include <atomic>
 #include <memory>
 #include <thread>
+#include <vector>
+#include "backend/clocktroller/scheduler.h"
+#include "backend/graphics/frame_exchange.h"
+#include "backend/graphics/frame_presenter.h"
 #include "backend/graphics/graphics_controller.h"
 #include "backend/graphics/screen.h"
 #include "backend/opcode_executor/opcode_executor.h"
@@ -12,35 +16,139 @@
 #include "backend/memory/mbc_module.h"
 #include "backend/memory/memory_mapper.h"
 #include "backend/memory/primary_flags.h"
+#include "backend/memory/rom_image.h"
+#include "backend/memory/save_state.h"
 #include "backend/memory/unimplemented_module.h"
 
 namespace back_end {
 namespace clocktroller {
 
-class Clocktroller {
+class SaveStateTest;
+
+// Cycles that were skipped over rather than run, because the CPU had nothing
+// to do until the next event: it was waiting in HALT, or going round a loop
+// that only polls memory.
+struct IdleCycles {
+  unsigned long halted = 0;
+  unsigned long polling = 0;
+};
+
+class Clocktroller : public handlers::CycleListener {
  public:
-  Clocktroller(graphics::Screen* screen) : screen_(screen) {}
-  void Init(unsigned char* rom, long length);
+  // Frames are drawn on screen from a thread of its own while running, in
+  // format and, if given, straight into the three frame_buffers; see
+  // FrameExchange.
+  Clocktroller(graphics::Screen* screen,
+               graphics::PixelFormat format = graphics::SHADE8,
+               unsigned char* const* frame_buffers = nullptr) :
+      screen_(screen), frame_exchange_(format, frame_buffers), frame_presenter_(&frame_exchange_, screen) {}
+  void Init(std::shared_ptr<const memory::ROMImage> rom, handlers::ExecutionMode mode = handlers::INTERPRETER);
+  void Init(unsigned char* rom, long length, handlers::ExecutionMode mode = handlers::INTERPRETER) {
+    Init(memory::ROMImage::Copy(rom, length), mode);
+  }
   void Run();
   void Pause() { is_paused_ = true; }
   void Kill() { is_dead_ = true; }
-  void Wait() { thread_.join(); }
+  void Wait();
+
+  // See GraphicsController::set_render_every. Draws every frame by default,
+  // and 0 runs headless.
+  void set_render_every(int render_every);
+
+  // See GraphicsController::set_frame_hashing.
+  void set_frame_hashing(bool frame_hashing);
+  unsigned long long last_frame_hash() const {
+    return graphics_controller_ == nullptr ? 0 : graphics_controller_->last_frame_hash();
+  }
+
+  // Keeps the clock in step with each instruction of a compiled block.
+  virtual void OnCycles(int cycles) { scheduler_.Advance(cycles); }
+
+  // Counts frames passed to the screen, and dropped or shown twice on the way;
+  // safe to call while running.
+  const graphics::FrameExchange& frame_exchange() const { return frame_exchange_; }
+
+  // Cycles skipped during the last whole frame; safe to call while running.
+  IdleCycles last_frame_idle_cycles() {
+    IdleCycles idle_cycles;
+    idle_cycles.halted = last_frame_halted_cycles_;
+    idle_cycles.polling = last_frame_polling_cycles_;
+    return idle_cycles;
+  }
+
+  // Save states hold the whole machine but the ROM, and only load into a
+  // Clocktroller running the same ROM. All of these are safe to call while
+  // running; the machine is paused between instructions while they run.
+
+  // The size of a save state, which stays the same for as long as the ROM
+  // does.
+  size_t SaveStateSize();
+  // Writes a save state into buffer without allocating and returns its size,
+  // or 0 if it needs more than size bytes.
+  size_t SaveState(unsigned char* buffer, size_t size);
+  std::vector<unsigned char> SaveState();
+  // Returns false, having changed nothing, if state was not saved by this
+  // version from the same ROM.
+  bool LoadState(const unsigned char* state, size_t size);
 
  private:
+  // A loop the CPU may be polling in; see OpcodeExecutor::PollingLoopCycles.
+  struct PollingLoop {
+    unsigned short head = 0;
+    // 0 if the loop at head does more than poll.
+    int cycles = 0;
+    // When the CPU was last at head, and the first cycle after that anything
+    // the loop reads could have changed.
+    uint64_t started = 0;
+    uint64_t horizon = 0;
+  };
+
+
+  Scheduler scheduler_;
   memory::PrimaryFlags primary_flags_;
   memory::DefaultModule default_module_;
   memory::MBCModule mbc_;
   memory::DMATransferModule dma_transfer_module_;
   memory::UnimplementedModule unimplemented_module_;
   graphics::Screen* screen_;
+  graphics::FrameExchange frame_exchange_;
+  graphics::FramePresenter frame_presenter_;
   std::unique_ptr<handlers::OpcodeExecutor> opcode_executor_;
   std::unique_ptr<graphics::GraphicsController> graphics_controller_;
-  bool is_running_;
-  std::atomic<bool> is_paused_;
-  std::atomic<bool> is_dead_;
+  int render_every_ = 1;
+  bool frame_hashing_ = false;
+  bool is_running_ = false;
+  std::atomic<bool> is_paused_{false};
+  std::atomic<bool> is_dead_{false};
+  // Set while the execution loop is between instructions and will stay there
+  // until unpaused; see PauseBetweenInstructions.
+  std::atomic<bool> parked_{true};
   std::thread thread_;
+  // Tells save states from other ROMs apart.
+  unsigned long rom_id_ = 0;
+  PollingLoop polling_loop_;
+  unsigned short last_pc_ = 0;
+  IdleCycles idle_cycles_;
+  uint64_t frame_end_ = graphics::kLargePeriod;
+  std::atomic<unsigned long> last_frame_halted_cycles_{0};
+  std::atomic<unsigned long> last_frame_polling_cycles_{0};
 
   void ExecutionLoop();
+  // Pauses and waits until no instruction is running, returning whether it
+  // was paused already.
+  bool PauseBetweenInstructions();
+  void WriteState(memory::StateWriter* writer);
+  bool ReadState(const unsigned char* state, size_t size);
+  // Moves the clock past whatever the CPU would spend doing nothing.
+  void SkipIdleCycles();
+  void SkipPollingLoop();
+  // The first cycle after now at which an interrupt could be requested or LY
+  // or STAT could change.
+  uint64_t NextChange();
+  // Rolls the idle cycle counts over when a frame has passed.
+  void CountFrames();
+
+  friend class SaveStateTest;
 };
 
 } // namespace clocktroller
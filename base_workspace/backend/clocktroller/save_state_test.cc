@@ -0,0 +1,258 @@
+#include "backend/clocktroller/clocktroller.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "backend/clocktroller/scheduler.h"
+#include "backend/graphics/screen.h"
+#include "submodules/googletest/include/gtest/gtest.h"
+
+namespace back_end {
+namespace clocktroller {
+
+using std::pair;
+using std::unique_ptr;
+using std::vector;
+
+namespace {
+
+// The logo the boot ROM checks the cartridge header for.
+const unsigned char kLogo[] = {
+  0xce, 0xed, 0x66, 0x66, 0xcc, 0x0d, 0x00, 0x0b, 0x03, 0x73, 0x00, 0x83, 0x00, 0x0c, 0x00, 0x0d,
+  0x00, 0x08, 0x11, 0x1f, 0x88, 0x89, 0x00, 0x0e, 0xdc, 0xcc, 0x6e, 0xe6, 0xdd, 0xdd, 0xd9, 0x99,
+  0xbb, 0xbb, 0x67, 0x63, 0x6e, 0x0e, 0xec, 0xcc, 0xdd, 0xdc, 0x99, 0x9f, 0xbb, 0xb9, 0x33, 0x3e,
+};
+
+void Put(vector<unsigned char>* rom, unsigned short address, const vector<unsigned char>& bytes) {
+  std::copy(bytes.begin(), bytes.end(), rom->begin() + address);
+}
+
+// A 32KB ROM without an MBC that keeps the LCD, its interrupts and DMA busy:
+// it writes VRAM and a counter as fast as it can, HALTs now and then, copies
+// OAM from C100 at each V-Blank and records LY at each STAT interrupt. The
+// handlers go back to the top of the main loop rather than returning, since
+// interrupts do not push PC here yet.
+vector<unsigned char> TestROM() {
+  vector<unsigned char> rom(0x8000, 0x00);
+  Put(&rom, 0x0040, {0xc3, 0x00, 0x02});         // JP 0200
+  Put(&rom, 0x0048, {0xf0, 0x44,                 // LDH A,(LY)
+                     0xea, 0x03, 0xc0,           // LD (C003),A
+                     0xfb,                       // EI
+                     0xc3, 0x71, 0x01});         // JP main
+  Put(&rom, 0x0100, {0x00, 0xc3, 0x50, 0x01});   // NOP; JP 0150
+  Put(&rom, 0x0104, vector<unsigned char>(kLogo, kLogo + sizeof(kLogo)));
+  Put(&rom, 0x0150, {0x31, 0xfe, 0xff,           // LD SP,FFFE
+                     0x21, 0x00, 0x03,           // LD HL,0300
+                     0x0e, 0x80,                 // LD C,80
+                     0x06, 0x0a,                 // LD B,0A
+                     0x2a, 0xe2, 0x0c, 0x05,     // copy: LD A,(HL+); LD (C),A; INC C; DEC B
+                     0x20, 0xfa,                 // JR NZ,copy
+                     0x3e, 0x03, 0xe0, 0xff,     // IE = V-Blank | STAT
+                     0x3e, 0x68, 0xe0, 0x41,     // STAT: LYC, OAM and H-Blank interrupts
+                     0x3e, 0x40, 0xe0, 0x45,     // LYC = 40
+                     0x3e, 0x93, 0xe0, 0x40,     // LCDC
+                     0xfb,                       // EI
+                     0xfa, 0x00, 0xc0,           // main (0171): LD A,(C000)
+                     0x3c,                       // INC A
+                     0xea, 0x00, 0xc0,           // LD (C000),A
+                     0x47,                       // LD B,A
+                     0x26, 0x80, 0x68, 0x77,     // LD H,80; LD L,B; LD (HL),A
+                     0x26, 0xc1, 0x77,           // LD H,C1; LD (HL),A
+                     0xe6, 0x1f,                 // AND 1F
+                     0x20, 0xed,                 // JR NZ,main
+                     0x76,                       // HALT
+                     0x18, 0xea});               // JR main
+  Put(&rom, 0x0200, {0xcd, 0x80, 0xff,           // CALL FF80
+                     0xfa, 0x04, 0xc0,           // LD A,(C004)
+                     0x3c,                       // INC A
+                     0xea, 0x04, 0xc0,           // LD (C004),A
+                     0xfb,                       // EI
+                     0xc3, 0x71, 0x01});         // JP main
+  // Copied to FF80, since only high RAM can be run from during DMA. Waits
+  // well past the end of the transfer, however long the loop takes.
+  Put(&rom, 0x0300, {0x3e, 0xc1, 0xe0, 0x46,     // LD A,C1; LDH (DMA),A
+                     0x3e, 0x40,                 // LD A,40
+                     0x3d, 0x20, 0xfd,           // wait: DEC A; JR NZ,wait
+                     0xc9});                     // RET
+  // The header checksum the boot ROM checks as well.
+  unsigned char sum = 0x19;
+  for (int address = 0x0134; address < 0x014d; address++) {
+    sum += rom[address];
+  }
+  rom[0x014d] = -sum;
+  return rom;
+}
+
+class NullScreen : public graphics::Screen {
+ public:
+  virtual void Draw(const graphics::ScreenRaster&) {}
+};
+
+} // namespace
+
+class SaveStateTest : public ::testing::Test {
+ protected:
+  SaveStateTest() : rom_(TestROM()) {}
+
+  unique_ptr<Clocktroller> NewClocktroller(const vector<unsigned char>& rom) {
+    unique_ptr<Clocktroller> clocktroller(new Clocktroller(&screen_));
+    clocktroller->set_frame_hashing(true);
+    clocktroller->Init(const_cast<unsigned char*>(rom.data()), rom.size());
+    return clocktroller;
+  }
+
+  unique_ptr<Clocktroller> NewClocktroller() { return NewClocktroller(rom_); }
+
+  // Runs instructions the way the execution loop does, without a thread of
+  // its own, until the clock reaches cycle.
+  void RunTo(Clocktroller* clocktroller, uint64_t cycle) {
+    while (clocktroller->scheduler_.now() < cycle) {
+      Step(clocktroller);
+    }
+  }
+
+  void Step(Clocktroller* clocktroller) {
+    int ticks = clocktroller->opcode_executor_->ReadInstruction();
+    ASSERT_GE(ticks, 0);
+    clocktroller->scheduler_.Advance(ticks);
+    clocktroller->SkipIdleCycles();
+  }
+
+  // Runs until a DMA transfer is under way, which is the only time anything
+  // but the LCD has an event.
+  void RunToDMA(Clocktroller* clocktroller) {
+    while (Events(clocktroller).size() < 2) {
+      Step(clocktroller);
+    }
+  }
+
+  // What a save state should bring back, looked at apart from the state
+  // itself where it can be.
+  struct Machine {
+    vector<unsigned char> state;
+    uint64_t now;
+    vector<pair<uint64_t, TimedEvent*>> events;
+    unsigned short pc;
+    uint64_t next_lcd_change;
+    unsigned long long frame_hash;
+
+    bool operator==(const Machine& other) const {
+      return state == other.state && now == other.now && events == other.events && pc == other.pc &&
+             next_lcd_change == other.next_lcd_change && frame_hash == other.frame_hash;
+    }
+  };
+
+  Machine Look(Clocktroller* clocktroller) {
+    Machine machine;
+    // First, since it catches the LCD up, which the state would show.
+    machine.next_lcd_change = clocktroller->graphics_controller_->next_change();
+    machine.state = clocktroller->SaveState();
+    machine.now = clocktroller->scheduler_.now();
+    machine.events = Events(clocktroller);
+    machine.pc = clocktroller->opcode_executor_->pc();
+    machine.frame_hash = clocktroller->last_frame_hash();
+    return machine;
+  }
+
+  // The events still to fire, in the order they will.
+  vector<pair<uint64_t, TimedEvent*>> Events(Clocktroller* clocktroller) {
+    vector<Scheduler::Entry> entries = clocktroller->scheduler_.heap_;
+    std::sort(entries.begin(), entries.end(), [](const Scheduler::Entry& left, const Scheduler::Entry& right) {
+      return Scheduler::Later(right, left);
+    });
+    vector<pair<uint64_t, TimedEvent*>> events;
+    for (const Scheduler::Entry& entry : entries) {
+      events.push_back({entry.cycle, entry.event});
+    }
+    return events;
+  }
+
+  NullScreen screen_;
+  vector<unsigned char> rom_;
+};
+
+// Far enough for the boot ROM to have handed over to the cartridge.
+const uint64_t kBooted = 22000000;
+// A few frames.
+const uint64_t kRunOn = 300000;
+
+TEST_F(SaveStateTest, SizeMatchesTheStateSaved) {
+  unique_ptr<Clocktroller> clocktroller = NewClocktroller();
+  RunTo(clocktroller.get(), kBooted);
+  size_t size = clocktroller->SaveStateSize();
+  EXPECT_EQ(size, clocktroller->SaveState().size());
+
+  vector<unsigned char> buffer(size);
+  EXPECT_EQ(0u, clocktroller->SaveState(buffer.data(), size - 1));
+  EXPECT_EQ(size, clocktroller->SaveState(buffer.data(), size));
+  EXPECT_EQ(clocktroller->SaveState(), buffer);
+  EXPECT_TRUE(clocktroller->LoadState(buffer.data(), buffer.size()));
+}
+
+TEST_F(SaveStateTest, TurnsAwayStatesThatDoNotBelong) {
+  unique_ptr<Clocktroller> clocktroller = NewClocktroller();
+  RunTo(clocktroller.get(), kBooted);
+  vector<unsigned char> state = clocktroller->SaveState();
+  RunToDMA(clocktroller.get());
+  Machine before = Look(clocktroller.get());
+
+  vector<unsigned char> bad_magic = state;
+  bad_magic[0] = 'X';
+  EXPECT_FALSE(clocktroller->LoadState(bad_magic.data(), bad_magic.size()));
+  vector<unsigned char> bad_version = state;
+  bad_version[4]++;
+  EXPECT_FALSE(clocktroller->LoadState(bad_version.data(), bad_version.size()));
+  EXPECT_FALSE(clocktroller->LoadState(state.data(), state.size() - 1));
+  EXPECT_FALSE(clocktroller->LoadState(state.data(), 3));
+  vector<unsigned char> longer = state;
+  longer.push_back(0);
+  EXPECT_FALSE(clocktroller->LoadState(longer.data(), longer.size()));
+
+  vector<unsigned char> other_rom = rom_;
+  other_rom[0x7fff] ^= 1;
+  unique_ptr<Clocktroller> other = NewClocktroller(other_rom);
+  EXPECT_FALSE(other->LoadState(state.data(), state.size()));
+
+  // None of which changed anything.
+  EXPECT_TRUE(Look(clocktroller.get()) == before);
+}
+
+TEST_F(SaveStateTest, LoadingPutsTheMachineBackAsSaved) {
+  unique_ptr<Clocktroller> clocktroller = NewClocktroller();
+  RunTo(clocktroller.get(), kBooted);
+  RunToDMA(clocktroller.get());
+  Machine saved = Look(clocktroller.get());
+  ASSERT_EQ(2u, saved.events.size());
+
+  RunTo(clocktroller.get(), saved.now + kRunOn);
+  Machine ran_on = Look(clocktroller.get());
+  ASSERT_NE(saved.state, ran_on.state);
+
+  ASSERT_TRUE(clocktroller->LoadState(saved.state.data(), saved.state.size()));
+  // The frame hash is only worked out at each V-Blank, so it is as of the
+  // last one rather than the one before saving.
+  Machine loaded = Look(clocktroller.get());
+  loaded.frame_hash = saved.frame_hash;
+  EXPECT_TRUE(loaded == saved);
+
+  // Running on from there comes out the same, as it does in a machine that
+  // had run something else before loading.
+  RunTo(clocktroller.get(), saved.now + kRunOn);
+  EXPECT_TRUE(Look(clocktroller.get()) == ran_on);
+
+  unique_ptr<Clocktroller> other = NewClocktroller();
+  RunTo(other.get(), kBooted / 2);
+  ASSERT_TRUE(other->LoadState(saved.state.data(), saved.state.size()));
+  RunTo(other.get(), saved.now + kRunOn);
+  Machine other_ran_on = Look(other.get());
+  EXPECT_EQ(ran_on.state, other_ran_on.state);
+  EXPECT_EQ(ran_on.now, other_ran_on.now);
+  EXPECT_EQ(ran_on.pc, other_ran_on.pc);
+  EXPECT_EQ(ran_on.frame_hash, other_ran_on.frame_hash);
+  EXPECT_EQ(ran_on.events.size(), other_ran_on.events.size());
+}
+
+} // namespace clocktroller
+} // namespace back_end
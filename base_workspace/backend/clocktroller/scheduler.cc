@@ -0,0 +1,50 @@
+#include "backend/clocktroller/scheduler.h"
+
+#include <algorithm>
+
+namespace back_end {
+namespace clocktroller {
+
+const uint64_t Scheduler::kNever;
+
+void Scheduler::Schedule(TimedEvent* event, uint64_t cycle) {
+  Remove(event);
+  heap_.push_back({cycle, sequence_++, event});
+  std::push_heap(heap_.begin(), heap_.end(), Later);
+}
+
+void Scheduler::Cancel(TimedEvent* event) {
+  Remove(event);
+}
+
+void Scheduler::FireDueEvents() {
+  while (!heap_.empty() && heap_.front().cycle <= now_) {
+    std::pop_heap(heap_.begin(), heap_.end(), Later);
+    Entry due = heap_.back();
+    heap_.pop_back();
+    due.event->Fire(due.cycle);
+  }
+}
+
+// There are only ever a handful of events, so finding one is a short scan.
+void Scheduler::Remove(TimedEvent* event) {
+  for (auto entry = heap_.begin(); entry != heap_.end(); ++entry) {
+    if (entry->event == event) {
+      heap_.erase(entry);
+      std::make_heap(heap_.begin(), heap_.end(), Later);
+      return;
+    }
+  }
+}
+
+// std::push_heap and friends build a max-heap, so the earliest entry has to
+// compare as the greatest.
+bool Scheduler::Later(const Entry& left, const Entry& right) {
+  if (left.cycle != right.cycle) {
+    return left.cycle > right.cycle;
+  }
+  return left.sequence > right.sequence;
+}
+
+} // namespace clocktroller
+} // namespace back_end
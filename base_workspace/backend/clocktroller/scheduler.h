@@ -0,0 +1,84 @@
+#ifndef TURBO_SANTA_COMMON_BACK_END_CLOCKTROLLER_SCHEDULER_H_
+#define TURBO_SANTA_COMMON_BACK_END_CLOCKTROLLER_SCHEDULER_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace back_end {
+namespace clocktroller {
+
+class SaveStateTest;
+
+// Something timed hardware does at a known cycle, e.g. the PPU changing mode.
+class TimedEvent {
+ public:
+  // Called once the clock has reached the cycle the event was scheduled for.
+  // cycle is that cycle, which the clock may have passed by part of an
+  // instruction. The event may schedule itself or others again.
+  virtual void Fire(uint64_t cycle) = 0;
+};
+
+// Keeps the clock for the whole machine and a min-heap of the events that are
+// due. The CPU tells it how many cycles each instruction took, which costs an
+// add and a compare until the next event is due; peripherals are only run at
+// the cycles they asked for rather than polled after every instruction.
+//
+// Timed hardware is added by implementing TimedEvent and scheduling it here,
+// the way GraphicsController drives the PPU modes.
+//
+// Cycles are counted from power on in 64 bits whatever the target, since 32
+// would wrap after about 17 minutes.
+class Scheduler {
+ public:
+  static const uint64_t kNever = ~static_cast<uint64_t>(0);
+
+  uint64_t now() const { return now_; }
+
+  // The cycle the earliest event is due at, or kNever.
+  uint64_t next_event() const { return heap_.empty() ? kNever : heap_.front().cycle; }
+
+  // Fires event at cycle, or as soon as the clock next moves if cycle has
+  // passed. An event is only ever scheduled once; scheduling it again moves
+  // it. Events due at the same cycle fire in the order they were scheduled.
+  void Schedule(TimedEvent* event, uint64_t cycle);
+
+  void ScheduleIn(TimedEvent* event, uint64_t cycles) { Schedule(event, now_ + cycles); }
+
+  void Cancel(TimedEvent* event);
+
+  // Drops every event and sets the clock to now, as when a save state is
+  // loaded; whatever had an event schedules it again as it is loaded.
+  void Reset(uint64_t now) {
+    now_ = now;
+    heap_.clear();
+  }
+
+  // Moves the clock forward, firing everything that comes due on the way.
+  void Advance(int cycles) {
+    now_ += cycles;
+    if (now_ >= next_event()) {
+      FireDueEvents();
+    }
+  }
+
+ private:
+  struct Entry {
+    uint64_t cycle;
+    uint64_t sequence;
+    TimedEvent* event;
+  };
+
+  void FireDueEvents();
+  void Remove(TimedEvent* event);
+  static bool Later(const Entry& left, const Entry& right);
+
+  uint64_t now_ = 0;
+  uint64_t sequence_ = 0;
+  std::vector<Entry> heap_;
+
+  friend class SaveStateTest;
+};
+
+} // namespace clocktroller
+} // namespace back_end
+#endif // TURBO_SANTA_COMMON_BACK_END_CLOCKTROLLER_SCHEDULER_H_
@@ -0,0 +1,183 @@
+#include "backend/clocktroller/scheduler.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "submodules/googletest/include/gtest/gtest.h"
+
+namespace back_end {
+namespace clocktroller {
+
+using std::pair;
+using std::vector;
+
+namespace {
+
+typedef vector<pair<int, uint64_t>> FireLog;
+
+// Notes its id and the cycle it was fired with, and optionally schedules
+// itself again period cycles after that.
+class LoggingEvent : public TimedEvent {
+ public:
+  LoggingEvent(int id, FireLog* log, Scheduler* scheduler = nullptr, uint64_t period = 0) :
+      id_(id), log_(log), scheduler_(scheduler), period_(period) {}
+
+  virtual void Fire(uint64_t cycle) {
+    log_->push_back({id_, cycle});
+    if (period_ > 0) {
+      scheduler_->Schedule(this, cycle + period_);
+    }
+  }
+
+ private:
+  int id_;
+  FireLog* log_;
+  Scheduler* scheduler_;
+  uint64_t period_;
+};
+
+} // namespace
+
+TEST(SchedulerTest, FiresInCycleOrder) {
+  Scheduler scheduler;
+  FireLog log;
+  LoggingEvent first(1, &log), second(2, &log), third(3, &log);
+  scheduler.Schedule(&third, 30);
+  scheduler.Schedule(&first, 10);
+  scheduler.Schedule(&second, 20);
+  EXPECT_EQ(10u, scheduler.next_event());
+
+  scheduler.Advance(9);
+  EXPECT_TRUE(log.empty());
+  scheduler.Advance(1);
+  EXPECT_EQ(FireLog({{1, 10}}), log);
+  EXPECT_EQ(20u, scheduler.next_event());
+
+  scheduler.Advance(100);
+  EXPECT_EQ(FireLog({{1, 10}, {2, 20}, {3, 30}}), log);
+  EXPECT_EQ(Scheduler::kNever, scheduler.next_event());
+}
+
+TEST(SchedulerTest, FiresWithTheCycleItWasDue) {
+  Scheduler scheduler;
+  FireLog log;
+  LoggingEvent event(1, &log);
+  scheduler.Schedule(&event, 5);
+  scheduler.Advance(8);
+  EXPECT_EQ(FireLog({{1, 5}}), log);
+  EXPECT_EQ(8u, scheduler.now());
+}
+
+TEST(SchedulerTest, SameCycleFiresInScheduleOrder) {
+  Scheduler scheduler;
+  FireLog log;
+  vector<LoggingEvent> events;
+  for (int id = 0; id < 8; id++) {
+    events.push_back(LoggingEvent(id, &log));
+  }
+  // Scheduled out of id order, with one moved to the back by scheduling it
+  // again.
+  const int kOrder[] = {5, 2, 7, 0, 3, 6, 1, 4};
+  for (int id : kOrder) {
+    scheduler.Schedule(&events[id], 100);
+  }
+  scheduler.Schedule(&events[2], 100);
+  scheduler.Advance(100);
+
+  FireLog expected;
+  for (int id : {5, 7, 0, 3, 6, 1, 4, 2}) {
+    expected.push_back({id, 100});
+  }
+  EXPECT_EQ(expected, log);
+}
+
+TEST(SchedulerTest, SchedulingAgainMovesTheEvent) {
+  Scheduler scheduler;
+  FireLog log;
+  LoggingEvent moved(1, &log), other(2, &log);
+  scheduler.Schedule(&moved, 10);
+  scheduler.Schedule(&other, 20);
+  scheduler.Schedule(&moved, 30);
+  scheduler.Advance(25);
+  EXPECT_EQ(FireLog({{2, 20}}), log);
+  scheduler.Advance(5);
+  EXPECT_EQ(FireLog({{2, 20}, {1, 30}}), log);
+
+  // Earlier works as well as later.
+  scheduler.Schedule(&moved, 100);
+  scheduler.Schedule(&moved, 40);
+  scheduler.Advance(10);
+  EXPECT_EQ(FireLog({{2, 20}, {1, 30}, {1, 40}}), log);
+  EXPECT_EQ(Scheduler::kNever, scheduler.next_event());
+}
+
+TEST(SchedulerTest, CancelledEventsDoNotFire) {
+  Scheduler scheduler;
+  FireLog log;
+  LoggingEvent cancelled(1, &log), kept(2, &log);
+  scheduler.Schedule(&cancelled, 10);
+  scheduler.Schedule(&kept, 20);
+  scheduler.Cancel(&cancelled);
+  EXPECT_EQ(20u, scheduler.next_event());
+  // Cancelling something that is not scheduled does nothing.
+  scheduler.Cancel(&cancelled);
+  scheduler.Advance(50);
+  EXPECT_EQ(FireLog({{2, 20}}), log);
+}
+
+TEST(SchedulerTest, PastCycleFiresOnTheNextAdvance) {
+  Scheduler scheduler;
+  FireLog log;
+  LoggingEvent event(1, &log);
+  scheduler.Advance(50);
+  scheduler.Schedule(&event, 10);
+  EXPECT_TRUE(log.empty());
+  scheduler.Advance(1);
+  EXPECT_EQ(FireLog({{1, 10}}), log);
+}
+
+TEST(SchedulerTest, EventsCanScheduleThemselvesAgain) {
+  Scheduler scheduler;
+  FireLog log;
+  LoggingEvent periodic(1, &log, &scheduler, 10);
+  scheduler.ScheduleIn(&periodic, 10);
+  // One long step fires every time the event came due on the way.
+  scheduler.Advance(35);
+  EXPECT_EQ(FireLog({{1, 10}, {1, 20}, {1, 30}}), log);
+  EXPECT_EQ(40u, scheduler.next_event());
+}
+
+TEST(SchedulerTest, ResetDropsEverything) {
+  Scheduler scheduler;
+  FireLog log;
+  LoggingEvent event(1, &log);
+  scheduler.Schedule(&event, 10);
+  scheduler.Reset(1000);
+  EXPECT_EQ(1000u, scheduler.now());
+  EXPECT_EQ(Scheduler::kNever, scheduler.next_event());
+  scheduler.Advance(100);
+  EXPECT_TRUE(log.empty());
+}
+
+TEST(SchedulerTest, CountsPast32Bits) {
+  const uint64_t kStart = 0xfffffff0ull;
+  Scheduler scheduler;
+  FireLog log;
+  LoggingEvent before(1, &log), after(2, &log);
+  scheduler.Reset(kStart);
+  scheduler.ScheduleIn(&after, 0x20);
+  scheduler.ScheduleIn(&before, 0x08);
+  EXPECT_EQ(kStart + 0x08, scheduler.next_event());
+
+  scheduler.Advance(0x10);
+  EXPECT_EQ(0x100000000ull, scheduler.now());
+  EXPECT_EQ(FireLog({{1, kStart + 0x08}}), log);
+  EXPECT_EQ(kStart + 0x20, scheduler.next_event());
+  EXPECT_LT(scheduler.next_event(), Scheduler::kNever);
+
+  scheduler.Advance(0x10);
+  EXPECT_EQ(FireLog({{1, kStart + 0x08}, {2, 0x100000010ull}}), log);
+}
+
+} // namespace clocktroller
+} // namespace back_end
@@ -2,6 +2,8 @@
 #include <string>
 #include <vector>
 
+#include "backend/opcode_executor/opcode_handlers.h"
+
 namespace back_end {
 namespace debugger {
 using std::vector;
@@ -41,6 +43,7 @@ std::string RegisterDelta::GetName() {
 
 vector<RegisterDelta> RegisterProducer::RetrieveDelta() {
   vector<RegisterDelta> deltas;
+  handlers::MaterializeFlags(current_cpu_);
 
   if (previous_cpu_.flag_struct.rA != current_cpu_->flag_struct.rA) {
     deltas.push_back({RegisterDelta::A, previous_cpu_.flag_struct.rA, current_cpu_->flag_struct.rA});
@@ -0,0 +1,83 @@
+#ifndef TURBO_SANTA_COMMON_BACK_END_GRAPHICS_FRAME_EXCHANGE_H_
+#define TURBO_SANTA_COMMON_BACK_END_GRAPHICS_FRAME_EXCHANGE_H_
+
+#include <atomic>
+
+#include "backend/graphics/screen.h"
+
+namespace back_end {
+namespace graphics {
+
+// Passes finished frames from the emulation thread to a frontend thread
+// through three buffers: the back one being drawn, the front one the frontend
+// is showing, and the middle one holding the newest frame between them. Each
+// side only ever swaps its own buffer with the middle one, with one atomic
+// exchange, so neither waits for the other. A frame the frontend never got to
+// before the next one is dropped; a frontend that takes a frame before there
+// is a new one gets the last one again.
+class FrameExchange {
+ public:
+  // Frames are drawn in format, into buffers if given: three buffers of
+  // ScreenRaster::FrameBytes(format) bytes that outlive this.
+  explicit FrameExchange(PixelFormat format = SHADE8, unsigned char* const* buffers = nullptr) :
+      frames_{ScreenRaster(format, Buffer(buffers, 0)),
+              ScreenRaster(format, Buffer(buffers, 1)),
+              ScreenRaster(format, Buffer(buffers, 2))} {}
+
+  // The frame being drawn. Only for the emulation thread.
+  ScreenRaster* back() { return &frames_[back_]; }
+
+  // Makes the back frame the newest one, and starts drawing on another.
+  void Publish() {
+    unsigned int middle = middle_.exchange(back_ | kNewFrame, std::memory_order_acq_rel);
+    if ((middle & kNewFrame) != 0) {
+      dropped_frames_++;
+    }
+    back_ = middle & ~kNewFrame;
+    published_frames_++;
+  }
+
+  // Whether a frame has been published since the frontend last took one.
+  bool has_new_frame() const {
+    return (middle_.load(std::memory_order_acquire) & kNewFrame) != 0;
+  }
+
+  // The newest frame, which stays as it is until the next call. Only for the
+  // frontend thread, which should call it once for each frame it shows: when
+  // there is no new frame it gets the last one again, which counts as
+  // duplicated.
+  const ScreenRaster& Take() {
+    if (!has_new_frame()) {
+      duplicated_frames_++;
+      return frames_[front_];
+    }
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & ~kNewFrame;
+    return frames_[front_];
+  }
+
+  // Safe to call from either thread.
+  unsigned long published_frames() const { return published_frames_; }
+  unsigned long dropped_frames() const { return dropped_frames_; }
+  unsigned long duplicated_frames() const { return duplicated_frames_; }
+
+ private:
+  // Set in middle_ alongside the index of the frame while it is new.
+  static const unsigned int kNewFrame = 0b100;
+
+  static unsigned char* Buffer(unsigned char* const* buffers, int index) {
+    return buffers == nullptr ? nullptr : buffers[index];
+  }
+
+  ScreenRaster frames_[3];
+  unsigned int back_ = 0;
+  std::atomic<unsigned int> middle_{1};
+  unsigned int front_ = 2;
+  std::atomic<unsigned long> published_frames_{0};
+  std::atomic<unsigned long> dropped_frames_{0};
+  std::atomic<unsigned long> duplicated_frames_{0};
+};
+
+} // namespace graphics
+} // namespace back_end
+
+#endif // TURBO_SANTA_COMMON_BACK_END_GRAPHICS_FRAME_EXCHANGE_H_
@@ -0,0 +1,45 @@
+#include "backend/graphics/frame_presenter.h"
+
+#include <chrono>
+
+namespace back_end {
+namespace graphics {
+
+void FramePresenter::Start() {
+  if (is_running_) {
+    return;
+  }
+  is_running_ = true;
+  thread_ = std::thread([this]() { this->PresentLoop(); });
+}
+
+void FramePresenter::Stop() {
+  is_running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void FramePresenter::Present() {
+  if (frame_exchange_->published_frames() > 0) {
+    screen_->Draw(frame_exchange_->Take());
+  }
+}
+
+void FramePresenter::PresentLoop() {
+  auto deadline = std::chrono::steady_clock::now();
+  while (is_running_) {
+    deadline += refresh_period_;
+    std::this_thread::sleep_until(deadline);
+    Present();
+    // A Screen that took longer than a period misses the deadlines it slept
+    // through, rather than drawing the same frame for each to catch up.
+    auto now = std::chrono::steady_clock::now();
+    if (now > deadline + refresh_period_) {
+      deadline = now;
+    }
+  }
+}
+
+} // namespace graphics
+} // namespace back_end
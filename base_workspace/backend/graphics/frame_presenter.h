@@ -0,0 +1,51 @@
+#ifndef TURBO_SANTA_COMMON_BACK_END_GRAPHICS_FRAME_PRESENTER_H_
+#define TURBO_SANTA_COMMON_BACK_END_GRAPHICS_FRAME_PRESENTER_H_
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "backend/graphics/frame_exchange.h"
+#include "backend/graphics/screen.h"
+
+namespace back_end {
+namespace graphics {
+
+// How long a Game Boy frame lasts: 70224 cycles at 4194304Hz.
+static const int kRefreshMicroseconds = 16743;
+
+// Draws the newest frame from a FrameExchange on a Screen once every refresh
+// period, on a thread of its own, so that a slow Screen costs frames rather
+// than holding up emulation. When no new frame came in time the last one is
+// drawn again, and counted as duplicated. Nothing is drawn before the first
+// frame is published.
+class FramePresenter {
+ public:
+  FramePresenter(FrameExchange* frame_exchange, Screen* screen,
+                 std::chrono::microseconds refresh_period = std::chrono::microseconds(kRefreshMicroseconds)) :
+      frame_exchange_(frame_exchange), screen_(screen), refresh_period_(refresh_period) {}
+  ~FramePresenter() { Stop(); }
+
+  void Start();
+  // Returns once the Screen is no longer being drawn on.
+  void Stop();
+
+  // What happens at each refresh deadline: draws the newest frame, or the
+  // last one again, if one has been published at all. Only to be called while
+  // not started, by something keeping time of its own.
+  void Present();
+
+ private:
+  void PresentLoop();
+
+  FrameExchange* frame_exchange_;
+  Screen* screen_;
+  std::chrono::microseconds refresh_period_;
+  std::atomic<bool> is_running_{false};
+  std::thread thread_;
+};
+
+} // namespace graphics
+} // namespace back_end
+
+#endif // TURBO_SANTA_COMMON_BACK_END_GRAPHICS_FRAME_PRESENTER_H_
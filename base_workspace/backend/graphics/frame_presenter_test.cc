@@ -0,0 +1,128 @@
+#include "backend/graphics/frame_presenter.h"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "backend/graphics/frame_exchange.h"
+#include "backend/graphics/screen.h"
+#include "submodules/googletest/include/gtest/gtest.h"
+
+namespace back_end {
+namespace graphics {
+
+using std::vector;
+
+namespace {
+
+// Marks each frame with its number in the first pixel, counting from 1.
+void PublishFrame(FrameExchange* frame_exchange, unsigned char number) {
+  frame_exchange->back()->Set(0, 0, number);
+  frame_exchange->Publish();
+}
+
+// Remembers the number of every frame drawn on it.
+class RecordingScreen : public Screen {
+ public:
+  virtual void Draw(const ScreenRaster& raster) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    drawn_.push_back(raster.Get(0, 0));
+  }
+
+  vector<unsigned char> drawn() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return drawn_;
+  }
+
+ private:
+  std::mutex mutex_;
+  vector<unsigned char> drawn_;
+};
+
+} // namespace
+
+TEST(FrameExchangeTest, CountsDroppedAndDuplicatedFrames) {
+  FrameExchange frame_exchange;
+  PublishFrame(&frame_exchange, 1);
+  EXPECT_TRUE(frame_exchange.has_new_frame());
+  EXPECT_EQ(1, frame_exchange.Take().Get(0, 0));
+  EXPECT_FALSE(frame_exchange.has_new_frame());
+
+  // Taken again before the next frame.
+  EXPECT_EQ(1, frame_exchange.Take().Get(0, 0));
+  EXPECT_EQ(1u, frame_exchange.duplicated_frames());
+
+  // Published over before it was taken.
+  PublishFrame(&frame_exchange, 2);
+  PublishFrame(&frame_exchange, 3);
+  EXPECT_EQ(3, frame_exchange.Take().Get(0, 0));
+  EXPECT_EQ(3u, frame_exchange.published_frames());
+  EXPECT_EQ(1u, frame_exchange.dropped_frames());
+  EXPECT_EQ(1u, frame_exchange.duplicated_frames());
+}
+
+TEST(FramePresenterTest, ShowsTheLastFrameAgainForASlowProducer) {
+  FrameExchange frame_exchange;
+  RecordingScreen screen;
+  FramePresenter frame_presenter(&frame_exchange, &screen);
+
+  // Nothing is drawn before there is a frame.
+  frame_presenter.Present();
+  frame_presenter.Present();
+  EXPECT_TRUE(screen.drawn().empty());
+
+  // A frame every third refresh, then two in one.
+  for (int frame = 1; frame <= 3; frame++) {
+    PublishFrame(&frame_exchange, frame);
+    for (int refresh = 0; refresh < 3; refresh++) {
+      frame_presenter.Present();
+    }
+  }
+  PublishFrame(&frame_exchange, 4);
+  PublishFrame(&frame_exchange, 5);
+  frame_presenter.Present();
+
+  EXPECT_EQ(vector<unsigned char>({1, 1, 1, 2, 2, 2, 3, 3, 3, 5}), screen.drawn());
+  EXPECT_EQ(6u, frame_exchange.duplicated_frames());
+  EXPECT_EQ(1u, frame_exchange.dropped_frames());
+}
+
+TEST(FramePresenterTest, PresentsOnItsOwnThread) {
+  const std::chrono::milliseconds kRefreshPeriod(2);
+  const int kFrames = 10;
+  FrameExchange frame_exchange;
+  RecordingScreen screen;
+  FramePresenter frame_presenter(&frame_exchange, &screen, kRefreshPeriod);
+  frame_presenter.Start();
+
+  std::this_thread::sleep_for(kRefreshPeriod * 5);
+  EXPECT_TRUE(screen.drawn().empty());
+  for (int frame = 1; frame <= kFrames; frame++) {
+    PublishFrame(&frame_exchange, frame);
+    std::this_thread::sleep_for(kRefreshPeriod * 5);
+  }
+  frame_presenter.Stop();
+
+  // How many refreshes there were depends on the scheduler, but every draw is
+  // of a published frame, never an older one than the draw before, and each
+  // time it was the one before again counts as duplicated.
+  vector<unsigned char> drawn = screen.drawn();
+  unsigned long repeats = 0;
+  for (size_t i = 0; i < drawn.size(); i++) {
+    EXPECT_LE(1, drawn[i]);
+    EXPECT_GE(kFrames, drawn[i]);
+    if (i > 0) {
+      EXPECT_LE(drawn[i - 1], drawn[i]);
+      if (drawn[i] == drawn[i - 1]) {
+        repeats++;
+      }
+    }
+  }
+  EXPECT_EQ(repeats, frame_exchange.duplicated_frames());
+  size_t drawn_after_stop = screen.drawn().size();
+  std::this_thread::sleep_for(kRefreshPeriod * 5);
+  EXPECT_EQ(drawn_after_stop, screen.drawn().size());
+}
+
+} // namespace graphics
+} // namespace back_end
@@ -1,316 +1,258 @@
 #include "backend/graphics/graphics_controller.h"
 
+#include <algorithm>
 #include <ncurses.h>
 
 namespace back_end {
 namespace graphics {
 
-using std::vector;
 using memory::BackgroundMap;
-using memory::OAMSegment;
-using memory::SpriteAttribute;
-using memory::Tile;
-using memory::TileData;
-using memory::VRAMSegment;
 
-namespace {
-class TileReflectedX : public Tile {
- public:
-  TileReflectedX() : tile_(nullptr) {}
-
-  TileReflectedX(Tile* tile) : tile_(tile) {}
-
-  virtual unsigned char Get(unsigned int y, unsigned int x) {
-    return tile_->Get(y, Tile::kTileSize - 1 - x);
-  }
+void GraphicsController::Init() {
+  // TODO(Brendan): Add the flags from graphics_flags_.
+  vram_segment_.set_access_listener(this);
+  oam_segment_.set_access_listener(this);
+  add_memory_segment(&vram_segment_);
+  add_memory_segment(&oam_segment_);
 
-  virtual void Set(unsigned int y, unsigned int x, unsigned char value) {
-    tile_->Set(y, Tile::kTileSize - 1 - x, value);
+  for (auto flag : graphics_flags_.flags()) {
+    flag->set_access_listener(this);
+    add_flag(flag);
   }
 
-  void set_tile(Tile* tile) { tile_ = tile; }
-
- private:
-  Tile* tile_;
-};
-
-class TileReflectedY : public Tile {
- public:
-  TileReflectedY() : tile_(nullptr) {}
-
-  TileReflectedY(Tile* tile) : tile_(tile) {}
+  line_ = 0;
+  frames_ = 0;
+  drawing_frame_ = render_every_ > 0;
+  StartLine(scheduler_->now());
+  ScheduleNextEvent();
+}
 
-  virtual unsigned char Get(unsigned int y, unsigned int x) {
-    return tile_->Get(Tile::kTileSize - y, x);
-  }
+void GraphicsController::Fire(uint64_t cycle) {
+  CatchUp(cycle);
+  ScheduleNextEvent();
+}
 
-  virtual void Set(unsigned int y, unsigned int x, unsigned char value) {
-    tile_->Set(Tile::kTileSize - y, x, value);
+void GraphicsController::OnAccess() {
+  uint64_t now = scheduler_->now();
+  if (now >= next_change_) {
+    CatchUp(now);
   }
+}
 
-  void set_tile(Tile* tile) { tile_ = tile; }
-
- private:
-  Tile* tile_;
-};
-
-void RenderTile(Tile* tile, 
-                unsigned char y_offset, 
-                unsigned char x_offset, 
-                MonochromePalette* palette, 
-                vector<unsigned char>* screen_buffer_) {
-  TileReflectedX x_flip(tile);
-  tile = &x_flip;
-  for (int y = 0; y < Tile::kTileSize; y++) {
-    for (int x = 0; x < Tile::kTileSize; x++) {
-      unsigned char color_index = tile->Get(y, x);
-      MonochromePalette::Color color = palette->lookup(color_index);
-      if (color != MonochromePalette::NONE) {
-        unsigned char realized_color = static_cast<unsigned char>(color) * (256 / 4);
-        (*screen_buffer_)[(x + x_offset) + (y + y_offset) * kScreenBufferSize] = realized_color;
-      }
+void GraphicsController::OnWritten() {
+  // A write to LY or LYC can make them match, or stop matching, mid line.
+  LCDStatus* lcd_status = graphics_flags_.lcd_status();
+  bool coincidence = graphics_flags_.ly_coordinate()->flag() == graphics_flags_.ly_compare()->flag();
+  if (coincidence != lcd_status->coincidence_flag()) {
+    lcd_status->set_coincidence_flag(coincidence);
+    if (coincidence && lcd_status->coincidence_interrupt()) {
+      SetLCDSTATInterrupt();
     }
   }
+  ScheduleNextEvent();
 }
 
-void RenderSprite(SpriteAttribute* sprite_attribute, 
-                  GraphicsFlags* graphics_flags, 
-                  VRAMSegment* vram_segment, 
-                  vector<unsigned char>* screen_buffer_) {
-  TileReflectedX tile_reflected_x;
-  TileReflectedY tile_reflected_y;
-  Tile* tile = vram_segment->lower_tile_data()->tile(sprite_attribute->tile_index());
-
-  // Reflect the tile as appropriate.
-  if (sprite_attribute->x_flip()) {
-    tile_reflected_x.set_tile(tile);
-    tile = &tile_reflected_x;
-  }
-  if (sprite_attribute->y_flip()) {
-    tile_reflected_y.set_tile(tile);
-    tile = &tile_reflected_y;
+void GraphicsController::CatchUp(uint64_t cycle) {
+  // Nothing before cycle raises an interrupt or finishes the frame, or it
+  // would have had an event, and every line start sets LY, the coincidence
+  // flag and the locks over again. So when no line is being drawn, the lines
+  // before the one cycle falls in are skipped rather than run, landing at the
+  // end of the one just before it.
+  uint64_t lines = (cycle - line_start_) / kSmallPeriod;
+  if (next_change_ <= cycle && lines >= 2 && !graphics_flags_.ly_coordinate()->has_reset() && !Drawing()) {
+    line_ = (line_ + lines - 1) % kLinesPerFrame;
+    line_start_ += (lines - 1) * kSmallPeriod;
+    mode_ = line_ < kVisibleLines ? LCDStatus::H_BLANK : LCDStatus::V_BLANK;
+    next_change_ = line_start_ + kSmallPeriod;
   }
 
-  // Select color palette.
-  MonochromePalette* palette;
-  if (sprite_attribute->palette()) {
-    palette = graphics_flags->object_palette_1();
-  } else {
-    palette = graphics_flags->object_palette_0();
+  while (next_change_ <= cycle) {
+    Step();
   }
-
-  RenderTile(tile, sprite_attribute->y(), sprite_attribute->x(), palette, screen_buffer_);
 }
 
-void WriteToScreen(GraphicsFlags* graphics_flags, Screen* screen, vector<unsigned char>* screen_buffer_) {
-  ScreenRaster raster;
-  const int y_offset = graphics_flags->scroll_y()->flag();
-  const int x_offset = graphics_flags->scroll_x()->flag();
-  for (int y = 0; y < ScreenRaster::kScreenHeight; y++) {
-    for (int x = 0; x < ScreenRaster::kScreenWidth; x++) {
-      raster.Set(y, x, (*screen_buffer_)[(x + x_offset) + (y + y_offset) * kScreenBufferSize]);
-    }
-  }
-
-  LOG(INFO) << "Rendering screen.";
-  screen->Draw(raster);
+void GraphicsController::SaveState(memory::StateWriter* writer) {
+  // Not caught up first, which would change the LCD registers after they were
+  // saved with the rest of memory.
+  writer->Write8(line_);
+  writer->Write8(mode_);
+  writer->Write64(line_start_);
+  writer->Write64(next_change_);
+  writer->Write64(frames_);
+  writer->WriteBool(drawing_frame_);
+  renderer_.SaveState(writer);
 }
 
-void RenderLowPrioritySprites(GraphicsFlags* graphics_flags, 
-                              OAMSegment* oam_segment, 
-                              VRAMSegment* vram_segment, 
-                              vector<unsigned char>* screen_buffer_) {
-  if (!graphics_flags->lcd_control()->sprite_display_enable()) {
-    return;
-  }
-  // LOG(INFO) << "Rendering low priority sprites.";
-  for (int i = 0; i < OAMSegment::kAttributeNumber; i++) {
-    SpriteAttribute* sprite_attribute = oam_segment->sprite_attribute(i);
-    if (!sprite_attribute->over_background()) {
-      RenderSprite(sprite_attribute, graphics_flags, vram_segment, screen_buffer_);
-    }
+void GraphicsController::LoadState(memory::StateReader* reader) {
+  line_ = reader->Read8();
+  mode_ = static_cast<LCDStatus::Mode>(reader->Read8());
+  line_start_ = reader->Read64();
+  next_change_ = reader->Read64();
+  frames_ = reader->Read64();
+  drawing_frame_ = reader->ReadBool();
+  renderer_.LoadState(reader);
+
+  // The locks as the mode left them. The lines already drawn this frame are
+  // what was on the screen before loading.
+  if (mode_ == LCDStatus::OAM_LOCKED) {
+    DisableOAM();
+    EnableVRAM();
+  } else if (mode_ == LCDStatus::VRAM_OAM_LOCKED) {
+    DisableOAM();
+    DisableVRAM();
+  } else {
+    EnableOAM();
+    EnableVRAM();
   }
+  ScheduleNextEvent();
 }
 
-void RenderHighPrioritySprites(GraphicsFlags* graphics_flags, 
-                               OAMSegment* oam_segment, 
-                               VRAMSegment* vram_segment, 
-                               vector<unsigned char>* screen_buffer_) {
-  if (!graphics_flags->lcd_control()->sprite_display_enable()) {
-    return;
+void GraphicsController::FinishFrame() {
+  if (Drawing()) {
+    frame_exchange_->Publish();
   }
-  // LOG(INFO) << "Rendering high priority sprites.";
-  for (int i = 0; i < OAMSegment::kAttributeNumber; i++) {
-    SpriteAttribute* sprite_attribute = oam_segment->sprite_attribute(i);
-    if (sprite_attribute->over_background()) {
-      RenderSprite(sprite_attribute, graphics_flags, vram_segment, screen_buffer_);
-    }
+  if (frame_hashing_) {
+    last_frame_hash_ = HashFrame();
   }
+  frames_++;
+  int render_every = render_every_;
+  drawing_frame_ = render_every > 0 && frames_ % render_every == 0;
 }
 
-void RenderBackground(GraphicsFlags* graphics_flags, VRAMSegment* vram_segment, vector<unsigned char>* screen_buffer) {
-  LCDControl* lcd_control = graphics_flags->lcd_control();
-  if (!lcd_control->bg_display()) {
-    // Nothing to do if BG display is unset.
-    return;
-  }
-
-  BackgroundMap* background;
-  if (lcd_control->bg_tile_map_display_select()) {
-    background = vram_segment->upper_background_map();
-  } else {
-    background = vram_segment->lower_background_map();
-  }
-
-  TileData* tile_data;
-  if (lcd_control->bg_window_tile_data_select()) {
-    tile_data = vram_segment->lower_tile_data();
-  } else {
-    tile_data = vram_segment->upper_tile_data();
-  }
-
-  for (int y = 0; y < kScreenBufferSize / Tile::kTileSize; y++) {
-    for (int x = 0; x < kScreenBufferSize / Tile::kTileSize; x++) {
-      Tile* tile = tile_data->tile(background->Get(y, x));
-      RenderTile(tile, y * Tile::kTileSize, x * Tile::kTileSize, graphics_flags->background_palette(), screen_buffer);
+unsigned long long GraphicsController::HashFrame() {
+  // FNV-1a, which is plenty to tell runs apart.
+  unsigned long long hash = 0xcbf29ce484222325ULL;
+  auto add = [&hash](const unsigned char* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      hash = (hash ^ data[i]) * 0x100000001b3ULL;
     }
+  };
+  add(vram_segment_.raw_tile_data().data(), vram_segment_.raw_tile_data().size());
+  const size_t map_size = BackgroundMap::kWidth * BackgroundMap::kHeight;
+  add(vram_segment_.lower_background_map()->data(), map_size);
+  add(vram_segment_.upper_background_map()->data(), map_size);
+  add(oam_segment_.data().data(), oam_segment_.data().size());
+  for (memory::Flag* flag : graphics_flags_.flags()) {
+    unsigned char value = flag->flag();
+    add(&value, 1);
   }
+  return hash;
 }
 
-void RenderWindow(GraphicsFlags* graphics_flags, VRAMSegment* vram_segment, vector<unsigned char>* screen_buffer) {
-  LCDControl* lcd_control = graphics_flags->lcd_control();
-  int y_offset = graphics_flags->window_y_position()->flag();
-  y_offset += graphics_flags->scroll_y()->flag();
-  int x_offset = graphics_flags->window_x_position()->flag() + 7;
-  x_offset += graphics_flags->scroll_x()->flag();
-
-  if (!lcd_control->window_display_enable()) {
-    return; // Nothing to do if disabled.
-  }
-
-  BackgroundMap* background;
-  if (lcd_control->window_tile_map_display_select()) {
-    background = vram_segment->upper_background_map();
-  } else {
-    background = vram_segment->lower_background_map();
+void GraphicsController::StartLine(uint64_t cycle) {
+  LCDStatus* lcd_status = graphics_flags_.lcd_status();
+  LYCoordinate* ly_coordinate = graphics_flags_.ly_coordinate();
+  ly_coordinate->set_flag(line_);
+  line_start_ = cycle;
+  if (line_ == 0) {
+    renderer_.StartFrame();
   }
 
-  TileData* tile_data;
-  if (lcd_control->bg_window_tile_data_select()) {
-    tile_data = vram_segment->upper_tile_data();
-  } else {
-    tile_data = vram_segment->lower_tile_data();
+  bool coincidence = ly_coordinate->flag() == graphics_flags_.ly_compare()->flag();
+  lcd_status->set_coincidence_flag(coincidence);
+  if (coincidence && lcd_status->coincidence_interrupt()) {
+    SetLCDSTATInterrupt();
   }
 
-  for (int y = 0; y < (kScreenBufferSize - y_offset) / Tile::kTileSize; y++) {
-    for (int x = 0; x < (kScreenBufferSize - x_offset) / Tile::kTileSize; x++) {
-      Tile* tile = tile_data->tile(background->Get(y, x));
-      RenderTile(tile,
-                 y * Tile::kTileSize + y_offset,
-                 x * Tile::kTileSize + x_offset,
-                 graphics_flags->background_palette(),
-                 screen_buffer);
+  if (line_ < kVisibleLines) {
+    // Mode 2.
+    SetMode(LCDStatus::OAM_LOCKED);
+    DisableOAM();
+    EnableVRAM();
+    if (lcd_status->oam_interrupt()) {
+      SetLCDSTATInterrupt();
     }
-  }
-}
-
-void Clear(vector<unsigned char>* screen_buffer_) {
-  for (int y = 0; y < kScreenBufferSize; y++) {
-    for (int x = 0; x < kScreenBufferSize; x++) {
-      (*screen_buffer_)[x + y * kScreenBufferSize] = 0;
+    next_change_ = cycle + kOAMLockedCycles;
+  } else {
+    if (line_ == kVisibleLines) {
+      // Mode 1.
+      SetMode(LCDStatus::V_BLANK);
+      EnableOAM();
+      EnableVRAM();
+      SetVBlankInterrupt();
+      if (lcd_status->v_blank_interrupt()) {
+        SetLCDSTATInterrupt();
+      }
+      FinishFrame();
     }
+    next_change_ = cycle + kSmallPeriod;
   }
 }
 
-void Draw(GraphicsFlags* graphics_flags, OAMSegment* oam_segment, VRAMSegment* vram_segment, Screen* screen) {
-  vector<unsigned char> screen_buffer(kScreenBufferSize * kScreenBufferSize, 0);
-  LOG(INFO) << "Clearing...";
-  Clear(&screen_buffer);
-  LOG(INFO) << "Rendering rendering low priority sprites...";
-  RenderLowPrioritySprites(graphics_flags, oam_segment, vram_segment, &screen_buffer);
-  LOG(INFO) << "Rendering background...";
-  RenderBackground(graphics_flags, vram_segment, &screen_buffer);
-  LOG(INFO) << "Rendering window...";
-  RenderWindow(graphics_flags, vram_segment, &screen_buffer);
-  LOG(INFO) << "Rendering rendering high priority sprites...";
-  RenderHighPrioritySprites(graphics_flags, oam_segment, vram_segment, &screen_buffer);
-  LOG(INFO) << "Rendering...";
-  WriteToScreen(graphics_flags, screen, &screen_buffer);
-}
-} // namespace
-
-void GraphicsController::Init() {
-  // TODO(Brendan): Add the flags from graphics_flags_.
-  add_memory_segment(&vram_segment_);
-  add_memory_segment(&oam_segment_);
-
-  for (auto flag : graphics_flags_.flags()) {
-    add_flag(flag);
-  }
+void GraphicsController::SetMode(LCDStatus::Mode mode) {
+  mode_ = mode;
+  graphics_flags_.lcd_status()->set_mode(mode);
 }
 
-void GraphicsController::Tick(unsigned int number_of_cycles) {
+void GraphicsController::Step() {
   LCDStatus* lcd_status = graphics_flags_.lcd_status();
   LYCoordinate* ly_coordinate = graphics_flags_.ly_coordinate();
-  LYCompare* ly_compare = graphics_flags_.ly_compare();
-
-  if (ly_coordinate->flag() == ly_compare->flag()) {
-    lcd_status->set_coincidence_flag(true);
-    if (lcd_status->coincidence_interrupt()) {
-      interrupt_flag()->set_lcd_stat(true);
-    }
-  }
+  uint64_t cycle = next_change_;
 
   if (ly_coordinate->has_reset()) {
-    time_ = 0;
     ly_coordinate->clear_reset();
+    line_ = 0;
+    StartLine(cycle);
+    return;
   }
 
-  time_ += number_of_cycles;
-  time_ %= kLargePeriod;
-  // Mode 1.
-  if (time_ > kVBlankLowerBound) {
-    lcd_status->set_mode(LCDStatus::V_BLANK);
-    EnableOAM();
-    EnableVRAM();
-    SetVBlankInterrupt();
-    if (lcd_status->v_blank_interrupt()) {
-      SetLCDSTATInterrupt();
-    }
-    previous_mode_ = MODE_1;
-  // Mode 0.
-  } else if (time_ % kSmallPeriod > kHBlankLowerBound) {
-    lcd_status->set_mode(LCDStatus::H_BLANK);
-    EnableOAM();
-    EnableVRAM();
-    if (lcd_status->h_blank_interrupt()) {
-      SetLCDSTATInterrupt();
-    }
-    previous_mode_ = MODE_0;
-  // Mode 3.
-  } else if (time_ % kSmallPeriod > kVRAMOAMLockedLowerBound) {
-    lcd_status->set_mode(LCDStatus::VRAM_OAM_LOCKED);
+  if (mode_ == LCDStatus::H_BLANK || mode_ == LCDStatus::V_BLANK) {
+    line_ = (line_ + 1) % kLinesPerFrame;
+    StartLine(cycle);
+  } else if (mode_ == LCDStatus::OAM_LOCKED) {
+    // Mode 3.
+    SetMode(LCDStatus::VRAM_OAM_LOCKED);
     DisableOAM();
     DisableVRAM();
-    if (graphics_flags_.lcd_control()->lcd_display_enable() 
-        && previous_mode_ != MODE_3
-        && ly_coordinate->flag() == 0) {
-      Draw(&graphics_flags_, &oam_segment_, &vram_segment_, screen_);
+    if (Drawing()) {
+      renderer_.RenderLine(line_, frame_exchange_->back());
     }
-    previous_mode_ = MODE_3;
-  // Mode 2.
-  } else if (time_ % kSmallPeriod > kOAMLockedLowerBound) {
-    lcd_status->set_mode(LCDStatus::OAM_LOCKED);
-    DisableOAM();
+    next_change_ = cycle + kVRAMOAMLockedCycles;
+  } else {
+    // Mode 0.
+    SetMode(LCDStatus::H_BLANK);
+    EnableOAM();
     EnableVRAM();
-    if (lcd_status->oam_interrupt()) {
+    if (lcd_status->h_blank_interrupt()) {
       SetLCDSTATInterrupt();
     }
-    if (previous_mode_ != MODE_2) {
-      ly_coordinate->Increment();
+    next_change_ = cycle + kHBlankCycles;
+  }
+}
+
+uint64_t GraphicsController::NextLineStart(int line) {
+  int lines = (line - line_ + kLinesPerFrame - 1) % kLinesPerFrame + 1;
+  return line_start_ + static_cast<uint64_t>(lines) * kSmallPeriod;
+}
+
+void GraphicsController::ScheduleNextEvent() {
+  if (graphics_flags_.ly_coordinate()->has_reset()) {
+    scheduler_->Schedule(this, next_change_);
+    return;
+  }
+
+  LCDStatus* lcd_status = graphics_flags_.lcd_status();
+  // V-Blank always raises an interrupt and finishes the frame.
+  uint64_t next = NextLineStart(kVisibleLines);
+
+  int next_line = (line_ + 1) % kLinesPerFrame;
+  int next_visible_line = next_line < kVisibleLines ? next_line : 0;
+  if (lcd_status->oam_interrupt()) {
+    next = std::min(next, NextLineStart(next_visible_line));
+  }
+  if (lcd_status->h_blank_interrupt()) {
+    const uint64_t h_blank_offset = kOAMLockedCycles + kVRAMOAMLockedCycles;
+    if (line_ < kVisibleLines && mode_ != LCDStatus::H_BLANK) {
+      next = std::min(next, line_start_ + h_blank_offset);
+    } else {
+      next = std::min(next, NextLineStart(next_visible_line) + h_blank_offset);
     }
-    previous_mode_ = MODE_2;
   }
+  int ly_compare = graphics_flags_.ly_compare()->flag();
+  if (lcd_status->coincidence_interrupt() && ly_compare < kLinesPerFrame) {
+    next = std::min(next, NextLineStart(ly_compare));
+  }
+  scheduler_->Schedule(this, next);
 }
 
 } // namespace graphics
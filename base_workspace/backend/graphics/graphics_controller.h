@@ -1,49 +1,131 @@
 #ifndef TURBO_SANTA_COMMON_BACK_END_GRAPHICS_GRAPHICS_CONTROLLER_H_
 #define TURBO_SANTA_COMMON_BACK_END_GRAPHICS_GRAPHICS_CONTROLLER_H_
 
+#include <atomic>
+
+#include "backend/clocktroller/scheduler.h"
 #include "backend/memory/module.h"
 #include "backend/memory/primary_flags.h"
+#include "backend/graphics/frame_exchange.h"
 #include "backend/graphics/graphics_flags.h"
-#include "backend/graphics/screen.h"
+#include "backend/graphics/scanline_renderer.h"
 #include "backend/memory/interrupt_flag.h"
 #include "backend/memory/vram_segment.h"
 
 namespace back_end {
 namespace graphics {
 
-static const int kSmallPeriod = 456;
-static const int kLargePeriod = 70224;
-static const int kVBlankLowerBound = kLargePeriod - kSmallPeriod * 10; // Mode 1.
-static const int kOAMLockedLowerBound = 80; // Mode 2.
-static const int kVRAMOAMLockedLowerBound = 172 + kOAMLockedLowerBound; // Mode 3.
-static const int kHBlankLowerBound = 204 + kVRAMOAMLockedLowerBound; // Mode 0.
-
-static const int kScreenBufferSize = 256; // Square.
+static const int kSmallPeriod = 456; // One line.
+static const int kLargePeriod = 70224; // One frame.
+static const int kLinesPerFrame = kLargePeriod / kSmallPeriod;
+static const int kVisibleLines = 144; // Mode 1 for the rest of the frame.
+// How long each mode lasts on a visible line, in the order they come.
+static const int kOAMLockedCycles = 80; // Mode 2.
+static const int kVRAMOAMLockedCycles = 172; // Mode 3.
+static const int kHBlankCycles = kSmallPeriod - kOAMLockedCycles - kVRAMOAMLockedCycles; // Mode 0.
 
-class GraphicsController : public memory::Module {
+// Runs the LCD off the Scheduler, lazily. Mode changes are only worked out
+// once something could tell that they happened: the CPU touching VRAM, OAM or
+// any of the LCD registers, which catches the LCD up to the current cycle, or a
+// change that raises an interrupt or finishes the frame, which is the only
+// kind that gets an event of its own. Most instructions touch none of these,
+// so most of the time nothing here runs at all.
+class GraphicsController : public memory::Module,
+                           public clocktroller::TimedEvent,
+                           public memory::AccessListener {
  public:
-  GraphicsController(Screen* screen, memory::PrimaryFlags* primary_flags) : 
-      screen_(screen), primary_flags_(primary_flags) {}
+  // Frames are drawn into frame_exchange's back frame and published there.
+  GraphicsController(FrameExchange* frame_exchange, memory::PrimaryFlags* primary_flags, clocktroller::Scheduler* scheduler) :
+      renderer_(&graphics_flags_, &vram_segment_, &oam_segment_),
+      frame_exchange_(frame_exchange), primary_flags_(primary_flags), scheduler_(scheduler) {}
 
+  // Starts the first line as of the scheduler's current cycle.
   void Init();
 
-  void Tick(unsigned int number_of_cycles);
+  // Catches up to cycle, which is when the next interrupt or frame was due.
+  virtual void Fire(uint64_t cycle);
+
+  // Catches up to the scheduler's current cycle.
+  virtual void OnAccess();
+
+  // An LCD register was written, which may change when the next interrupt is
+  // due, or make LY and LYC match now.
+  virtual void OnWritten();
+
+  // Draws only every render_every frames, or none at all if 0, for running
+  // faster than the screen can be drawn. LY, STAT, the interrupts and the VRAM
+  // and OAM locks run exactly the same either way. Safe to call while running;
+  // takes effect from the next frame.
+  void set_render_every(int render_every) { render_every_ = render_every; }
+
+  // Whether to hash VRAM, OAM and the LCD registers at each V-Blank, drawn or
+  // not, so that a run can be checked without drawing it.
+  void set_frame_hashing(bool frame_hashing) { frame_hashing_ = frame_hashing; }
+
+  // The hash from the last V-Blank, or 0 if none; safe to call while running.
+  unsigned long long last_frame_hash() const { return last_frame_hash_; }
+
+  // For DMA transfers, which write all of OAM at once.
+  memory::OAMSegment* oam_segment() { return &oam_segment_; }
+
+  // Saves or loads where the LCD is in the frame. VRAM, OAM and the LCD
+  // registers are saved with the rest of memory, and have to be loaded first.
+  // Loading reschedules the next event, so the Scheduler must be at the cycle
+  // the state was saved at.
+  void SaveState(memory::StateWriter* writer);
+  void LoadState(memory::StateReader* reader);
+
+  // The cycle after the current one that LY or STAT next changes at.
+  uint64_t next_change() {
+    OnAccess();
+    return next_change_;
+  }
 
  private:
-  enum PreviousMode {
-    MODE_0,
-    MODE_1,
-    MODE_2,
-    MODE_3,
-  };
+  // Makes every mode change due up to and including cycle.
+  void CatchUp(uint64_t cycle);
+  // Makes the mode change due at next_change_.
+  void Step();
+  void StartLine(uint64_t cycle);
+  // Keeps mode_ and the mode bits of STAT in step.
+  void SetMode(LCDStatus::Mode mode);
+  // Schedules this for the first mode change from next_change_ on that does
+  // more than update the registers: raises an interrupt, draws the frame or
+  // acts on a write to LY.
+  void ScheduleNextEvent();
+  // When line next starts, after the current line.
+  uint64_t NextLineStart(int line);
+  // Whether the frame being drawn, or the next one during V-Blank, will go to
+  // the screen.
+  bool Drawing() { return drawing_frame_ && graphics_flags_.lcd_control()->lcd_display_enable(); }
+  // Publishes or hashes the frame that just finished, as asked, and decides
+  // whether to draw the next.
+  void FinishFrame();
+  unsigned long long HashFrame();
 
   // TODO(Brendan): Finish implementing interrupt_flag.
   GraphicsFlags graphics_flags_;
   memory::VRAMSegment vram_segment_;
   memory::OAMSegment oam_segment_;
-  Screen* screen_;
+  // Each visible line is drawn into the back frame as it enters mode 3, and
+  // the frame is published at V-Blank.
+  ScanlineRenderer renderer_;
+  FrameExchange* frame_exchange_;
   memory::PrimaryFlags* primary_flags_;
-  PreviousMode previous_mode_;
+  clocktroller::Scheduler* scheduler_;
+  // The line being drawn, which is what LY reads, except that a write to LY
+  // is only noticed at the start of the next mode.
+  int line_ = 0;
+  // Kept apart from STAT, which the game can write to.
+  LCDStatus::Mode mode_ = LCDStatus::OAM_LOCKED;
+  // The cycles the current line started and the next mode change is due.
+  uint64_t line_start_ = 0;
+  uint64_t next_change_ = 0;
+  std::atomic<int> render_every_{1};
+  std::atomic<bool> frame_hashing_{false};
+  std::atomic<unsigned long long> last_frame_hash_{0};
+  uint64_t frames_ = 0;
+  bool drawing_frame_ = true;
   memory::InterruptFlag* interrupt_flag() { return primary_flags_->interrupt_flag(); }
 
   void SetLCDSTATInterrupt() { interrupt_flag()->set_lcd_stat(true); }
@@ -52,7 +134,6 @@ class GraphicsController : public memory::Module {
   void EnableOAM() { oam_segment_.Enable(); }
   void DisableVRAM() { vram_segment_.Disable(); }
   void DisableOAM() { oam_segment_.Disable(); }
-  unsigned long time_ = 0;
 };
 
 } // namespace graphics
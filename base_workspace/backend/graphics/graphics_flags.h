@@ -8,9 +8,45 @@
 namespace back_end {
 namespace graphics {
 
-class LCDControl : public memory::Flag {
+// A register the LCD changes as it runs, or one that changes what it does
+// next. The GraphicsController only catches up when told, so it is told before
+// each read or write and after each write; reads go through Read rather than
+// the backing byte for this reason.
+class LCDRegister : public memory::Flag {
  public:
-  LCDControl() : memory::Flag(0xff40) {}
+  LCDRegister(unsigned short address) : memory::Flag(address) {}
+
+  virtual unsigned char Read(unsigned short address) {
+    Access();
+    return Flag::Read(address);
+  }
+
+  virtual void Write(unsigned short address, unsigned char value) {
+    Access();
+    Flag::Write(address, value);
+    Written();
+  }
+
+  virtual const unsigned char* backing_byte() { return nullptr; }
+};
+
+// A register the LCD only reads, when it draws a line at the start of mode 3.
+// Lines are drawn as the GraphicsController catches up, so it is told before
+// each write, which draws the lines before it with the old value. Nothing but
+// the game changes these, so reads can still use the backing byte.
+class LCDDrawRegister : public memory::Flag {
+ public:
+  LCDDrawRegister(unsigned short address) : memory::Flag(address) {}
+
+  virtual void Write(unsigned short address, unsigned char value) {
+    Access();
+    Flag::Write(address, value);
+  }
+};
+
+class LCDControl : public LCDRegister {
+ public:
+  LCDControl() : LCDRegister(0xff40) {}
   bool lcd_display_enable() { return bit(7); }
   bool window_tile_map_display_select() { return bit(6); }
   bool window_display_enable() { return bit(5); }
@@ -21,7 +57,7 @@ class LCDControl : public memory::Flag {
   bool bg_display() { return bit(0); }
 };
 
-class LCDStatus : public memory::Flag {
+class LCDStatus : public LCDRegister {
  public:
   enum Mode {
     H_BLANK = 0,
@@ -30,7 +66,15 @@ class LCDStatus : public memory::Flag {
     VRAM_OAM_LOCKED = 3
   };
 
-  LCDStatus() : memory::Flag(0xff41) {}
+  LCDStatus() : LCDRegister(0xff41) {}
+
+  // The mode and coincidence bits are the LCD's own; the game only sets which
+  // interrupts to raise.
+  virtual void Write(unsigned short, unsigned char value) {
+    Access();
+    set_flag((value & 0b11111000) | (flag() & 0b00000111));
+    Written();
+  }
 
   Mode mode() { return static_cast<Mode>(0b00000011 & flag()); }
   bool coincidence_interrupt() { return bit(6); }
@@ -48,24 +92,26 @@ class LCDStatus : public memory::Flag {
 
 };
 
-class ScrollY : public memory::Flag {
+class ScrollY : public LCDDrawRegister {
  public:
-  ScrollY() : memory::Flag(0xff42) {}
+  ScrollY() : LCDDrawRegister(0xff42) {}
 };
 
-class ScrollX : public memory::Flag {
+class ScrollX : public LCDDrawRegister {
  public:
-  ScrollX() : memory::Flag(0xff43) {}
+  ScrollX() : LCDDrawRegister(0xff43) {}
 };
 
 // Specifies the Y coordinate currently being rendered to the screen.
-class LYCoordinate : public memory::Flag {
+class LYCoordinate : public LCDRegister {
  public:
-  LYCoordinate() : memory::Flag(0xff44) {}
+  LYCoordinate() : LCDRegister(0xff44) {}
   // LY is a READ ONLY register.
   virtual void Write(unsigned short, unsigned char) {
+    Access();
     set_flag(0);
-    has_reset_ = 0;
+    has_reset_ = true;
+    Written();
   }
 
   virtual void set_flag(unsigned char value) { Flag::set_flag(value); }
@@ -74,6 +120,16 @@ class LYCoordinate : public memory::Flag {
 
   void clear_reset() { has_reset_ = false; }
 
+  virtual void SaveState(memory::StateWriter* writer) {
+    Flag::SaveState(writer);
+    writer->WriteBool(has_reset_);
+  }
+
+  virtual void LoadState(memory::StateReader* reader) {
+    Flag::LoadState(reader);
+    has_reset_ = reader->ReadBool();
+  }
+
   void Increment() {
     LOG(INFO) << "LY Coordinate: Increment called, current value = 0x" << std::hex << (0x0000 + flag());
     if (flag() >= 153) {
@@ -88,22 +144,22 @@ class LYCoordinate : public memory::Flag {
 };
 
 // Specifies the Y coordinate to for which to set the cooincident bit in LCD STAT.
-class LYCompare : public memory::Flag {
+class LYCompare : public LCDRegister {
  public:
-  LYCompare() : memory::Flag(0xff45) {}
+  LYCompare() : LCDRegister(0xff45) {}
 };
 
-class WindowYPosition : public memory::Flag {
+class WindowYPosition : public LCDDrawRegister {
  public:
-  WindowYPosition() : memory::Flag(0xff4a) {}
+  WindowYPosition() : LCDDrawRegister(0xff4a) {}
 };
 
-class WindowXPosition : public memory::Flag {
+class WindowXPosition : public LCDDrawRegister {
  public:
-  WindowXPosition() : memory::Flag(0xff4b) {}
+  WindowXPosition() : LCDDrawRegister(0xff4b) {}
 };
 
-class MonochromePalette : public memory::Flag {
+class MonochromePalette : public LCDDrawRegister {
  public:
   enum Color {
     WHITE = 0,
@@ -113,7 +169,7 @@ class MonochromePalette : public memory::Flag {
     NONE = 4
   };
 
-  MonochromePalette(unsigned short address) : memory::Flag(address) {}
+  MonochromePalette(unsigned short address) : LCDDrawRegister(address) {}
 
   virtual Color lookup(unsigned char index) { return static_cast<Color>((flag() >> (index * 2)) & 0b00000011); }
 };
@@ -146,9 +202,8 @@ class ObjectPalette1 : public ObjectPalette {
   ObjectPalette1() : ObjectPalette(0xff49) {}
 };
 
-// TODO(Brendan): Move this into a .cc.
-// TODO(Brendan): Use a more general way to manipulate these flags, could use a
-// map.
+// Looks flags up by address in a table covering 0xff40 - 0xff4b, so that
+// polling LY or STAT is one indexed call. 0xff46 is DMA, which lives elsewhere.
 class GraphicsFlags : public memory::MemorySegment {
  public:
   GraphicsFlags() {
@@ -163,100 +218,22 @@ class GraphicsFlags : public memory::MemorySegment {
     flags_.push_back(&background_palette_);
     flags_.push_back(&object_palette_0_);
     flags_.push_back(&object_palette_1_);
+    for (memory::Flag* flag : flags_) {
+      by_address_[flag->address() - kLowerAddressBound] = flag;
+    }
   }
 
   virtual bool InRange(unsigned short address) {
-    return lcd_control_.InRange(address) ||
-        lcd_status_.InRange(address) ||
-        scroll_y_.InRange(address) ||
-        scroll_x_.InRange(address) ||
-        ly_coordinate_.InRange(address) ||
-        ly_compare_.InRange(address) ||
-        window_y_position_.InRange(address) ||
-        window_x_position_.InRange(address) ||
-        background_palette_.InRange(address) ||
-        object_palette_0_.InRange(address) ||
-        object_palette_1_.InRange(address);
+    return address >= kLowerAddressBound && address <= kUpperAddressBound &&
+        by_address_[address - kLowerAddressBound] != nullptr;
   }
 
   virtual unsigned char Read(unsigned short address) {
-    if (lcd_control_.InRange(address)) {
-      return lcd_control_.Read(address);
-    } else if (lcd_status_.InRange(address)) {
-      LOG(INFO) << "Checked LCD Status.";
-      return lcd_status_.Read(address);
-    } else if (scroll_y_.InRange(address)) {
-      return scroll_y_.Read(address);
-    } else if (scroll_x_.InRange(address)) {
-      return scroll_x_.Read(address);
-    } else if (ly_coordinate_.InRange(address)) {
-      LOG(INFO) << "Checked LY LYCoordinate";
-      return ly_coordinate_.Read(address);
-    } else if (ly_compare_.InRange(address)) {
-      return ly_compare_.Read(address);
-    } else if (window_y_position_.InRange(address)) {
-      return window_y_position_.Read(address);
-    } else if (window_x_position_.InRange(address)) {
-      return window_x_position_.Read(address);
-    } else if (background_palette_.InRange(address)) {
-      return background_palette_.Read(address);
-    } else if (object_palette_0_.InRange(address)) {
-      return object_palette_0_.Read(address);
-    } else if (object_palette_1_.InRange(address)) {
-      return object_palette_1_.Read(address);
-    } else {
-      LOG(FATAL) << "Address outside of range: " << address;
-    }
+    return flag_for(address)->Read(address);
   }
 
   virtual void Write(unsigned short address, unsigned char value) {
-    if (lcd_control_.InRange(address)) {
-      lcd_control_.Write(address, value);
-      LOG(INFO) << "LCD control written to.";
-      LOG(INFO) << "lcd_control = " << lcd_control_.lcd_display_enable();
-      LOG(INFO) << "window_tile_map_display_select = " << lcd_control_.window_tile_map_display_select();
-      LOG(INFO) << "window_display_enable = " << lcd_control_.window_display_enable();
-      LOG(INFO) << "bg_window_tile_data_select = " << lcd_control_.bg_window_tile_data_select();
-      LOG(INFO) << "bg_tile_map_display_select = " << lcd_control_.bg_tile_map_display_select();
-      LOG(INFO) << "sprite_size = " << lcd_control_.sprite_size();
-      LOG(INFO) << "sprite_display_enable = " << lcd_control_.sprite_display_enable();
-      LOG(INFO) << "bg_display = " << lcd_control_.bg_display();
-    } else if (lcd_status_.InRange(address)) {
-      lcd_status_.Write(address, value);
-      LOG(INFO) << "LCD status written to.";
-      LOG(INFO) << "coincidence_interrupt = " << lcd_status_.coincidence_interrupt();
-      LOG(INFO) << "oam_interrupt = " << lcd_status_.oam_interrupt();
-      LOG(INFO) << "v_blank_interrupt = " << lcd_status_.v_blank_interrupt();
-      LOG(INFO) << "h_blank_interrupt = " << lcd_status_.h_blank_interrupt();
-    } else if (scroll_y_.InRange(address)) {
-      scroll_y_.Write(address, value);
-      LOG(INFO) << "Scroll Y written to.";
-    } else if (scroll_x_.InRange(address)) {
-      scroll_x_.Write(address, value);
-      LOG(INFO) << "Scroll X written to.";
-    } else if (ly_coordinate_.InRange(address)) {
-      ly_coordinate_.Write(address, value);
-    } else if (ly_compare_.InRange(address)) {
-      ly_compare_.Write(address, value);
-      LOG(INFO) << "LY Compare written to, value = " << value;
-    } else if (window_y_position_.InRange(address)) {
-      window_y_position_.Write(address, value);
-      LOG(INFO) << "Window Y Position set.";
-    } else if (window_x_position_.InRange(address)) {
-      LOG(INFO) << "Window X Position set.";
-      window_x_position_.Write(address, value);
-    } else if (background_palette_.InRange(address)) {
-      background_palette_.Write(address, value);
-      LOG(INFO) << std::hex << 0x0000 + value << " was written to the background palette";
-    } else if (object_palette_0_.InRange(address)) {
-      object_palette_0_.Write(address, value);
-      LOG(INFO) << std::hex << 0x0000 + value << " was written to the object palette 0 palette";
-    } else if (object_palette_1_.InRange(address)) {
-      object_palette_1_.Write(address, value);
-      LOG(INFO) << std::hex << 0x0000 + value << " was written to the object palette 1 palette";
-    } else {
-      LOG(FATAL) << "Address outside of range: " << address;
-    }
+    flag_for(address)->Write(address, value);
   }
 
   const std::vector<memory::Flag*>& flags() const { return flags_; }
@@ -273,7 +250,18 @@ class GraphicsFlags : public memory::MemorySegment {
   MonochromePalette* object_palette_0() { return &object_palette_0_; }
   MonochromePalette* object_palette_1() { return &object_palette_1_; }
  private:
+  static const unsigned short kLowerAddressBound = 0xff40;
+  static const unsigned short kUpperAddressBound = 0xff4b;
+
+  memory::Flag* flag_for(unsigned short address) {
+    if (!InRange(address)) {
+      LOG(FATAL) << "Address outside of range: " << address;
+    }
+    return by_address_[address - kLowerAddressBound];
+  }
+
   std::vector<memory::Flag*> flags_;
+  memory::Flag* by_address_[kUpperAddressBound - kLowerAddressBound + 1] = {};
   LCDControl lcd_control_;
   LCDStatus lcd_status_;
   ScrollY scroll_y_;
@@ -0,0 +1,127 @@
+#include "backend/graphics/pixel_kernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace back_end {
+namespace graphics {
+
+namespace {
+const int kRowPixels = 8;
+
+#if defined(__SSE2__)
+// Maps sixteen color indices through colors at once.
+inline __m128i Lookup16(__m128i color_indices, const unsigned char* colors) {
+#if defined(__SSSE3__)
+  // The color indices pick bytes out of the first four of table.
+  const __m128i table = _mm_set1_epi32(colors[0] | colors[1] << 8 | colors[2] << 16 | colors[3] << 24);
+  return _mm_shuffle_epi8(table, color_indices);
+#else
+  __m128i result = _mm_and_si128(_mm_cmpeq_epi8(color_indices, _mm_setzero_si128()),
+                                 _mm_set1_epi8(colors[0]));
+  for (int i = 1; i < 4; i++) {
+    __m128i is_index = _mm_cmpeq_epi8(color_indices, _mm_set1_epi8(i));
+    result = _mm_or_si128(result, _mm_and_si128(is_index, _mm_set1_epi8(colors[i])));
+  }
+  return result;
+#endif
+}
+#endif
+} // namespace
+
+const char* PixelKernelsName() {
+#if defined(__AVX2__)
+  return "AVX2";
+#elif defined(__SSSE3__)
+  return "SSSE3";
+#elif defined(__SSE2__)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
+
+void DecodeTileRow(unsigned char low, unsigned char high, bool x_flip, unsigned char* color_indices) {
+#if defined(__SSE2__)
+  // The bit each pixel comes from, in both halves: the low plane's pixels in
+  // the bottom eight bytes and the high plane's in the top eight.
+  const __m128i bits = x_flip ?
+      _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128) :
+      _mm_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+  __m128i planes = _mm_unpacklo_epi64(_mm_set1_epi8(low), _mm_set1_epi8(high));
+  __m128i set = _mm_cmpeq_epi8(_mm_and_si128(planes, bits), bits);
+  __m128i result = _mm_or_si128(_mm_and_si128(set, _mm_set1_epi8(1)),
+                                _mm_and_si128(_mm_srli_si128(set, 8), _mm_set1_epi8(2)));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(color_indices), result);
+#else
+  for (int x = 0; x < kRowPixels; x++) {
+    int shift = x_flip ? x : kRowPixels - 1 - x;
+    color_indices[x] = ((low >> shift) & 0b00000001) | (((high >> shift) & 0b00000001) << 1);
+  }
+#endif
+}
+
+void ApplyPalette(const unsigned char* color_indices, const unsigned char* colors, int count, unsigned char* pixels) {
+  int i = 0;
+#if defined(__AVX2__)
+  const __m256i table = _mm256_set1_epi32(colors[0] | colors[1] << 8 | colors[2] << 16 | colors[3] << 24);
+  for (; i + 32 <= count; i += 32) {
+    __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(color_indices + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i), _mm256_shuffle_epi8(table, indices));
+  }
+#endif
+#if defined(__SSE2__)
+  for (; i + 16 <= count; i += 16) {
+    __m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(color_indices + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), Lookup16(indices, colors));
+  }
+#endif
+  for (; i < count; i++) {
+    pixels[i] = colors[color_indices[i]];
+  }
+}
+
+void DrawSpriteRow(const unsigned char* color_row,
+                   const unsigned char* colors,
+                   bool behind_background,
+                   const unsigned char* background_indices,
+                   unsigned char* taken,
+                   unsigned char* pixels) {
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  __m128i indices = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(color_row));
+  __m128i taken_bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(taken));
+  __m128i old_pixels = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels));
+
+  // Opaque and not already taken.
+  __m128i claimed = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi8(indices, zero), taken_bytes),
+                                     _mm_cmpeq_epi8(zero, zero));
+  __m128i shown = claimed;
+  if (behind_background) {
+    __m128i background = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(background_indices));
+    shown = _mm_and_si128(shown, _mm_cmpeq_epi8(background, zero));
+  }
+  __m128i new_pixels = _mm_or_si128(_mm_and_si128(shown, Lookup16(indices, colors)),
+                                    _mm_andnot_si128(shown, old_pixels));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(pixels), new_pixels);
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(taken), _mm_or_si128(taken_bytes, claimed));
+#else
+  for (int x = 0; x < kRowPixels; x++) {
+    if (color_row[x] == 0 || taken[x] != 0) {
+      continue;
+    }
+    taken[x] = 0xff;
+    if (!behind_background || background_indices[x] == 0) {
+      pixels[x] = colors[color_row[x]];
+    }
+  }
+#endif
+}
+
+} // namespace graphics
+} // namespace back_end
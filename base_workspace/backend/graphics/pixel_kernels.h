@@ -0,0 +1,37 @@
+#ifndef TURBO_SANTA_COMMON_BACK_END_GRAPHICS_PIXEL_KERNELS_H_
+#define TURBO_SANTA_COMMON_BACK_END_GRAPHICS_PIXEL_KERNELS_H_
+
+namespace back_end {
+namespace graphics {
+
+// The inner loops of drawing a line, written with AVX2, SSSE3 or SSE2 when the
+// compiler is targeting them (e.g. with -march=native) and in plain C++
+// otherwise. Whichever is built gives exactly the same pixels.
+
+// Which of the above was built, for the benchmark.
+const char* PixelKernelsName();
+
+// Expands one row of a tile, given as its low and high bit planes, into eight
+// color indices, from left to right, or from right to left if x_flip.
+void DecodeTileRow(unsigned char low, unsigned char high, bool x_flip, unsigned char* color_indices);
+
+// Sets pixels[i] to colors[color_indices[i]] for each i below count. Every
+// color index must be below 4.
+void ApplyPalette(const unsigned char* color_indices, const unsigned char* colors, int count, unsigned char* pixels);
+
+// Draws the eight color indices of a sprite row through colors over pixels.
+// A sprite pixel with color index 0 is transparent, and one whose taken byte
+// is already set lost to a sprite drawn before it. Every other pixel sets its
+// taken byte to 0xff, and is drawn unless behind_background is set and the
+// background color index under it is not 0.
+void DrawSpriteRow(const unsigned char* color_row,
+                   const unsigned char* colors,
+                   bool behind_background,
+                   const unsigned char* background_indices,
+                   unsigned char* taken,
+                   unsigned char* pixels);
+
+} // namespace graphics
+} // namespace back_end
+
+#endif // TURBO_SANTA_COMMON_BACK_END_GRAPHICS_PIXEL_KERNELS_H_
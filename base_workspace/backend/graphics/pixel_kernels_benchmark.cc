@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "backend/graphics/pixel_kernels.h"
+#include "backend/memory/vram_segment.h"
+#include "submodules/glog/src/glog/logging.h"
+
+// Times the pixel kernels against what they replaced: ConcreteTile::Get for
+// decoding a tile row, and plain loops for applying a palette and drawing a
+// sprite row. Checks first that each gives the same answer for every input.
+//
+// bazel run -c opt --copt=-march=native //backend/graphics:pixel_kernels_benchmark
+
+using back_end::graphics::ApplyPalette;
+using back_end::graphics::DecodeTileRow;
+using back_end::graphics::DrawSpriteRow;
+using back_end::memory::DecodedTiles;
+using back_end::memory::LowerTileData;
+using back_end::memory::Tile;
+using std::vector;
+
+namespace {
+const int kPasses = 256;
+const int kLineWidth = 160;
+const int kLines = 1024;
+
+// Decodes a row the way the renderer did before, through Tile::Get, which
+// numbers its pixels from the right.
+void DecodeWithTile(Tile* tile, bool x_flip, unsigned char* color_indices) {
+  for (int x = 0; x < Tile::kTileSize; x++) {
+    color_indices[x] = tile->Get(0, x_flip ? x : Tile::kTileSize - 1 - x);
+  }
+}
+
+void ApplyPaletteWithLoop(const unsigned char* color_indices, const unsigned char* colors, int count,
+                          unsigned char* pixels) {
+  for (int i = 0; i < count; i++) {
+    pixels[i] = colors[color_indices[i]];
+  }
+}
+
+void DrawSpriteRowWithLoop(const unsigned char* color_row, const unsigned char* colors, bool behind_background,
+                           const unsigned char* background_indices, unsigned char* taken, unsigned char* pixels) {
+  for (int x = 0; x < Tile::kTileSize; x++) {
+    if (color_row[x] == 0 || taken[x] != 0) {
+      continue;
+    }
+    taken[x] = 0xff;
+    if (!behind_background || background_indices[x] == 0) {
+      pixels[x] = colors[color_row[x]];
+    }
+  }
+}
+
+void CheckDecode(LowerTileData* tile_data, vector<unsigned char>* raw) {
+  for (int low = 0; low < 0x100; low++) {
+    for (int high = 0; high < 0x100; high++) {
+      (*raw)[0] = low;
+      (*raw)[1] = high;
+      for (int x_flip = 0; x_flip < 2; x_flip++) {
+        unsigned char expected[Tile::kTileSize];
+        unsigned char actual[Tile::kTileSize];
+        DecodeWithTile(tile_data->tile(0), x_flip, expected);
+        DecodeTileRow(low, high, x_flip, actual);
+        for (int x = 0; x < Tile::kTileSize; x++) {
+          if (expected[x] != actual[x]) {
+            LOG(FATAL) << "DecodeTileRow disagrees for " << low << ", " << high << " at " << x;
+          }
+        }
+      }
+    }
+  }
+}
+
+void CheckDrawSpriteRow() {
+  const unsigned char colors[4] = {0, 64, 128, 192};
+  unsigned int seed = 54321;
+  for (int i = 0; i < 1 << 16; i++) {
+    unsigned char inputs[4][Tile::kTileSize];
+    for (auto& input : inputs) {
+      for (unsigned char& byte : input) {
+        seed = seed * 1103515245 + 12345;
+        byte = (seed >> 16) & 0b00000011;
+      }
+    }
+    unsigned char expected_taken[Tile::kTileSize];
+    unsigned char actual_taken[Tile::kTileSize];
+    unsigned char expected_pixels[Tile::kTileSize];
+    unsigned char actual_pixels[Tile::kTileSize];
+    for (int x = 0; x < Tile::kTileSize; x++) {
+      expected_taken[x] = actual_taken[x] = inputs[2][x] == 0 ? 0xff : 0;
+      expected_pixels[x] = actual_pixels[x] = inputs[3][x];
+    }
+    bool behind_background = (i & 1) != 0;
+    DrawSpriteRowWithLoop(inputs[0], colors, behind_background, inputs[1], expected_taken, expected_pixels);
+    DrawSpriteRow(inputs[0], colors, behind_background, inputs[1], actual_taken, actual_pixels);
+    for (int x = 0; x < Tile::kTileSize; x++) {
+      if (expected_taken[x] != actual_taken[x] || expected_pixels[x] != actual_pixels[x]) {
+        LOG(FATAL) << "DrawSpriteRow disagrees at " << x;
+      }
+    }
+  }
+}
+
+// Runs run kPasses times and prints how long each of count items took. run
+// returns a sum of its output so the work cannot be optimized away.
+template<typename Run>
+void Time(const char* name, int count, Run run) {
+  unsigned int sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < kPasses; pass++) {
+    sum += run();
+  }
+  auto end = std::chrono::steady_clock::now();
+  double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+  printf("%-22s %7.2f ns/op (sum %u)\n", name, nanoseconds / (static_cast<double>(kPasses) * count), sum);
+}
+} // namespace
+
+int main() {
+  vector<unsigned char> raw(0x1800, 0);
+  DecodedTiles decoded_tiles;
+  LowerTileData tile_data(&raw, &decoded_tiles);
+  CheckDecode(&tile_data, &raw);
+  CheckDrawSpriteRow();
+
+  const unsigned char colors[4] = {0, 64, 128, 192};
+  unsigned int seed = 12345;
+  for (unsigned char& byte : raw) {
+    seed = seed * 1103515245 + 12345;
+    byte = seed >> 16;
+  }
+  vector<unsigned char> color_indices(kLineWidth * kLines);
+  for (unsigned char& color_index : color_indices) {
+    seed = seed * 1103515245 + 12345;
+    color_index = (seed >> 16) & 0b00000011;
+  }
+  vector<unsigned char> pixels(kLineWidth * kLines);
+  vector<unsigned char> taken(kLineWidth * kLines);
+  const int tile_count = 256;
+  const int row_count = tile_count * Tile::kTileSize;
+
+  printf("Kernels: %s\n", back_end::graphics::PixelKernelsName());
+  Time("decode Tile::Get", row_count, [&]() {
+    unsigned int sum = 0;
+    unsigned char row[Tile::kTileSize];
+    for (int tile = 0; tile < tile_count; tile++) {
+      Tile* concrete = tile_data.tile(tile);
+      for (int y = 0; y < Tile::kTileSize; y++) {
+        for (int x = 0; x < Tile::kTileSize; x++) {
+          row[x] = concrete->Get(y, Tile::kTileSize - 1 - x);
+        }
+        sum += row[0] + row[7];
+      }
+    }
+    return sum;
+  });
+  Time("decode kernel", row_count, [&]() {
+    unsigned int sum = 0;
+    unsigned char row[Tile::kTileSize];
+    for (int i = 0; i < row_count; i++) {
+      DecodeTileRow(raw[i * 2], raw[i * 2 + 1], false, row);
+      sum += row[0] + row[7];
+    }
+    return sum;
+  });
+  Time("palette loop", kLines, [&]() {
+    for (int line = 0; line < kLines; line++) {
+      ApplyPaletteWithLoop(&color_indices[line * kLineWidth], colors, kLineWidth, &pixels[line * kLineWidth]);
+    }
+    return pixels[kLineWidth * kLines - 1];
+  });
+  Time("palette kernel", kLines, [&]() {
+    for (int line = 0; line < kLines; line++) {
+      ApplyPalette(&color_indices[line * kLineWidth], colors, kLineWidth, &pixels[line * kLineWidth]);
+    }
+    return pixels[kLineWidth * kLines - 1];
+  });
+  const int sprite_rows = kLineWidth * kLines / Tile::kTileSize - 1;
+  Time("sprite row loop", sprite_rows, [&]() {
+    std::fill(taken.begin(), taken.end(), 0);
+    for (int i = 0; i < sprite_rows; i++) {
+      int x = i * Tile::kTileSize;
+      DrawSpriteRowWithLoop(&color_indices[x + 1], colors, (i & 1) != 0, &color_indices[x], &taken[x], &pixels[x]);
+    }
+    return pixels[0] + taken[Tile::kTileSize];
+  });
+  Time("sprite row kernel", sprite_rows, [&]() {
+    std::fill(taken.begin(), taken.end(), 0);
+    for (int i = 0; i < sprite_rows; i++) {
+      int x = i * Tile::kTileSize;
+      DrawSpriteRow(&color_indices[x + 1], colors, (i & 1) != 0, &color_indices[x], &taken[x], &pixels[x]);
+    }
+    return pixels[0] + taken[Tile::kTileSize];
+  });
+  return 0;
+}
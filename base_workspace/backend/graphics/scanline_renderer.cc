@@ -0,0 +1,182 @@
+#include "backend/graphics/scanline_renderer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "backend/graphics/pixel_kernels.h"
+
+namespace back_end {
+namespace graphics {
+
+using memory::BackgroundMap;
+using memory::MapLayer;
+using memory::OAMSegment;
+using memory::SpriteAttribute;
+using memory::Tile;
+
+namespace {
+const int kScreenWidth = ScreenRaster::kScreenWidth;
+const int kMapSize = MapLayer::kSize;
+const int kSpriteYOffset = 16;
+const int kSpriteXOffset = 8;
+const int kWindowXOffset = 7;
+const int kLineBufferSize = kSpriteXOffset + kScreenWidth + kSpriteXOffset;
+
+// Sets color_indices from first to the end of the line to row, a row of a
+// MapLayer, starting map_x pixels in and wrapping around at the right edge.
+void CopyLayerRow(const unsigned char* row, int map_x, int first, unsigned char* color_indices) {
+  int x = first;
+  while (x < kScreenWidth) {
+    int length = std::min(kMapSize - map_x, kScreenWidth - x);
+    memcpy(color_indices + x, row + map_x, length);
+    x += length;
+    map_x = 0;
+  }
+}
+} // namespace
+
+void ScanlineRenderer::RenderLine(int line, ScreenRaster* raster) {
+  LCDControl* lcd_control = graphics_flags_->lcd_control();
+  // Padded on both sides by a sprite's width, so that a sprite partly off the
+  // screen can be drawn the same way as any other.
+  unsigned char color_indices[kLineBufferSize] = {};
+  unsigned char shades[kLineBufferSize] = {};
+  unsigned char colors[4];
+  if (lcd_control->bg_display()) {
+    RenderBackground(line, color_indices + kSpriteXOffset);
+    MonochromePalette* palette = graphics_flags_->background_palette();
+    for (int i = 0; i < 4; i++) {
+      colors[i] = palette->lookup(i);
+    }
+  } else {
+    // With the background off, the background and window are white, and
+    // count as color index 0 for the sprites behind them.
+    std::fill(color_indices + kSpriteXOffset, color_indices + kSpriteXOffset + kScreenWidth, 0);
+    std::fill(colors, colors + 4, MonochromePalette::WHITE);
+  }
+  ApplyPalette(color_indices + kSpriteXOffset, colors, kScreenWidth, shades + kSpriteXOffset);
+
+  if (lcd_control->sprite_display_enable()) {
+    RenderSprites(line, color_indices, shades);
+  }
+  raster->SetRow(line, shades + kSpriteXOffset);
+}
+
+void ScanlineRenderer::RenderBackground(int line, unsigned char* color_indices) {
+  LCDControl* lcd_control = graphics_flags_->lcd_control();
+  // Tile numbers count from -128, as UpperTileData does, unless the
+  // background and window use LowerTileData.
+  const bool signed_tiles = !lcd_control->bg_window_tile_data_select();
+
+  BackgroundMap* background;
+  if (lcd_control->bg_tile_map_display_select()) {
+    background = vram_segment_->upper_background_map();
+  } else {
+    background = vram_segment_->lower_background_map();
+  }
+  CopyLayerRow(background->layer()->row((line + graphics_flags_->scroll_y()->flag()) % kMapSize, signed_tiles),
+               graphics_flags_->scroll_x()->flag(),
+               0,
+               color_indices);
+
+  // The window's left edge is WX - 7, and may be off the left of the screen.
+  int window_x = graphics_flags_->window_x_position()->flag() - kWindowXOffset;
+  if (!lcd_control->window_display_enable() ||
+      line < graphics_flags_->window_y_position()->flag() ||
+      window_x >= kScreenWidth) {
+    return;
+  }
+
+  BackgroundMap* window;
+  if (lcd_control->window_tile_map_display_select()) {
+    window = vram_segment_->upper_background_map();
+  } else {
+    window = vram_segment_->lower_background_map();
+  }
+  int first = std::max(window_x, 0);
+  CopyLayerRow(window->layer()->row(window_line_, signed_tiles), first - window_x, first, color_indices);
+  window_line_++;
+}
+
+void ScanlineRenderer::RenderSprites(int line, const unsigned char* color_indices, unsigned char* shades) {
+  const int height = graphics_flags_->lcd_control()->sprite_size() ? 2 * Tile::kTileSize : Tile::kTileSize;
+  UpdateLineSprites(height);
+
+  // Where sprites overlap, the one further left wins, then the one first in
+  // OAM. The winner is the first with a color index other than 0 at a pixel,
+  // whether or not the background then hides it.
+  const LineSprites& sprites = line_sprites_[line];
+  unsigned char taken[kLineBufferSize] = {};
+  for (int i = 0; i < sprites.count; i++) {
+    // Sprites are placed with their right edge at x, so one at 0 or from
+    // kScreenWidth + 8 on is entirely off the screen.
+    if (sprites.x[i] == 0 || sprites.x[i] >= kScreenWidth + kSpriteXOffset) {
+      continue;
+    }
+    SpriteAttribute* sprite_attribute = oam_segment_->sprite_attribute(sprites.index[i]);
+    int row = line - (sprite_attribute->y() - kSpriteYOffset);
+    if (sprite_attribute->y_flip()) {
+      row = height - 1 - row;
+    }
+    // Tall sprites are an even tile followed by the odd one after it.
+    unsigned char tile_index = sprite_attribute->tile_index();
+    if (height > Tile::kTileSize) {
+      tile_index = (tile_index & 0b11111110) | (row / Tile::kTileSize);
+    }
+    const unsigned char* color_row = vram_segment_->lower_tile_data()->decoded_row(
+        tile_index, row % Tile::kTileSize, sprite_attribute->x_flip());
+
+    MonochromePalette* palette;
+    if (sprite_attribute->palette()) {
+      palette = graphics_flags_->object_palette_1();
+    } else {
+      palette = graphics_flags_->object_palette_0();
+    }
+    // Color index 0 is transparent, so its color is never used.
+    unsigned char colors[4] = {0};
+    for (int color_index = 1; color_index < 4; color_index++) {
+      colors[color_index] = palette->lookup(color_index);
+    }
+
+    // Where the sprite starts in the padded buffers.
+    int x = sprites.x[i];
+    DrawSpriteRow(color_row, colors, sprite_attribute->behind_background(),
+                  color_indices + x, taken + x, shades + x);
+  }
+}
+
+void ScanlineRenderer::UpdateLineSprites(int height) {
+  if (oam_segment_->writes() == line_sprites_writes_ && height == line_sprites_height_) {
+    return;
+  }
+  line_sprites_writes_ = oam_segment_->writes();
+  line_sprites_height_ = height;
+
+  for (LineSprites& sprites : line_sprites_) {
+    sprites.count = 0;
+  }
+  for (int i = 0; i < OAMSegment::kAttributeNumber; i++) {
+    SpriteAttribute* sprite_attribute = oam_segment_->sprite_attribute(i);
+    const int top = sprite_attribute->y() - kSpriteYOffset;
+    const unsigned char x = sprite_attribute->x();
+    const int bottom = std::min(top + height, static_cast<int>(ScreenRaster::kScreenHeight));
+    for (int line = std::max(top, 0); line < bottom; line++) {
+      LineSprites* sprites = &line_sprites_[line];
+      if (sprites->count == kMaxSpritesPerLine) {
+        continue;
+      }
+      // Sprites come in OAM order, so each goes after any others at its x.
+      int position = sprites->count++;
+      while (position > 0 && sprites->x[position - 1] > x) {
+        sprites->x[position] = sprites->x[position - 1];
+        sprites->index[position] = sprites->index[position - 1];
+        position--;
+      }
+      sprites->x[position] = x;
+      sprites->index[position] = i;
+    }
+  }
+}
+
+} // namespace graphics
+} // namespace back_end
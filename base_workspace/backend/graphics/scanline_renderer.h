@@ -0,0 +1,71 @@
+#ifndef TURBO_SANTA_COMMON_BACK_END_GRAPHICS_SCANLINE_RENDERER_H_
+#define TURBO_SANTA_COMMON_BACK_END_GRAPHICS_SCANLINE_RENDERER_H_
+
+#include "backend/graphics/graphics_flags.h"
+#include "backend/graphics/screen.h"
+#include "backend/memory/vram_segment.h"
+
+namespace back_end {
+namespace graphics {
+
+// Draws the screen one line at a time, as the LCD does in mode 3: the
+// background under the line, scrolled by SCX and SCY and wrapping around the
+// edges of its map, the window over it from WX and WY on, and then the sprites
+// on the line. Everything is read as it is when the line is drawn, so a game
+// that changes the registers between lines sees the change on the screen.
+class ScanlineRenderer {
+ public:
+  ScanlineRenderer(GraphicsFlags* graphics_flags,
+                   memory::VRAMSegment* vram_segment,
+                   memory::OAMSegment* oam_segment) :
+      graphics_flags_(graphics_flags), vram_segment_(vram_segment), oam_segment_(oam_segment) {}
+
+  // Called at the start of line 0. The window counts the lines it has drawn
+  // this frame rather than using LY, so it picks up where it left off if it
+  // is turned off and on again.
+  void StartFrame() { window_line_ = 0; }
+
+  // Only the window's line; the sprites on each line are worked out again
+  // since loading OAM counts as writing to it.
+  void SaveState(memory::StateWriter* writer) { writer->Write8(window_line_); }
+  void LoadState(memory::StateReader* reader) { window_line_ = reader->Read8(); }
+
+  // Draws line of the screen into raster.
+  void RenderLine(int line, ScreenRaster* raster);
+
+  static const int kMaxSpritesPerLine = 10;
+
+ private:
+  // Sets color_indices to the background and window color index under each
+  // pixel of line.
+  void RenderBackground(int line, unsigned char* color_indices);
+  // Draws the shades of the sprites on line over shades, except where one is
+  // behind a background color index other than 0. Both are padded on each
+  // side by a sprite's width.
+  void RenderSprites(int line, const unsigned char* color_indices, unsigned char* shades);
+  // Works out line_sprites_ again if OAM has been written to or the sprites
+  // have changed height since the last time.
+  void UpdateLineSprites(int height);
+
+  // The sprites drawn on a line: the first kMaxSpritesPerLine in OAM on it,
+  // ordered by x and then by where they are in OAM.
+  struct LineSprites {
+    int count = 0;
+    unsigned char x[kMaxSpritesPerLine];
+    unsigned char index[kMaxSpritesPerLine];
+  };
+
+  GraphicsFlags* graphics_flags_;
+  memory::VRAMSegment* vram_segment_;
+  memory::OAMSegment* oam_segment_;
+  int window_line_ = 0;
+  LineSprites line_sprites_[ScreenRaster::kScreenHeight];
+  unsigned long line_sprites_writes_ = 0;
+  // No sprite is 0 high, so the lines are worked out on the first frame.
+  int line_sprites_height_ = 0;
+};
+
+} // namespace graphics
+} // namespace back_end
+
+#endif // TURBO_SANTA_COMMON_BACK_END_GRAPHICS_SCANLINE_RENDERER_H_
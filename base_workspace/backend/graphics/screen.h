@@ -2,15 +2,70 @@
 #define TURBO_SANTA_COMMON_BACK_END_GRAPHICS_SCREEN_H_
 
 #include <vector>
+#include "backend/graphics/pixel_kernels.h"
 #include "submodules/glog/src/glog/logging.h"
 
 namespace back_end {
 namespace graphics {
 
+// How a ScreenRaster stores its pixels, so that a frontend can be handed the
+// frame as drawn, in whatever form it wants it, without converting it.
+enum PixelFormat {
+  // One byte per pixel, from 0 for white up to 192 for black in steps of 64.
+  SHADE8 = 0,
+  // One byte per pixel, from 0 for white up to 3 for black.
+  INDEX8 = 1,
+  // Two bytes per pixel, little endian, red in the top five bits.
+  RGB565 = 2,
+  // Four bytes per pixel: red, green, blue and alpha.
+  RGBA8888 = 3
+};
+
+// The four shades of the LCD as each PixelFormat stores them, lightest first.
+const unsigned int kShadeValues[4][4] = {
+  {0, 64, 128, 192},
+  {0, 1, 2, 3},
+  {0xffff, 0xad55, 0x52aa, 0x0000},
+  {0xffffffff, 0xffaaaaaa, 0xff555555, 0xff000000},
+};
+
 class ScreenRaster {
  public:
-  ScreenRaster() : data_(kScreenWidth * kScreenHeight, 0x00) {}
+  // Keeps its own pixels unless given data, a buffer of FrameBytes(format)
+  // bytes that the caller keeps alive for as long as this is used.
+  ScreenRaster(PixelFormat format = SHADE8, unsigned char* data = nullptr) :
+      format_(format),
+      own_data_(data == nullptr ? FrameBytes(format) : 0, 0x00),
+      data_(data == nullptr ? own_data_.data() : data) {}
+
+  // Copies of a raster with its own pixels get their own copy of them, and
+  // copies of one drawing into a caller's buffer draw into the same buffer.
+  ScreenRaster(const ScreenRaster& other) :
+      format_(other.format_), own_data_(other.own_data_),
+      data_(own_data_.empty() ? other.data_ : own_data_.data()) {}
+
+  ScreenRaster& operator=(const ScreenRaster& other) {
+    format_ = other.format_;
+    own_data_ = other.own_data_;
+    data_ = own_data_.empty() ? other.data_ : own_data_.data();
+    return *this;
+  }
+
+  static int BytesPerPixel(PixelFormat format) {
+    return format == RGBA8888 ? 4 : format == RGB565 ? 2 : 1;
+  }
+
+  static int FrameBytes(PixelFormat format) {
+    return kScreenWidth * kScreenHeight * BytesPerPixel(format);
+  }
+
+  PixelFormat format() const { return format_; }
+
+  // The whole frame, a row at a time from the top, with no gaps.
+  const unsigned char* data() const { return data_; }
+  int size() const { return FrameBytes(format_); }
 
+  // Get and Set are only for the formats with one byte per pixel.
   unsigned char Get(unsigned int y, unsigned int x) const {
     Check(y, x);
     return data_[x + kScreenWidth * y];
@@ -21,21 +76,52 @@ class ScreenRaster {
     data_[x + kScreenWidth * y] = value;
   }
 
+  // Stores line y from kScreenWidth shades, each from 0 for white to 3 for
+  // black.
+  void SetRow(unsigned int y, const unsigned char* shades) {
+    if (y >= kScreenHeight) {
+      LOG(FATAL) << "Attempted access out of bounds: y = " << y;
+    }
+    const unsigned int* values = kShadeValues[format_];
+    const int bytes_per_pixel = BytesPerPixel(format_);
+    unsigned char* row = data_ + kScreenWidth * bytes_per_pixel * y;
+    if (bytes_per_pixel == 1) {
+      const unsigned char colors[4] = {
+        static_cast<unsigned char>(values[0]), static_cast<unsigned char>(values[1]),
+        static_cast<unsigned char>(values[2]), static_cast<unsigned char>(values[3])
+      };
+      ApplyPalette(shades, colors, kScreenWidth, row);
+      return;
+    }
+    for (int x = 0; x < kScreenWidth; x++) {
+      unsigned int value = values[shades[x]];
+      for (int byte = 0; byte < bytes_per_pixel; byte++) {
+        row[x * bytes_per_pixel + byte] = (value >> (8 * byte)) & 0xff;
+      }
+    }
+  }
+
   static const int kScreenHeight = 144;
   static const int kScreenWidth = 160;
-  
+
  private:
   void Check(unsigned int y, unsigned int x) const {
+    if (BytesPerPixel(format_) != 1) {
+      LOG(FATAL) << "Attempted to access a pixel of more than one byte.";
+    }
     if (y >= kScreenHeight || x >= kScreenWidth) {
       LOG(FATAL) << "Attempted access out of bounds: y = " << y << " x = " << x;
     }
   }
 
-  std::vector<unsigned char> data_;
+  PixelFormat format_;
+  std::vector<unsigned char> own_data_;
+  unsigned char* data_;
 };
 
 class Screen {
  public:
+  // raster stays as it is until Draw returns, and no longer.
   virtual void Draw(const ScreenRaster& raster) = 0;
 };
 
@@ -2,13 +2,14 @@
 
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include <vector>
 
-#include <errno.h>
+#include <locale.h>
 #include <stdio.h>
-#include <string.h>
 
 #include "backend/clocktroller/clocktroller.h"
+#include "backend/memory/rom_image.h"
 // #include "backend/debugger/frames.h"
 // #include "backend/debugger/deltas.h"
 // #include "backend/debugger/great_library.h"
@@ -19,6 +20,7 @@ using std::cout;
 using std::endl;
 using std::hex;
 using std::dec;
+using std::shared_ptr;
 using std::string;
 using std::vector;
 using back_end::clocktroller::Clocktroller;
@@ -27,6 +29,7 @@ using back_end::clocktroller::Clocktroller;
 // using back_end::debugger::MemoryDelta;
 // using back_end::debugger::GreatLibrary;
 using back_end::graphics::Screen;
+using back_end::memory::ROMImage;
 using back_end::graphics::ScreenRaster;
 
 static const int kNintendoLogoStartPosition = 0x104;
@@ -40,30 +43,88 @@ static const vector<unsigned char> kNintendoLogo = {
     0xdd, 0xdc, 0x99, 0x9f, 0xbb, 0xb9, 0x33, 0x3e
   }; 
 
+// Not a TerminalScreen cell value, so that a cell set to it is drawn next time.
+static const unsigned char kUnknownCell = 0xff;
+
+// Draws two pixel rows to a cell: an upper half block in the shade of the top
+// pixel over the shade of the bottom one. Remembers what each cell was last
+// drawn as and only draws the cells that changed, so that curses has little to
+// do and a still screen sends nothing to the terminal at all. Draw is called
+// from the Clocktroller's FramePresenter thread, which is the only one to use
+// curses between initscr and endwin.
 class TerminalScreen : public Screen {
  public:
   virtual void Draw(const ScreenRaster& raster) {
-    const int realized_width = std::min(COLS, LINES);
-    for (int y = 0; y < ScreenRaster::kScreenHeight; y++) {
-      for (int x = 0; x < ScreenRaster::kScreenWidth; x++) {
-        unsigned char pixel_shade = raster.Get(y, x);
-        char real_pixel;
-        if (pixel_shade <= 64) {
-          real_pixel = ' ';
-        } else if (pixel_shade <= 128) {
-          real_pixel = '.';
-        } else if (pixel_shade <= 192) {
-          real_pixel = '*';
-        } else {
-          real_pixel = '#';
+    if (cell_looks_.empty()) {
+      StartLooks();
+    }
+    const int rows = std::min(LINES, kCellRows);
+    const int columns = std::min(COLS, static_cast<int>(ScreenRaster::kScreenWidth));
+    if (rows != rows_ || columns != columns_) {
+      rows_ = rows;
+      columns_ = columns;
+      cells_.assign(rows_ * columns_, kUnknownCell);
+      clear();
+    }
+
+    bool changed = false;
+    for (int row = 0; row < rows_; row++) {
+      // Terminals smaller than the screen get every so many pixels.
+      const int top_y = 2 * row * ScreenRaster::kScreenHeight / (2 * rows_);
+      const int bottom_y = (2 * row + 1) * ScreenRaster::kScreenHeight / (2 * rows_);
+      for (int column = 0; column < columns_; column++) {
+        const int x = column * ScreenRaster::kScreenWidth / columns_;
+        unsigned char cell = Shade(raster, top_y, x) * 4 + Shade(raster, bottom_y, x);
+        unsigned char* last_cell = &cells_[row * columns_ + column];
+        if (*last_cell == cell) {
+          continue;
         }
+        *last_cell = cell;
+        mvadd_wch(row, column, &cell_looks_[cell]);
+        changed = true;
+      }
+    }
+    if (changed) {
+      refresh();
+    }
+  }
+
+ private:
+  static const int kCellRows = ScreenRaster::kScreenHeight / 2;
 
-        move(y * realized_width / ScreenRaster::kScreenHeight, x * 2 * realized_width / ScreenRaster::kScreenWidth);
-        addch(real_pixel);
+  // The shade of a pixel of a SHADE8 frame, from 0 for white to 3 for black.
+  static unsigned char Shade(const ScreenRaster& raster, int y, int x) {
+    return raster.Get(y, x) / 64;
+  }
+
+  // Makes a look for each of the 16 cells: a color pair per pair of shades,
+  // or on terminals without color, the old characters for the darker shade.
+  void StartLooks() {
+    cell_looks_.resize(16);
+    const bool has_color = has_colors() && start_color() == OK && COLOR_PAIRS > 16;
+    // White, light gray, dark gray and black; 8 color terminals have no grays.
+    const short kGrays[4] = {231, 248, 240, 16};
+    const short kBasicColors[4] = {COLOR_WHITE, COLOR_CYAN, COLOR_BLUE, COLOR_BLACK};
+    const short* colors = COLORS >= 256 ? kGrays : kBasicColors;
+    const wchar_t kShadeCharacters[4][2] = {L" ", L".", L"*", L"#"};
+    for (int top = 0; top < 4; top++) {
+      for (int bottom = 0; bottom < 4; bottom++) {
+        const int cell = top * 4 + bottom;
+        if (has_color) {
+          init_pair(cell + 1, colors[top], colors[bottom]);
+          setcchar(&cell_looks_[cell], L"\u2580", A_NORMAL, cell + 1, nullptr);
+        } else {
+          setcchar(&cell_looks_[cell], kShadeCharacters[std::max(top, bottom)], A_NORMAL, 0, nullptr);
+        }
       }
     }
-    refresh();
   }
+
+  vector<cchar_t> cell_looks_;
+  // The cell value drawn at each position: top shade * 4 + bottom shade.
+  vector<unsigned char> cells_;
+  int rows_ = 0;
+  int columns_ = 0;
 };
 
 vector<unsigned char> BuildROM() {
@@ -75,27 +136,6 @@ vector<unsigned char> BuildROM() {
   return rom;
 }
 
-vector<unsigned char> ReadROM(string file_name) {
-  vector<unsigned char> rom;
-  FILE* file = fopen(file_name.c_str(), "r");
-  if (file == nullptr) {
-    LOG(FATAL) << "Cannot read file " << file_name << ": " << strerror(errno);
-  }
-
-  const int buffer_size = 1024;
-  vector<unsigned char> buffer(buffer_size);
-  int amount_read = 0;
-  do {
-    amount_read = fread(buffer.data(), 1, buffer_size, file);
-    // TODO(Brendan): Should not copy the entire buffer since buffer may not be
-    // entirely filled.
-    rom.insert(rom.end(), buffer.begin(), buffer.end());
-  } while (amount_read == buffer_size);
-
-  fclose(file);
-  return rom;
-}
-
 // void printFrame(Frame& frame) {
 //   cout << "Event: " << frame.event() << endl;
 //   cout << "Timestamp: " << dec << frame.timestamp() << endl;
@@ -220,20 +260,28 @@ vector<unsigned char> ReadROM(string file_name) {
 // }
 
 int main(int argc, char* argv[]) {
-  if (argc != 2) {
-    printf("Please provide the name of the ROM\n");
+  back_end::handlers::ExecutionMode mode = back_end::handlers::INTERPRETER;
+  if (argc == 3 && string(argv[1]) == "--jit") {
+    mode = back_end::handlers::JIT;
+    argv++;
+  } else if (argc != 2) {
+    printf("Usage: %s [--jit] ROM\n", argv[0]);
     return -1;
   }
 
   TerminalScreen terminal_screen;
 //   GreatLibrary great_library;
-  vector<unsigned char> rom = ReadROM(argv[1]);
+  shared_ptr<const ROMImage> rom = ROMImage::Open(argv[1]);
   LOG(INFO) << "Finished reading rom";
   Clocktroller clocktroller(&terminal_screen);
   LOG(INFO) << "Clocktroller built";
 
+  // For the half blocks.
+  setlocale(LC_ALL, "");
   initscr();
-  clocktroller.Init(rom.data(), rom.size());
+  curs_set(0);
+  leaveok(stdscr, TRUE);
+  clocktroller.Init(rom, mode);
   clocktroller.Run();
   clocktroller.Wait();
   endwin();
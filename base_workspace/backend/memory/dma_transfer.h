@@ -2,40 +2,80 @@
 #define TURBO_SANTA_COMMON_BACK_END_MEMORY_DMA_TRANSFER_H_
 
 #include <memory>
+#include "backend/clocktroller/scheduler.h"
 #include "backend/memory/flags.h"
 #include "backend/memory/memory_mapper.h"
 #include "backend/memory/module.h"
+#include "backend/memory/vram_segment.h"
 
 namespace back_end {
 namespace memory {
 
-class DMATransferFlag : public Flag {
+// Copies a page of memory to OAM. The hardware copies a byte a machine cycle
+// for 160 machine cycles, with the bus to itself; here the copy is made all at
+// once when the transfer starts, since only high RAM and the IO ports, which
+// the CPU can still use, could tell it apart, and the bus stays locked for as
+// long as the copy would have taken.
+class DMATransferFlag : public Flag, public clocktroller::TimedEvent {
  public:
-  DMATransferFlag(MemoryMapper* mapper) : Flag(0xff46), mapper_(mapper) {}
+  DMATransferFlag(MemoryMapper* mapper, OAMSegment* oam_segment, clocktroller::Scheduler* scheduler) :
+      Flag(0xff46), mapper_(mapper), oam_segment_(oam_segment), scheduler_(scheduler) {}
 
   unsigned char Read(unsigned short) { return 0xff; }
+  const unsigned char* backing_byte() { return nullptr; }
 
+  // Starts a transfer from value * 0x100, which starts over if one is already
+  // running.
   void Write(unsigned short, unsigned char value) {
-    // TODO(Brendan): This should actually take the expected amount of time.
-    // This should also disable all memory outside of high RAM.
-    unsigned short source_address = value * 0x100;
-    unsigned short destination_address = 0xfe00;
-    while (destination_address <= 0xfe9f) {
-      unsigned char value = mapper_->Read(source_address);
-      mapper_->Write(destination_address, value);
-      source_address++;
-      destination_address++;
+    unsigned char values[kTransferBytes];
+    mapper_->ReadBlock(value * 0x100, kTransferBytes, values);
+    oam_segment_->WriteBlock(values);
+    mapper_->TellWriteListeners(OAMSegment::kStartAddress, kTransferBytes);
+    mapper_->LockBus();
+    end_ = scheduler_->now() + kTransferCycles;
+    scheduler_->Schedule(this, end_);
+  }
+
+  // The transfer is over.
+  virtual void Fire(uint64_t) { mapper_->UnlockBus(); }
+
+  // Whether a transfer is running and when it ends; OAM has its copy already.
+  // Loading expects the Scheduler to have been cleared.
+  virtual void SaveState(StateWriter* writer) {
+    writer->WriteBool(mapper_->bus_locked());
+    writer->Write64(end_);
+  }
+
+  virtual void LoadState(StateReader* reader) {
+    bool running = reader->ReadBool();
+    end_ = reader->Read64();
+    if (running) {
+      mapper_->LockBus();
+      scheduler_->Schedule(this, end_);
+    } else {
+      mapper_->UnlockBus();
     }
   }
 
  private:
+  static const int kTransferBytes = OAMSegment::kEndAddress - OAMSegment::kStartAddress + 1;
+  // 160 machine cycles of 4 clocks each.
+  static const int kTransferCycles = kTransferBytes * 4;
+
   MemoryMapper* mapper_;
+  OAMSegment* oam_segment_;
+  clocktroller::Scheduler* scheduler_;
+  uint64_t end_ = 0;
 };
 
 class DMATransferModule : public Module {
  public:
-  void Init(MemoryMapper* memory_mapper) {
-    flag_ = std::unique_ptr<DMATransferFlag>(new DMATransferFlag(memory_mapper));
+  void Init(MemoryMapper* memory_mapper, OAMSegment* oam_segment, clocktroller::Scheduler* scheduler) {
+    // A transfer still running from before is dropped along with its flag.
+    if (flag_ != nullptr) {
+      scheduler->Cancel(flag_.get());
+    }
+    flag_ = std::unique_ptr<DMATransferFlag>(new DMATransferFlag(memory_mapper, oam_segment, scheduler));
     add_flag(flag_.get());
   }
 
@@ -33,6 +33,15 @@ class EchoSegment : public ContiguousMemorySegment {
     }
   }
 
+  // Pages line up with the two RAM segments, so each page is inside one.
+  virtual const unsigned char* read_pointer(unsigned short page_address) {
+    return ram_for(page_address)->read_pointer(translate_address(page_address));
+  }
+
+  virtual unsigned char* write_pointer(unsigned short page_address) {
+    return ram_for(page_address)->write_pointer(translate_address(page_address));
+  }
+
  protected:
   virtual unsigned short lower_address_bound() { return 0xe000; }
   virtual unsigned short upper_address_bound() { return 0xfdff; }
@@ -44,6 +53,13 @@ class EchoSegment : public ContiguousMemorySegment {
   virtual unsigned short translate_address(unsigned short address) {
     return address - (lower_address_bound() - 0xc000);
   }
+
+  RAMSegment* ram_for(unsigned short address) {
+    if (internal_ram_0_->InRange(translate_address(address))) {
+      return internal_ram_0_;
+    }
+    return internal_ram_1_;
+  }
 };
 
 } // namespace memory
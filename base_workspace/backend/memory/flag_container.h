@@ -1,9 +1,9 @@
 #ifndef TURBO_SANTA_COMMON_BACK_END_MEMORY_FLAG_CONTAINER_H_
 #define TURBO_SANTA_COMMON_BACK_END_MEMORY_FLAG_CONTAINER_H_
 
-#include <vector>
 #include "backend/memory/flags.h"
 #include "backend/memory/memory_segment.h"
+#include "submodules/glog/src/glog/logging.h"
 
 // All flags, with the exception of the interrupt enable flag lie within the IO
 // ports address space.
@@ -11,36 +11,81 @@
 namespace back_end {
 namespace memory {
 
-class FlagContainer : public ContiguousMemorySegment {
+// Holds a slot for each address in the IO ports, 0xff00 - 0xff7f, indexed by
+// the low byte of the address, and one more for the interrupt enable flag at
+// 0xffff. The slots are filled in by add_flag, so an access is a single
+// lookup. Flags whose reads are plain loads are read through their backing
+// byte without a call. Addresses with no flag read as 0 and ignore writes.
+class FlagContainer : public MemorySegment {
  public:
   unsigned char Read(unsigned short address) {
-    for (Flag* flag : flags_) {
-      if (flag->InRange(address)) {
-        return flag->Read(address);
-      }
+    const Slot& slot = slots_[SlotIndex(address)];
+    if (slot.byte != nullptr) {
+      return *slot.byte;
+    } else if (slot.flag != nullptr) {
+      return slot.flag->Read(address);
     }
     return 0;
   }
 
   void Write(unsigned short address, unsigned char value) {
-    for (Flag* flag : flags_) {
-      if (flag->InRange(address)) {
-        flag->Write(address, value);
-        return;
+    Flag* flag = slots_[SlotIndex(address)].flag;
+    if (flag != nullptr) {
+      flag->Write(address, value);
+    }
+  }
+
+  virtual bool InRange(unsigned short address) {
+    return (address >= kLowerAddressBound && address <= kUpperAddressBound) ||
+        (address == kInterruptEnableAddress && slots_[kInterruptEnableSlot].flag != nullptr);
+  }
+
+  // Each flag that has a slot saves itself, in address order.
+  virtual void SaveState(StateWriter* writer) {
+    for (const Slot& slot : slots_) {
+      if (slot.flag != nullptr) {
+        slot.flag->SaveState(writer);
       }
     }
   }
 
-  void add_flag(Flag* flag) { flags_.push_back(flag); }
+  virtual void LoadState(StateReader* reader) {
+    for (const Slot& slot : slots_) {
+      if (slot.flag != nullptr) {
+        slot.flag->LoadState(reader);
+      }
+    }
+  }
 
- protected:
-  std::vector<Flag*> flags_;
+  // If two flags share an address, the one added first is used.
+  void add_flag(Flag* flag) {
+    unsigned short address = flag->address();
+    if (!InRange(address) && address != kInterruptEnableAddress) {
+      LOG(FATAL) << "Flag outside of the IO ports: 0x" << std::hex << address;
+    }
+    Slot& slot = slots_[SlotIndex(address)];
+    if (slot.flag == nullptr) {
+      slot.flag = flag;
+      slot.byte = flag->backing_byte();
+    }
+  }
 
-  // Inclusive lower bound of this memory segment.
-  virtual unsigned short lower_address_bound() { return 0xff00; } 
+ private:
+  static const unsigned short kLowerAddressBound = 0xff00;
+  static const unsigned short kUpperAddressBound = 0xff7f;
+  static const unsigned short kInterruptEnableAddress = 0xffff;
+  static const int kInterruptEnableSlot = kUpperAddressBound - kLowerAddressBound + 1;
+
+  struct Slot {
+    Flag* flag = nullptr;
+    const unsigned char* byte = nullptr;
+  };
+
+  static int SlotIndex(unsigned short address) {
+    return address == kInterruptEnableAddress ? kInterruptEnableSlot : address & 0x7f;
+  }
 
-  // Inclusive upper bound of this memory segment.
-  virtual unsigned short upper_address_bound() { return 0xff7f; }
+  Slot slots_[kInterruptEnableSlot + 1];
 };
 
 } // namespace memory
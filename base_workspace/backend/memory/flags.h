@@ -16,6 +16,14 @@ class Flag : public SingleAddressSegment {
   virtual unsigned char flag() { return flag_; }
   virtual void set_flag(unsigned char value) { flag_ = value; }
 
+  // The byte a read of this flag returns, so that FlagContainer can load it
+  // without calling Read. Subclasses that override Read must override this,
+  // returning nullptr if a read has to go through Read.
+  virtual const unsigned char* backing_byte() { return &flag_; }
+
+  virtual void SaveState(StateWriter* writer) { writer->Write8(flag_); }
+  virtual void LoadState(StateReader* reader) { flag_ = reader->Read8(); }
+
  protected:
   // Returns whether an individual bit is set.
   bool bit(int bit) { return ((0b00000001 << bit) & flag_) != 0; }
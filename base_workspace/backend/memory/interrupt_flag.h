@@ -33,15 +33,10 @@ class InterruptBase : public Flag {
   InterruptBase(unsigned short address) : Flag(address) {}
 
   virtual unsigned char Read(unsigned short) { return value_; }
-  virtual void Write(unsigned short, unsigned char value) { 
-    value_ = value;
-    LOG(INFO) << "Interrupt flag written to.";
-    LOG(INFO) << "v_blank = " << v_blank();
-    LOG(INFO) << "lcd_stat = " << lcd_stat();
-    LOG(INFO) << "timer = " << timer();
-    LOG(INFO) << "serial = " << serial();
-    LOG(INFO) << "joypad = " << joypad();
-  }
+  virtual const unsigned char* backing_byte() { return &value_; }
+  virtual void SaveState(StateWriter* writer) { writer->Write8(value_); }
+  virtual void LoadState(StateReader* reader) { value_ = reader->Read8(); }
+  virtual void Write(unsigned short, unsigned char value) { value_ = value; }
   virtual bool v_blank() { return value_bit(0); }
   virtual bool lcd_stat() { return value_bit(1); }
   virtual bool timer() { return value_bit(2); }
@@ -1,83 +1,76 @@
 #include "backend/memory/mbc.h"
 
 #include <stdio.h>
+#include <algorithm>
+#include <utility>
 #include "submodules/glog/src/glog/logging.h"
 
 namespace back_end {
 namespace memory {
 
+using std::shared_ptr;
 using std::unique_ptr;
 using std::vector;
 
 // TODO(Brendan): Finish this.
-MBC* CreateNoMBC(unsigned char* program_rom, long size) {
+MBC* CreateNoMBC(shared_ptr<const ROMImage> program_rom) {
   ROMBank rom_bank_0;
   ROMBank rom_bank_1;
   RAMBank ram_bank_0;
-  CreateROMBanks(program_rom, size, &rom_bank_0, &rom_bank_1);
-  return new NoMBC(rom_bank_0, rom_bank_1, ram_bank_0);
+  CreateROMBanks(program_rom, &rom_bank_0, &rom_bank_1);
+  return new NoMBC(std::move(rom_bank_0), std::move(rom_bank_1), std::move(ram_bank_0));
 }
 
-MBC* CreateMBC1(unsigned char* program_rom, long size) {
+MBC* CreateMBC1(shared_ptr<const ROMImage> program_rom) {
   ROMBank rom_bank_0;
   vector<ROMBank> rom_bank_n;
   vector<RAMBank> ram_bank_n;
-  CreateROMBanks(program_rom, size, &rom_bank_0, &rom_bank_n);
+  CreateROMBanks(program_rom, &rom_bank_0, &rom_bank_n);
   CreateRAMBanks(4, &ram_bank_n);
-  return new MBC1(rom_bank_0, rom_bank_n, ram_bank_n);
+  return new MBC1(std::move(rom_bank_0), std::move(rom_bank_n), std::move(ram_bank_n));
 }
 
-void CreateROMBanks(unsigned char* rom, long rom_size, ROMBank* rom_bank_0, ROMBank* rom_bank_1) {
-  int address = 0;
-  int i = 0;
-  while (i < MBC::kROMBank0Size && address < rom_size) {
-    rom_bank_0->memory_[i] = rom[address];
-    address++;
-    i++;
+void CreateROMBanks(shared_ptr<const ROMImage> rom, ROMBank* rom_bank_0, ROMBank* rom_bank_1) {
+  if (rom->size() > 0) {
+    *rom_bank_0 = ROMBank(rom, 0);
   }
-
-  i = 0;
-  while (i < MBC::kROMBankNSize && address < rom_size) {
-    rom_bank_1->memory_[i] = rom[address];
-    address++;
-    i++;
+  if (rom->size() > MBC::kROMBank0Size) {
+    *rom_bank_1 = ROMBank(rom, MBC::kROMBank0Size);
   }
 }
 
-void CreateROMBanks(unsigned char* rom, long rom_size, ROMBank* rom_bank_0, std::vector<ROMBank>* rom_bank_n) {
+void CreateROMBanks(shared_ptr<const ROMImage> rom, ROMBank* rom_bank_0, std::vector<ROMBank>* rom_bank_n) {
   LOG(INFO) << "Creating ROM banks";
-  LOG(INFO) << "ROM size = " << rom_size;
-
-  int address = 0;
-  int i = 0;
-  while (i < MBC::kROMBank0Size && address < rom_size) {
-    rom_bank_0->memory_[i] = rom[address];
-    address++;
-    i++;
+  LOG(INFO) << "ROM size = " << rom->size();
+
+  if (rom->size() > 0) {
+    *rom_bank_0 = ROMBank(rom, 0);
   }
-  LOG(INFO) << "Created ROM 0";
-
-  int n = 1;
-  while (address < rom_size) {
-    ROMBank rom_bank;
-    i = 0;
-    while (i < MBC::kROMBankNSize && address < rom_size) {
-      rom_bank.memory_[i] = rom[address];
-      address++;
-      i++;
-    }
-    rom_bank_n->push_back(rom_bank);
-    LOG(INFO) << "Created ROM " <<  n;
-    n++;
+  for (long offset = MBC::kROMBank0Size; offset < rom->size(); offset += MBC::kROMBankNSize) {
+    rom_bank_n->push_back(ROMBank(rom, offset));
+  }
+  LOG(INFO) << "Created " << rom_bank_n->size() + 1 << " ROM banks";
+}
+
+ROMBank::ROMBank(shared_ptr<const ROMImage> image, long offset) : offset_(offset) {
+  if (offset + MBC::kROMBankNSize <= image->size()) {
+    image_ = std::move(image);
+  } else {
+    copy_.resize(MBC::kROMBankNSize, 0x00);
+    std::copy(image->data() + offset, image->data() + image->size(), copy_.begin());
   }
 }
 
 unsigned char ROMBank::Read(unsigned short address) {
-  return memory_[address];
+  return data()[address];
 }
 
 void ROMBank::ForceWrite(unsigned short address, unsigned char value) {
-  memory_[address] = value;
+  if (copy_.empty()) {
+    copy_.assign(data(), data() + MBC::kROMBankNSize);
+    image_.reset();
+  }
+  copy_[address] = value;
 }
 
 void CreateRAMBanks(int bank_number, vector<RAMBank>* ram_bank_n) {
@@ -94,8 +87,11 @@ void RAMBank::Write(unsigned short address, unsigned char value) {
   memory_[address] = value;
 }
 
-unique_ptr<MBC> ConstructMBC(unsigned char* program_rom, long size) {
-  MBC::CartridgeType cartridge_type = GetCartridgeType(program_rom[0x147]);
+unique_ptr<MBC> ConstructMBC(shared_ptr<const ROMImage> program_rom) {
+  if (program_rom->size() <= 0x147) {
+    LOG(FATAL) << "ROM is too small to have a cartridge header: " << program_rom->size() << " bytes";
+  }
+  MBC::CartridgeType cartridge_type = GetCartridgeType(program_rom->data()[0x147]);
   // TODO(Brendan): We should have some type of check on the ROM/RAM size, I do
   // not know what the behavior should be if the ROM states an incorrect size.
 //   int rom_bank_number = GetROMBankNumber(program_rom[0x148]);
@@ -106,12 +102,12 @@ unique_ptr<MBC> ConstructMBC(unsigned char* program_rom, long size) {
     case MBC::ROM_AND_RAM:
     case MBC::ROM_AND_RAM_BATTERY:
       LOG(INFO) << "Creating NoMBC";
-      return unique_ptr<MBC>(CreateNoMBC(program_rom, size));
+      return unique_ptr<MBC>(CreateNoMBC(program_rom));
     case MBC::MBC1:
     case MBC::MBC1_WITH_RAM:
     case MBC::MBC1_WITH_RAM_BATTERY:
       LOG(INFO) << "Creating MBC1";
-      return unique_ptr<MBC>(CreateMBC1(program_rom, size));
+      return unique_ptr<MBC>(CreateMBC1(program_rom));
     case MBC::UNSUPPORTED:
     default:
       LOG(FATAL) << "Cartridge Type, " << cartridge_type << ", is unsupported";
@@ -134,10 +130,12 @@ unsigned char NoMBC::Read(unsigned short address) {
 }
 
 void NoMBC::Write(unsigned short address, unsigned char value) {
+  // Some games write bank numbers here even though there is nothing to switch,
+  // so only the first few writes are logged.
   if (0x0000 <= address && address <= 0x3fff) {
-    LOG(WARNING) << "Write attempted in ROM_0, address: " << std::hex << address << " value: " << std::hex << 0x0000 + value;
+    LOG_FIRST_N(WARNING, 10) << "Write attempted in ROM_0, address: " << std::hex << address << " value: " << std::hex << 0x0000 + value;
   } else if (0x4000 <= address && address <= 0x7fff) {
-    LOG(WARNING) << "Write attempted in ROM_1, address: " << std::hex << address << " value: " << std::hex << 0x0000 + value;
+    LOG_FIRST_N(WARNING, 10) << "Write attempted in ROM_1, address: " << std::hex << address << " value: " << std::hex << 0x0000 + value;
   } else if (0xa000 <= address && address <= 0xbfff) {
     ram_bank_0_.Write(address - 0xa000, value);
   } else {
@@ -145,11 +143,32 @@ void NoMBC::Write(unsigned short address, unsigned char value) {
   }
 }
 
+const unsigned char* NoMBC::read_pointer(unsigned short page_address) {
+  if (page_address <= 0x3fff) {
+    return rom_bank_0_.pointer(page_address - 0x0000);
+  } else if (page_address <= 0x7fff) {
+    return rom_bank_1_.pointer(page_address - 0x4000);
+  } else {
+    return ram_bank_0_.pointer(page_address - 0xa000);
+  }
+}
+
+unsigned char* NoMBC::write_pointer(unsigned short page_address) {
+  if (0xa000 <= page_address && page_address <= 0xbfff) {
+    return ram_bank_0_.pointer(page_address - 0xa000);
+  }
+  // Writes to ROM are logged.
+  return nullptr;
+}
+
 void NoMBC::ForceWrite(unsigned short address, unsigned char value) {
   if (0x0000 <= address && address <= 0x3fff) {
     rom_bank_0_.ForceWrite(address - 0x0000, value);
+    // The bank may have just stopped sharing the ROM image.
+    Remap(0x0000, 0x3fff);
   } else if (0x4000 <= address && address <= 0x7fff) {
     rom_bank_1_.ForceWrite(address - 0x4000, value);
+    Remap(0x4000, 0x7fff);
   } else if (0xa000 <= address && address <= 0xbfff) {
     ram_bank_0_.ForceWrite(address - 0xa000, value);
   } else {
@@ -195,21 +214,49 @@ unsigned char MBC1::BankModeRegister::GetROMBank() {
   }
 }
 
+void MBC1::BankModeRegister::SaveState(StateWriter* writer) {
+  writer->Write8(register_);
+  writer->WriteBool(is_ram_mode_);
+}
+
+void MBC1::BankModeRegister::LoadState(StateReader* reader) {
+  register_ = reader->Read8();
+  is_ram_mode_ = reader->ReadBool();
+}
+
+MBC1::ROMBankN::ROMBankN(vector<ROMBank> banks, BankModeRegister* bank_mode_register)
+    : banks_(std::move(banks)), bank_mode_register_(bank_mode_register) {
+  if (banks_.empty()) {
+    // A ROM with only bank 0 reads as zeros above it.
+    banks_.push_back(ROMBank());
+  }
+  Select();
+}
+
+bool MBC1::ROMBankN::Select() {
+  const unsigned char* selected = banks_[ComputeROMBank()].pointer(0);
+  bool moved = selected != selected_;
+  selected_ = selected;
+  return moved;
+}
+
 unsigned char MBC1::ROMBankN::ComputeROMBank() {
   unsigned char bank_number = bank_mode_register_->GetROMBank();
   
   // Since certain bank values are skipped we must translate bank address space
   // into the index space with respect to the vector which holds the actual
   // memory blocks.
+  unsigned char index;
   if (bank_number > 0x60) {
-    return bank_number - 4;
+    index = bank_number - 4;
   } else if (bank_number > 0x40) {
-    return bank_number - 3;
+    index = bank_number - 3;
   } else if (bank_number > 0x20) {
-    return bank_number - 2;
+    index = bank_number - 2;
   } else {
-    return bank_number - 1;
+    index = bank_number - 1;
   }
+  return index % banks_.size();
 }
 
 unsigned char MBC1::Read(unsigned short address) {
@@ -226,15 +273,15 @@ unsigned char MBC1::Read(unsigned short address) {
 void MBC1::Write(unsigned short address, unsigned char value) {
   if (0x0000 <= address && address <= 0x1fff) {
     SetRAMEnabled(value);
-    LOG(INFO) << std::hex << 0x0000 + value << " was written to RAM enable region";
-    LOG(INFO) << "RAM enabled = " << ram_enabled_;
   } else if (0x2000 <= address && address <= 0x3fff) {
     bank_mode_register_.SetLowerBits(value);
-    LOG(INFO) << "ROM bank " << static_cast<int>(bank_mode_register_.GetROMBank()) << " was selected";
+    SelectBanks();
   } else if (0x4000 <= address && address <= 0x5fff) {
     bank_mode_register_.SetUpperBits(value);
+    SelectBanks();
   } else if (0x6000 <= address && address <= 0x7fff) {
     bank_mode_register_.SetIsRAMMode(value);
+    SelectBanks();
   } else if (0xa000 <= address && address <= 0xbfff) {
     if (ram_enabled_) {
       ram_bank_n_.Write(address - 0xa000, value);
@@ -249,11 +296,56 @@ void MBC1::Write(unsigned short address, unsigned char value) {
   }
 }
 
+int MBC1::bank(unsigned short address) {
+  if (0x4000 <= address && address <= 0x7fff) {
+    return bank_mode_register_.GetROMBank();
+  } else if (0xa000 <= address && address <= 0xbfff) {
+    return bank_mode_register_.GetRAMBank();
+  }
+  return 0;
+}
+
+const unsigned char* MBC1::read_pointer(unsigned short page_address) {
+  if (page_address <= 0x3fff) {
+    return rom_bank_0_.pointer(page_address - 0x0000);
+  } else if (page_address <= 0x7fff) {
+    return rom_bank_n_.pointer(page_address - 0x4000);
+  } else {
+    return ram_bank_n_.pointer(page_address - 0xa000);
+  }
+}
+
+unsigned char* MBC1::write_pointer(unsigned short page_address) {
+  if (0xa000 <= page_address && page_address <= 0xbfff && ram_enabled_) {
+    return ram_bank_n_.pointer(page_address - 0xa000);
+  }
+  // Writes to ROM set the bank registers.
+  return nullptr;
+}
+
+void MBC1::SaveState(StateWriter* writer) {
+  writer->WriteBool(ram_enabled_);
+  bank_mode_register_.SaveState(writer);
+  ram_bank_n_.SaveState(writer);
+}
+
+void MBC1::LoadState(StateReader* reader) {
+  ram_enabled_ = reader->ReadBool();
+  bank_mode_register_.LoadState(reader);
+  ram_bank_n_.LoadState(reader);
+  // The MemoryMapper repoints the windows itself once everything is loaded.
+  rom_bank_n_.Select();
+  ram_bank_n_.Select();
+}
+
 void MBC1::ForceWrite(unsigned short address, unsigned char value) {
   if (0x0000 <= address && address <= 0x3fff) {
     rom_bank_0_.ForceWrite(address - 0x0000, value);
+    // The bank may have just stopped sharing the ROM image.
+    Remap(0x0000, 0x3fff);
   } else if (0x4000 <= address && address <= 0x4000) {
     rom_bank_n_.ForceWrite(address - 0x4000, value);
+    Remap(0x4000, 0x7fff);
   } else if (0xa000 <= address && address <= 0xbfff) {
     rom_bank_n_.ForceWrite(address - 0xa000, value);
   } else {
@@ -264,7 +356,23 @@ void MBC1::ForceWrite(unsigned short address, unsigned char value) {
 void MBC1::SetRAMEnabled(unsigned char value) {
   // Any value with 0x0a in the lower 4 bits enables RAM and any other value
   // disables it.
-  ram_enabled_ = (0x0a == (value & 0b00001111));
+  bool ram_enabled = (0x0a == (value & 0b00001111));
+  if (ram_enabled != ram_enabled_) {
+    ram_enabled_ = ram_enabled;
+    // Writes to RAM only go straight to memory while it is enabled.
+    RemapWindow(0xa000, 0xbfff);
+  }
+}
+
+void MBC1::SelectBanks() {
+  // Games switch banks far more often than the bank actually changes, so only
+  // a window that moved is remapped.
+  if (rom_bank_n_.Select()) {
+    RemapWindow(0x4000, 0x7fff);
+  }
+  if (ram_bank_n_.Select()) {
+    RemapWindow(0xa000, 0xbfff);
+  }
 }
 
 } // namespace memory
@@ -2,9 +2,11 @@
 #define TURBO_SANTA_COMMON_BACK_END_MEMORY_MBC_H_
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "backend/memory/memory_segment.h"
+#include "backend/memory/rom_image.h"
 
 namespace test_harness {
 class TestHarness;
@@ -19,26 +21,37 @@ class ClocktrollerTest;
 namespace back_end {
 namespace memory {
 
-class ROMBank;
-
-void CreateROMBanks(unsigned char* rom, long rom_size, ROMBank* rom_bank_0, ROMBank* rom_bank_1);
-void CreateROMBanks(unsigned char* rom, long rom_size, ROMBank* rom_bank_0, std::vector<ROMBank>* rom_bank_n);
-
+// A 0x4000 byte bank of ROM. Banks are views into a ROMImage, so copying one
+// does not copy the ROM, except for the last bank of a ROM whose size is not a
+// multiple of the bank size, which is copied and padded with zeros.
 class ROMBank {
  public:
-  ROMBank() : memory_(0x4000, 0x00) {}
+  // A bank of zeros.
+  ROMBank() : copy_(0x4000, 0x00) {}
+
+  // The bank starting at offset in image.
+  ROMBank(std::shared_ptr<const ROMImage> image, long offset);
 
   virtual unsigned char Read(unsigned short address);
 
+  // Gives this bank its own copy of the ROM the first time it is called, so
+  // that other banks and emulators sharing the image do not see the write.
   virtual void ForceWrite(unsigned short address, unsigned char value);
 
+  const unsigned char* pointer(unsigned short address) { return data() + address; }
+
  private:
-  std::vector<unsigned char> memory_;
+  const unsigned char* data() const { return copy_.empty() ? image_->data() + offset_ : copy_.data(); }
 
-  friend void CreateROMBanks(unsigned char* rom, long rom_size, ROMBank* rom_bank_0, ROMBank* rom_bank_1);
-  friend void CreateROMBanks(unsigned char* rom, long rom_size, ROMBank* rom_bank_0, std::vector<ROMBank>* rom_bank_1);
+  std::shared_ptr<const ROMImage> image_;
+  long offset_ = 0;
+  // Holds the bank instead of image_ if it is not empty.
+  std::vector<unsigned char> copy_;
 };
 
+void CreateROMBanks(std::shared_ptr<const ROMImage> rom, ROMBank* rom_bank_0, ROMBank* rom_bank_1);
+void CreateROMBanks(std::shared_ptr<const ROMImage> rom, ROMBank* rom_bank_0, std::vector<ROMBank>* rom_bank_n);
+
 class RAMBank;
 
 void CreateRAMBanks(int bank_number, std::vector<RAMBank>* ram_bank_n_);
@@ -55,6 +68,11 @@ class RAMBank {
     Write(address, value);
   }
 
+  unsigned char* pointer(unsigned short address) { return &memory_[address]; }
+
+  void SaveState(StateWriter* writer) { writer->WriteBytes(memory_.data(), memory_.size()); }
+  void LoadState(StateReader* reader) { reader->ReadBytes(memory_.data(), memory_.size()); }
+
  private:
   std::vector<unsigned char> memory_;
   friend void CreateRAMBanks(int bank_number, std::vector<RAMBank>* ram_bank_n_);
@@ -91,11 +109,11 @@ class MBC : public MemorySegment {
     friend class clocktroller::ClocktrollerTest;
 };
 
-std::unique_ptr<MBC> ConstructMBC(unsigned char* program_rom, long size);
+std::unique_ptr<MBC> ConstructMBC(std::shared_ptr<const ROMImage> program_rom);
 
-MBC* CreateNoMBC(unsigned char* program_rom, long size);
+MBC* CreateNoMBC(std::shared_ptr<const ROMImage> program_rom);
 
-MBC* CreateMBC1(unsigned char* program_rom, long size);
+MBC* CreateMBC1(std::shared_ptr<const ROMImage> program_rom);
 
 MBC::CartridgeType GetCartridgeType(unsigned char cartridge_type_value);
 
@@ -106,10 +124,14 @@ int GetRAMBankNumber(unsigned char ram_size_value);
 class NoMBC : public MBC {
  public:
   NoMBC(ROMBank rom_bank_0, ROMBank rom_bank_1, RAMBank ram_bank_0)
-      : rom_bank_0_(rom_bank_0), rom_bank_1_(rom_bank_1), ram_bank_0_(ram_bank_0) {}
+      : rom_bank_0_(std::move(rom_bank_0)), rom_bank_1_(std::move(rom_bank_1)), ram_bank_0_(std::move(ram_bank_0)) {}
 
   virtual unsigned char Read(unsigned short address);
   virtual void Write(unsigned short address, unsigned char value);
+  virtual const unsigned char* read_pointer(unsigned short page_address);
+  virtual unsigned char* write_pointer(unsigned short page_address);
+  virtual void SaveState(StateWriter* writer) { ram_bank_0_.SaveState(writer); }
+  virtual void LoadState(StateReader* reader) { ram_bank_0_.LoadState(reader); }
 
  protected:
   ROMBank rom_bank_0_;
@@ -122,10 +144,19 @@ class NoMBC : public MBC {
 class MBC1 : public MBC {
   public:
    MBC1(ROMBank rom_bank_0, std::vector<ROMBank> rom_bank_n, std::vector<RAMBank> ram_bank_n)
-       : rom_bank_0_(rom_bank_0), rom_bank_n_(rom_bank_n, &bank_mode_register_), ram_bank_n_(ram_bank_n, &bank_mode_register_) {}
+       : rom_bank_0_(std::move(rom_bank_0)),
+         rom_bank_n_(std::move(rom_bank_n), &bank_mode_register_),
+         ram_bank_n_(std::move(ram_bank_n), &bank_mode_register_) {}
 
     virtual unsigned char Read(unsigned short address);
     virtual void Write(unsigned short address, unsigned char value);
+    virtual int bank(unsigned short address);
+    virtual const unsigned char* read_pointer(unsigned short page_address);
+    virtual unsigned char* write_pointer(unsigned short page_address);
+    // The bank registers and all of the RAM banks; the ROM is the
+    // cartridge's.
+    virtual void SaveState(StateWriter* writer);
+    virtual void LoadState(StateReader* reader);
    
     // The documentation stated
     // that the gameboy game may change the ROM/RAM addressing mode at anytime
@@ -155,62 +186,98 @@ class MBC1 : public MBC {
         // Gets the number of the selected ROM bank.
         unsigned char GetROMBank();
 
+        void SaveState(StateWriter* writer);
+        void LoadState(StateReader* reader);
+
       private:
         // 7-bit register that stores that sets the selected ROM/RAM address(es).
         unsigned char register_ = 0;
         bool is_ram_mode_ = false;
     };
 
+    // The banks are looked up when the BankModeRegister changes rather than on
+    // every access, so reading the window is a load through selected_.
     class ROMBankN {
       public:
-       ROMBankN(std::vector<ROMBank> banks, BankModeRegister* bank_mode_register) : 
-           banks_(banks), bank_mode_register_(bank_mode_register) {}
+       ROMBankN(std::vector<ROMBank> banks, BankModeRegister* bank_mode_register);
 
-        virtual unsigned char Read(unsigned short address) {
-          return banks_[ComputeROMBank()].Read(address);
-        }
+        unsigned char Read(unsigned short address) { return selected_[address]; }
 
-        virtual void ForceWrite(unsigned short address, unsigned char value) {
+        void ForceWrite(unsigned short address, unsigned char value) {
           banks_[ComputeROMBank()].ForceWrite(address, value);
+          Select();
         }
 
+        const unsigned char* pointer(unsigned short address) { return selected_ + address; }
+
+        // Points the window at the bank the BankModeRegister selects and
+        // returns whether it moved.
+        bool Select();
+
       private:
         // Unlike the RAM bank, the ROM bank number does not directly correspond
         // to that banks index in the vector of banks. When the user sets the
         // bottom 5 bits of the RAM/ROM bank register (the BankModeRegister here)
         // to 0 it actually gets set to 1 since bank 0 is always mapped into
         // memory at a different range of addresses. Thus we have to translate
-        // the given ROM bank number to its index in the vector.
+        // the given ROM bank number to its index in the vector. Banks past the
+        // end of the ROM wrap around, as they would on a cartridge that does
+        // not connect the upper bank lines.
         unsigned char ComputeROMBank();
 
         std::vector<ROMBank> banks_;
         BankModeRegister* bank_mode_register_;
+        const unsigned char* selected_ = nullptr;
     };
 
     class RAMBankN {
       public:
        RAMBankN(std::vector<RAMBank> banks, BankModeRegister* bank_mode_register) : 
-           banks_(banks), bank_mode_register_(bank_mode_register) {}
+           banks_(std::move(banks)), bank_mode_register_(bank_mode_register) {
+         Select();
+       }
+
+        unsigned char Read(unsigned short address) { return selected_[address]; }
 
-        virtual unsigned char Read(unsigned short address) {
-          return banks_[bank_mode_register_->GetRAMBank()].Read(address);
+        void Write(unsigned short address, unsigned char value) { selected_[address] = value; }
+
+        void ForceWrite(unsigned short address, unsigned char value) {
+          Write(address, value);
         }
 
-        virtual void Write(unsigned short address, unsigned char value) {
-          banks_[bank_mode_register_->GetRAMBank()].Write(address, value);
+        unsigned char* pointer(unsigned short address) { return selected_ + address; }
+
+        // Points the window at the bank the BankModeRegister selects and
+        // returns whether it moved.
+        bool Select() {
+          unsigned char* selected = banks_[bank_mode_register_->GetRAMBank()].pointer(0);
+          bool moved = selected != selected_;
+          selected_ = selected;
+          return moved;
         }
 
-        virtual void ForceWrite(unsigned short address, unsigned char value) {
-          Write(address, value);
+        void SaveState(StateWriter* writer) {
+          for (RAMBank& bank : banks_) {
+            bank.SaveState(writer);
+          }
+        }
+
+        void LoadState(StateReader* reader) {
+          for (RAMBank& bank : banks_) {
+            bank.LoadState(reader);
+          }
         }
 
       private:
         std::vector<RAMBank> banks_;
         BankModeRegister* bank_mode_register_;
+        unsigned char* selected_ = nullptr;
     };
 
   private:
     void SetRAMEnabled(unsigned char value);
+    // Called after every write to the BankModeRegister.
+    void SelectBanks();
     virtual void ForceWrite(unsigned short address, unsigned char value);
     
     bool ram_enabled_ = true;
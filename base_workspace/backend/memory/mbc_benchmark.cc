@@ -0,0 +1,133 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "backend/memory/default_module.h"
+#include "backend/memory/mbc_module.h"
+#include "backend/memory/memory_mapper.h"
+#include "backend/memory/rom_image.h"
+#include "submodules/glog/src/glog/logging.h"
+
+// Times reads through the MemoryMapper from a cartridge that switches ROM and
+// RAM banks every few reads, the way games that stream graphics or music out
+// of banked ROM do, against the same reads with no switching. Also times a
+// cartridge without an MBC being written to, which some games do by mistake.
+//
+// bazel run -c opt //backend/memory:mbc_benchmark
+
+using back_end::memory::DefaultModule;
+using back_end::memory::MBC;
+using back_end::memory::MBCModule;
+using back_end::memory::MemoryMapper;
+using back_end::memory::ROMImage;
+using std::shared_ptr;
+using std::vector;
+
+namespace {
+const int kROMBanks = 64;
+const int kFrames = 200;
+// Enough to cover a frame of a game that switches banks constantly.
+const int kSwitchesPerFrame = 4096;
+const int kReadsPerSwitch = 8;
+
+// Every byte of bank n is n, except the header.
+shared_ptr<const ROMImage> BuildROM(unsigned char cartridge_type) {
+  vector<unsigned char> rom(kROMBanks * MBC::kROMBankNSize);
+  for (size_t i = 0; i < rom.size(); i++) {
+    rom[i] = i / MBC::kROMBankNSize;
+  }
+  rom[0x147] = cartridge_type;
+  return ROMImage::Copy(rom.data(), rom.size());
+}
+
+// Banks 1 to 31 never need the upper bits, so the bank is the value read.
+int SelectedBank(int i) {
+  return 1 + i % 31;
+}
+
+// Runs frame kFrames times and prints how long each read took, counting the
+// bank switches as part of the reads.
+template<typename Frame>
+void Time(const char* name, Frame frame) {
+  unsigned int sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kFrames; i++) {
+    sum += frame();
+  }
+  auto end = std::chrono::steady_clock::now();
+  double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+  double reads = static_cast<double>(kFrames) * kSwitchesPerFrame * kReadsPerSwitch;
+  printf("%-22s %6.2f ns/read, %8.1f us/frame (sum %u)\n", name,
+         nanoseconds / reads, nanoseconds / 1000 / kFrames, sum);
+}
+} // namespace
+
+int main() {
+  MBCModule mbc1;
+  mbc1.Init(BuildROM(MBC::MBC1_WITH_RAM));
+  DefaultModule default_module;
+  default_module.Init();
+  MemoryMapper mapper;
+  mapper.RegisterModule(mbc1);
+  mapper.RegisterModule(default_module);
+  // Switch out the boot ROM and turn on cartridge RAM.
+  mapper.Write(0xff50, 0x01);
+  mapper.Write(0x0000, 0x0a);
+  mapper.Write(0x6000, 0x01);
+
+  for (int i = 0; i < 31; i++) {
+    mapper.Write(0x2000, SelectedBank(i));
+    if (mapper.Read(0x4000) != SelectedBank(i)) {
+      LOG(FATAL) << "Bank " << SelectedBank(i) << " reads as " << static_cast<int>(mapper.Read(0x4000));
+    }
+  }
+
+  Time("MBC1 switching ROM", [&mapper]() {
+    unsigned int sum = 0;
+    for (int i = 0; i < kSwitchesPerFrame; i++) {
+      mapper.Write(0x2000, SelectedBank(i));
+      for (int j = 0; j < kReadsPerSwitch; j++) {
+        sum += mapper.Read(0x4000 + ((i * 0x81 + j * 0x801) & 0x3fff));
+      }
+    }
+    return sum;
+  });
+  Time("MBC1 switching RAM", [&mapper]() {
+    unsigned int sum = 0;
+    for (int i = 0; i < kSwitchesPerFrame; i++) {
+      mapper.Write(0x4000, i & 0x03);
+      for (int j = 0; j < kReadsPerSwitch; j++) {
+        sum += mapper.Read(0xa000 + ((i * 0x81 + j * 0x401) & 0x1fff));
+      }
+    }
+    return sum;
+  });
+  Time("MBC1 not switching", [&mapper]() {
+    unsigned int sum = 0;
+    for (int i = 0; i < kSwitchesPerFrame; i++) {
+      for (int j = 0; j < kReadsPerSwitch; j++) {
+        sum += mapper.Read(0x4000 + ((i * 0x81 + j * 0x801) & 0x3fff));
+      }
+    }
+    return sum;
+  });
+
+  MBCModule no_mbc;
+  no_mbc.Init(BuildROM(MBC::ROM_ONLY));
+  MemoryMapper no_mbc_mapper;
+  no_mbc_mapper.RegisterModule(no_mbc);
+  no_mbc_mapper.RegisterModule(default_module);
+  no_mbc_mapper.Write(0xff50, 0x01);
+  Time("NoMBC written to", [&no_mbc_mapper]() {
+    unsigned int sum = 0;
+    for (int i = 0; i < kSwitchesPerFrame; i++) {
+      no_mbc_mapper.Write(0x2000, SelectedBank(i));
+      for (int j = 0; j < kReadsPerSwitch; j++) {
+        sum += no_mbc_mapper.Read(0x4000 + ((i * 0x81 + j * 0x801) & 0x3fff));
+      }
+    }
+    return sum;
+  });
+  return 0;
+}
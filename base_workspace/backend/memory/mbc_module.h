@@ -6,14 +6,19 @@
 #include "backend/memory/mbc.h"
 #include "backend/memory/memory_segment.h"
 #include "backend/memory/module.h"
+#include "backend/memory/rom_image.h"
 
 namespace back_end {
 namespace memory {
 
-class MBCWrapper : public MemorySegment {
+class MBCWrapper : public MemorySegment, public RemapListener {
  public:
-  void Init(unsigned char* program_rom, long size) {
-    mbc_ = ConstructMBC(program_rom, size);
+  // Reported by bank() while the boot ROM is mapped over the cartridge.
+  static const int kInternalROMBank = -1;
+
+  void Init(std::shared_ptr<const ROMImage> program_rom) {
+    mbc_ = ConstructMBC(program_rom);
+    mbc_->set_remap_listener(this);
   }
 
   unsigned char Read(unsigned short address) {
@@ -34,22 +39,78 @@ class MBCWrapper : public MemorySegment {
 
   bool InRange(unsigned short address) { return mbc_->InRange(address); }
 
+  int bank(unsigned short address) {
+    if (!internal_rom_flag_.is_set() && internal_rom_.InRange(address)) {
+      return kInternalROMBank;
+    } else {
+      return mbc_->bank(address);
+    }
+  }
+
+  const unsigned char* read_pointer(unsigned short page_address) {
+    if (!internal_rom_flag_.is_set() && internal_rom_.InRange(page_address)) {
+      return &kBootROM[page_address];
+    } else {
+      return mbc_->read_pointer(page_address);
+    }
+  }
+
+  unsigned char* write_pointer(unsigned short page_address) {
+    if (!internal_rom_flag_.is_set() && internal_rom_.InRange(page_address)) {
+      return nullptr;
+    } else {
+      return mbc_->write_pointer(page_address);
+    }
+  }
+
+  // Passes on remaps from the MBC, which is not registered itself. The MBC
+  // remaps when it switches banks or turns RAM on or off.
+  virtual void OnRemap(MemorySegment*, unsigned short first, unsigned short last) { Remap(first, last); }
+  virtual void OnRemapWindow(MemorySegment*, unsigned short first, unsigned short last) { RemapWindow(first, last); }
+
+  // The boot ROM flag is saved with the other flags.
+  virtual void SaveState(StateWriter* writer) { mbc_->SaveState(writer); }
+  virtual void LoadState(StateReader* reader) { mbc_->LoadState(reader); }
+
   Flag* internal_rom_flag() { return &internal_rom_flag_; }
 
  private:
+  // Uncovers the cartridge under the boot ROM when it is switched off.
+  class BootROMFlag : public InternalROMFlag {
+   public:
+    BootROMFlag(MBCWrapper* wrapper) : wrapper_(wrapper) {}
+
+    virtual void Write(unsigned short address, unsigned char value) {
+      InternalROMFlag::Write(address, value);
+      wrapper_->Remap();
+    }
+
+    virtual void set_flag(unsigned char value) {
+      InternalROMFlag::set_flag(value);
+      wrapper_->Remap();
+    }
+
+   private:
+    MBCWrapper* wrapper_;
+  };
+
   InternalROM internal_rom_;
-  InternalROMFlag internal_rom_flag_;
+  BootROMFlag internal_rom_flag_ = BootROMFlag(this);
   std::unique_ptr<MBC> mbc_;
 };
 
 class MBCModule : public Module {
  public:
-  void Init(unsigned char* program_rom, long size) {
-    mbc_.Init(program_rom, size);
+  void Init(std::shared_ptr<const ROMImage> program_rom) {
+    mbc_.Init(program_rom);
     add_memory_segment(&mbc_);
     add_flag(mbc_.internal_rom_flag());
   }
 
+  void Init(const unsigned char* program_rom, long size) {
+    Init(ROMImage::Copy(program_rom, size));
+  }
+
  private:
   MBCWrapper mbc_;
 };
@@ -1,4 +1,8 @@
 #include "backend/memory/memory_mapper.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
 #include "submodules/glog/src/glog/logging.h"
 
 namespace back_end {
@@ -7,39 +11,190 @@ namespace memory {
 using std::vector;
 
 namespace {
-MemorySegment* Lookup(const vector<MemorySegment*>& segments, unsigned short address) {
+MemorySegment* Find(const vector<MemorySegment*>& segments, unsigned short address) {
   for (MemorySegment* segment : segments) {
     if (segment->InRange(address)) {
       return segment;
     }
   }
-  LOG(FATAL) << "Address out of range: 0x" << std::hex << address;
+  return nullptr;
 }
 } // namespace
 
 void MemoryMapper::RegisterModule(const Module& module) {
   for (MemorySegment* segment : module.memory_segments()) {
     memory_segments_.push_back(segment);
+    segment->set_remap_listener(this);
   }
 
+  // The flag container has a slot for the interrupt enable flag as well, even
+  // though address 0xffff does not lie within the usual flag address space.
   for (Flag* flag : module.flags()) {
-    if (flag->address() == 0xffff) {
-      // The interrupt enable flag, address 0xffff, does not lie within the
-      // usual flag address space.
-      memory_segments_.push_back(flag);
-      LOG(INFO) << "Adding interrupt enable.";
+    flag_container_.add_flag(flag);
+  }
+
+  // New segments can change which segment owns a page.
+  for (int index = 0; index < kPageCount; index++) {
+    pages_[index] = Page();
+    reads_[index] = nullptr;
+    writes_[index] = nullptr;
+  }
+}
+
+void MemoryMapper::SaveState(StateWriter* writer) {
+  for (MemorySegment* segment : memory_segments_) {
+    segment->SaveState(writer);
+  }
+}
+
+void MemoryMapper::LoadState(StateReader* reader) {
+  for (MemorySegment* segment : memory_segments_) {
+    segment->LoadState(reader);
+  }
+  // Banks, the boot ROM and the bus lock may all have changed.
+  for (int index = 0; index < kPageCount; index++) {
+    reads_[index] = nullptr;
+    writes_[index] = nullptr;
+    pages_[index].mapped = false;
+  }
+}
+
+void MemoryMapper::ReadBlock(unsigned short address, int length, unsigned char* values) {
+  while (length > 0) {
+    int count = std::min(length, kPageSize - (address & kPageMask));
+    Page& page = pages_[address >> kPageBits];
+    MemorySegment* segment = SegmentFor(address);
+    // Asked for afresh, since a locked page has no pointer in reads_.
+    const unsigned char* read = page.segment == nullptr ? nullptr : segment->read_pointer(address & ~kPageMask);
+    if (read != nullptr) {
+      memcpy(values, read + (address & kPageMask), count);
+    } else if (page.segment != nullptr) {
+      for (int offset = 0; offset < count; offset++) {
+        values[offset] = segment->Read(address + offset);
+      }
     } else {
-      flag_container_.add_flag(flag);
+      for (int offset = 0; offset < count; offset++) {
+        values[offset] = SegmentFor(address + offset)->Read(address + offset);
+      }
     }
+    address += count;
+    values += count;
+    length -= count;
+  }
+}
+
+void MemoryMapper::LockBus() {
+  bus_locked_ = true;
+  for (int index = 0; index < kUnlockedPage; index++) {
+    reads_[index] = nullptr;
+    writes_[index] = nullptr;
+    pages_[index].mapped = false;
   }
 }
 
-unsigned char MemoryMapper::Read(unsigned short address) {
-  return Lookup(memory_segments_, address)->Read(address);
+void MemoryMapper::UnlockBus() {
+  // The pages get their pointers back as they are next used.
+  bus_locked_ = false;
 }
 
-void MemoryMapper::Write(unsigned short address, unsigned char value) {
-  Lookup(memory_segments_, address)->Write(address, value);
+unsigned char MemoryMapper::ReadSlow(unsigned short address) {
+  if (IsLocked(address)) {
+    return 0xff;
+  }
+  return SegmentFor(address)->Read(address);
+}
+
+void MemoryMapper::WriteSlow(unsigned short address, unsigned char value) {
+  if (IsLocked(address)) {
+    return;
+  }
+  SegmentFor(address)->Write(address, value);
+}
+
+int MemoryMapper::Bank(unsigned short address) {
+  MemorySegment* segment = pages_[address >> kPageBits].segment;
+  if (segment == nullptr) {
+    segment = Find(memory_segments_, address);
+  }
+  return segment == nullptr ? 0 : segment->bank(address);
+}
+
+void MemoryMapper::OnRemap(MemorySegment* segment, unsigned short first, unsigned short last) {
+  for (int index = first >> kPageBits; index <= last >> kPageBits; index++) {
+    Page& page = pages_[index];
+    if (page.segment == segment) {
+      reads_[index] = nullptr;
+      writes_[index] = nullptr;
+      page.mapped = false;
+    }
+  }
+}
+
+void MemoryMapper::OnRemapWindow(MemorySegment* segment, unsigned short first, unsigned short last) {
+  if (bus_locked_) {
+    // The pointers are set once the bus is unlocked and the pages used.
+    OnRemap(segment, first, last);
+    return;
+  }
+  const unsigned char* read = segment->read_pointer(first);
+  unsigned char* write = segment->write_pointer(first);
+  for (int index = first >> kPageBits; index <= last >> kPageBits; index++) {
+    Page& page = pages_[index];
+    if (page.segment == segment) {
+      int offset = (index << kPageBits) - first;
+      reads_[index] = read == nullptr ? nullptr : read + offset;
+      writes_[index] = write == nullptr ? nullptr : write + offset;
+      page.mapped = true;
+    }
+  }
+}
+
+// Resolves the page if need be and returns the segment that handles address.
+MemorySegment* MemoryMapper::SegmentFor(unsigned short address) {
+  Page& page = pages_[address >> kPageBits];
+  if (!page.resolved) {
+    ResolvePage(address >> kPageBits);
+  } else if (!page.mapped) {
+    MapPage(address >> kPageBits);
+  }
+  MemorySegment* segment = page.segment;
+  if (segment == nullptr && !page.segments.empty()) {
+    segment = page.segments[address & kPageMask];
+  }
+  if (segment == nullptr) {
+    LOG(FATAL) << "Address out of range: 0x" << std::hex << address;
+  }
+  return segment;
+}
+
+void MemoryMapper::ResolvePage(int index) {
+  Page& page = pages_[index];
+  unsigned short begin = index << kPageBits;
+  vector<MemorySegment*> segments(kPageSize);
+  bool shared = false;
+  for (int offset = 0; offset < kPageSize; offset++) {
+    segments[offset] = Find(memory_segments_, begin + offset);
+    shared = shared || segments[offset] != segments[0];
+  }
+
+  MemorySegment* segment = shared ? nullptr : segments[0];
+  if (shared) {
+    page.segments = std::move(segments);
+  }
+  page.segment = segment;
+  page.resolved = true;
+  MapPage(index);
+}
+
+void MemoryMapper::MapPage(int index) {
+  Page& page = pages_[index];
+  if (bus_locked_ && index < kUnlockedPage) {
+    return;
+  }
+  unsigned short begin = index << kPageBits;
+  reads_[index] = page.segment == nullptr ? nullptr : page.segment->read_pointer(begin);
+  writes_[index] = page.segment == nullptr ? nullptr : page.segment->write_pointer(begin);
+  page.mapped = true;
 }
 
 } // namespace memory
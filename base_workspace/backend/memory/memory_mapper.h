@@ -10,15 +10,121 @@
 namespace back_end {
 namespace memory {
 
-class MemoryMapper {
+// Told about every write made through a MemoryMapper, after the write has
+// been applied.
+class WriteListener {
  public:
-  unsigned char Read(unsigned short address);
-  void Write(unsigned short address, unsigned char value);
+  virtual void OnWrite(unsigned short address) = 0;
+};
+
+// Reads and writes go through a table of 256 byte pages. A page that lies
+// entirely inside one segment remembers that segment, and if the segment
+// hands out a read_pointer or write_pointer for it, the access is just a load
+// or a store through the pointer. A page shared by several segments, such as
+// 0xff00 - 0xffff with the IO ports, high RAM and interrupt enable, keeps the
+// segment for each of its addresses instead.
+class MemoryMapper : public RemapListener {
+ public:
+  unsigned char Read(unsigned short address) {
+    const unsigned char* read = reads_[address >> kPageBits];
+    if (read != nullptr) {
+      return read[address & kPageMask];
+    }
+    return ReadSlow(address);
+  }
+
+  void Write(unsigned short address, unsigned char value) {
+    unsigned char* write = writes_[address >> kPageBits];
+    if (write != nullptr) {
+      write[address & kPageMask] = value;
+    } else {
+      WriteSlow(address, value);
+    }
+    for (WriteListener* write_listener : write_listeners_) {
+      write_listener->OnWrite(address);
+    }
+  }
+
+  // Reads length bytes from address on into values, as Read would with the
+  // bus unlocked, but looking up each 256 byte page only once and copying
+  // straight out of the pages that can be read through a pointer.
+  void ReadBlock(unsigned short address, int length, unsigned char* values);
+
+  // Tells the write listeners about the length bytes from address on, which
+  // were written some other way than through Write.
+  void TellWriteListeners(unsigned short address, int length) {
+    for (int offset = 0; offset < length; offset++) {
+      for (WriteListener* write_listener : write_listeners_) {
+        write_listener->OnWrite(address + offset);
+      }
+    }
+  }
+
+  // Until UnlockBus, reads from below 0xff00 give 0xff and writes there are
+  // dropped, as while a DMA transfer to OAM has the bus. The IO ports, high
+  // RAM and interrupt enable, on the CPU's own bus, can still be used. Read
+  // and Write cost no more for it; the locked pages just lose their pointers.
+  void LockBus();
+  void UnlockBus();
+  bool bus_locked() const { return bus_locked_; }
+  // Whether address is one of those LockBus cuts off, right now.
+  bool IsLocked(unsigned short address) const { return bus_locked_ && (address >> kPageBits) < kUnlockedPage; }
+
   void RegisterModule(const Module& module);
 
+  // Saves or loads every registered segment, flags first, in the order they
+  // were registered. Each page is looked up again as it is next used, after a
+  // load, and the write listeners are not told; whatever they keep has to be
+  // thrown away.
+  void SaveState(StateWriter* writer);
+  void LoadState(StateReader* reader);
+
+  // Which bank is mapped at address, see MemorySegment::bank. Unmapped
+  // addresses are bank 0.
+  int Bank(unsigned short address);
+
+  // Listeners are told about writes in the order they were added.
+  void add_write_listener(WriteListener* write_listener) { write_listeners_.push_back(write_listener); }
+
+  virtual void OnRemap(MemorySegment* segment, unsigned short first, unsigned short last);
+  virtual void OnRemapWindow(MemorySegment* segment, unsigned short first, unsigned short last);
+
  private:
+  static const int kPageBits = 8;
+  static const int kPageSize = 1 << kPageBits;
+  static const int kPageMask = kPageSize - 1;
+  static const int kPageCount = 0x10000 >> kPageBits;
+  // The first page LockBus leaves alone.
+  static const int kUnlockedPage = 0xff00 >> kPageBits;
+
+  // Which segments own the page is worked out the first time it is used. The
+  // pointers are fetched then too, and again on the next use after the segment
+  // that owns the page calls Remap, which does not have to look for the
+  // segment again. RemapWindow sets the pointers straight away. The pointers
+  // themselves are kept apart in reads_ and writes_, so that the tables the
+  // fast paths use are small and a window can be repointed in one sweep.
+  struct Page {
+    // The only segment in the page, or nullptr if there is more than one.
+    MemorySegment* segment = nullptr;
+    // The segment for each address, only filled in if there is more than one.
+    std::vector<MemorySegment*> segments;
+    bool resolved = false;
+    bool mapped = false;
+  };
+
+  unsigned char ReadSlow(unsigned short address);
+  void WriteSlow(unsigned short address, unsigned char value);
+  MemorySegment* SegmentFor(unsigned short address);
+  void ResolvePage(int index);
+  void MapPage(int index);
+
   FlagContainer flag_container_;
+  std::vector<WriteListener*> write_listeners_;
   std::vector<MemorySegment*> memory_segments_ = std::vector<MemorySegment*>(1, &flag_container_);
+  Page pages_[kPageCount];
+  const unsigned char* reads_[kPageCount] = {};
+  unsigned char* writes_[kPageCount] = {};
+  bool bus_locked_ = false;
 };
 
 } // namespace memory
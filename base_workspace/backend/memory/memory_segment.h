@@ -4,11 +4,39 @@
 #include <functional>
 #include <vector>
 
+#include "backend/memory/save_state.h"
+
 namespace back_end {
 namespace memory {
 
+class MemorySegment;
+
+// Told when a segment's read_pointer or write_pointer would give different
+// answers than before for some of the addresses from first to last, e.g. after
+// a bank switch.
+class RemapListener {
+ public:
+  virtual void OnRemap(MemorySegment* segment, unsigned short first, unsigned short last) = 0;
+
+  // The same, except that first to last is now one block of memory starting
+  // at the segment's read_pointer(first) and write_pointer(first).
+  virtual void OnRemapWindow(MemorySegment* segment, unsigned short first, unsigned short last) = 0;
+};
+
+// Told when a segment is about to be accessed whose contents are kept up to
+// date lazily by some other piece of hardware, so that it can catch up first.
+class AccessListener {
+ public:
+  virtual void OnAccess() = 0;
+
+  // Told after a write that may have changed what that hardware does next.
+  virtual void OnWritten() = 0;
+};
+
 class MemorySegment {
  public:
+  virtual ~MemorySegment() {}
+
   // Whether this is the memory segment that the address is in.
   virtual bool InRange(unsigned short address) = 0;
 
@@ -17,6 +45,71 @@ class MemorySegment {
 
   // Write this value to this memory address.
   virtual void Write(unsigned short address, unsigned char value) = 0;
+
+  // Which bank is currently mapped at this memory address. Two reads of the
+  // same address only see the same memory if they also see the same bank.
+  // Segments that do not bank switch are always bank 0.
+  virtual int bank(unsigned short) { return 0; }
+
+  // Where the 256 byte page starting at page_address is kept, if reading it
+  // needs nothing more than a load, so the MemoryMapper can skip calling Read.
+  // The pointer must stay good until the segment calls Remap. nullptr if reads
+  // have to go through Read.
+  virtual const unsigned char* read_pointer(unsigned short) { return nullptr; }
+
+  // The same for writes and Write.
+  virtual unsigned char* write_pointer(unsigned short) { return nullptr; }
+
+  // Writes whatever the segment holds that the game could tell apart, and
+  // reads it back in the same order. Segments that only pass accesses on
+  // save nothing. Loading neither tells the access listener nor has to call
+  // Remap; the MemoryMapper repoints every page once all of memory is loaded.
+  virtual void SaveState(StateWriter*) {}
+  virtual void LoadState(StateReader*) {}
+
+  // Set by the MemoryMapper the segment is registered with.
+  void set_remap_listener(RemapListener* remap_listener) { remap_listener_ = remap_listener; }
+
+  // Set by whatever keeps this segment's contents up to date. Segments that
+  // call Access or Written must not hand out a read_pointer or write_pointer.
+  void set_access_listener(AccessListener* access_listener) { access_listener_ = access_listener; }
+
+ protected:
+  // Must be called whenever read_pointer or write_pointer would now give a
+  // different answer for any page from first to last.
+  void Remap(unsigned short first = 0x0000, unsigned short last = 0xffff) {
+    if (remap_listener_ != nullptr) {
+      remap_listener_->OnRemap(this, first, last);
+    }
+  }
+
+  // Used instead of Remap when a window onto a bank has moved, so that every
+  // page in it can be repointed at once. first must start a page and the
+  // pointers for first to last must be one block of memory.
+  void RemapWindow(unsigned short first, unsigned short last) {
+    if (remap_listener_ != nullptr) {
+      remap_listener_->OnRemapWindow(this, first, last);
+    }
+  }
+
+  // Called before a read or write that needs the segment's contents to be
+  // current.
+  void Access() {
+    if (access_listener_ != nullptr) {
+      access_listener_->OnAccess();
+    }
+  }
+
+  // Called after a write that may change what the access listener does next.
+  void Written() {
+    if (access_listener_ != nullptr) {
+      access_listener_->OnWritten();
+    }
+  }
+
+ private:
+  RemapListener* remap_listener_ = nullptr;
+  AccessListener* access_listener_ = nullptr;
 };
 
 class ContiguousMemorySegment : public MemorySegment {
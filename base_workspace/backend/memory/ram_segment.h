@@ -21,6 +21,17 @@ class RAMSegment : public ContiguousMemorySegment {
     memory_[address - lower_address_bound_] = value;
   }
 
+  virtual const unsigned char* read_pointer(unsigned short page_address) {
+    return &memory_[page_address - lower_address_bound_];
+  }
+
+  virtual unsigned char* write_pointer(unsigned short page_address) {
+    return &memory_[page_address - lower_address_bound_];
+  }
+
+  virtual void SaveState(StateWriter* writer) { writer->WriteBytes(memory_.data(), memory_.size()); }
+  virtual void LoadState(StateReader* reader) { reader->ReadBytes(memory_.data(), memory_.size()); }
+
  protected:
   unsigned short lower_address_bound_;
   unsigned short upper_address_bound_;
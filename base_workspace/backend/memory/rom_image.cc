@@ -0,0 +1,90 @@
+#include "backend/memory/rom_image.h"
+
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "submodules/glog/src/glog/logging.h"
+
+namespace back_end {
+namespace memory {
+
+using std::shared_ptr;
+using std::string;
+using std::weak_ptr;
+
+namespace {
+// Identifies a file by where it lives on disk rather than by name, so that
+// different paths to one file share an image. The size and modification time
+// are in the key so that a ROM rebuilt in place is loaded again.
+typedef std::tuple<dev_t, ino_t, off_t, time_t> FileKey;
+
+std::mutex open_images_mutex;
+std::map<FileKey, weak_ptr<const ROMImage>> open_images;
+} // namespace
+
+shared_ptr<const ROMImage> ROMImage::Open(const string& file_name) {
+  int file = open(file_name.c_str(), O_RDONLY);
+  if (file == -1) {
+    LOG(FATAL) << "Cannot read file " << file_name << ": " << strerror(errno);
+  }
+  struct stat file_stat;
+  if (fstat(file, &file_stat) == -1) {
+    LOG(FATAL) << "Cannot read file " << file_name << ": " << strerror(errno);
+  }
+  FileKey key(file_stat.st_dev, file_stat.st_ino, file_stat.st_size, file_stat.st_mtime);
+
+  std::lock_guard<std::mutex> lock(open_images_mutex);
+  shared_ptr<const ROMImage> image = open_images[key].lock();
+  if (image != nullptr) {
+    close(file);
+    return image;
+  }
+
+  shared_ptr<ROMImage> new_image(new ROMImage());
+  new_image->size_ = file_stat.st_size;
+  if (new_image->size_ > 0) {
+    void* mapping = mmap(nullptr, new_image->size_, PROT_READ, MAP_SHARED, file, 0);
+    if (mapping == MAP_FAILED) {
+      LOG(FATAL) << "Cannot map file " << file_name << ": " << strerror(errno);
+    }
+    new_image->mapping_ = mapping;
+    new_image->data_ = static_cast<const unsigned char*>(mapping);
+  }
+  close(file);
+
+  // Drop the entries of images which have since been destroyed.
+  for (auto entry = open_images.begin(); entry != open_images.end();) {
+    if (entry->second.expired()) {
+      entry = open_images.erase(entry);
+    } else {
+      ++entry;
+    }
+  }
+  open_images[key] = new_image;
+  return new_image;
+}
+
+shared_ptr<const ROMImage> ROMImage::Copy(const unsigned char* rom, long size) {
+  shared_ptr<ROMImage> image(new ROMImage());
+  image->copy_.assign(rom, rom + size);
+  image->data_ = image->copy_.data();
+  image->size_ = size;
+  return image;
+}
+
+ROMImage::~ROMImage() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, size_);
+  }
+}
+
+} // namespace memory
+} // namespace back_end
@@ -0,0 +1,44 @@
+#ifndef TURBO_SANTA_COMMON_BACK_END_MEMORY_ROM_IMAGE_H_
+#define TURBO_SANTA_COMMON_BACK_END_MEMORY_ROM_IMAGE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace back_end {
+namespace memory {
+
+// The contents of a cartridge ROM, which never change once loaded. A ROM read
+// from a file is mapped into memory read only rather than copied, and every
+// Open of the same file while an image of it is still alive returns that
+// image, so any number of emulators running one game in a process share a
+// single copy of it.
+class ROMImage {
+ public:
+  // Dies if the file cannot be read.
+  static std::shared_ptr<const ROMImage> Open(const std::string& file_name);
+
+  // For a ROM which is already in memory; the bytes are copied.
+  static std::shared_ptr<const ROMImage> Copy(const unsigned char* rom, long size);
+
+  ~ROMImage();
+
+  const unsigned char* data() const { return data_; }
+  long size() const { return size_; }
+
+ private:
+  ROMImage() {}
+  ROMImage(const ROMImage&) = delete;
+  ROMImage& operator=(const ROMImage&) = delete;
+
+  const unsigned char* data_ = nullptr;
+  long size_ = 0;
+  // Set if data_ is a mapping which has to be unmapped.
+  void* mapping_ = nullptr;
+  // Holds data_ otherwise.
+  std::vector<unsigned char> copy_;
+};
+
+} // namespace memory
+} // namespace back_end
+#endif // TURBO_SANTA_COMMON_BACK_END_MEMORY_ROM_IMAGE_H_
@@ -0,0 +1,99 @@
+#include "backend/memory/rom_image.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "backend/memory/mbc_module.h"
+#include "submodules/googletest/include/gtest/gtest.h"
+
+namespace back_end {
+namespace memory {
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using std::weak_ptr;
+
+namespace {
+
+// A ROM of size bytes for the cartridge type given, with every byte set to
+// something that depends on where it is.
+vector<unsigned char> TestROM(long size, unsigned char cartridge_type, unsigned char rom_size) {
+  vector<unsigned char> rom(size);
+  for (long i = 0; i < size; i++) {
+    rom[i] = static_cast<unsigned char>(i * 7 + (i >> 14));
+  }
+  rom[0x147] = cartridge_type;
+  rom[0x148] = rom_size;
+  rom[0x149] = 0x00;
+  return rom;
+}
+
+// A file holding contents, removed when this goes.
+class TemporaryFile {
+ public:
+  explicit TemporaryFile(const vector<unsigned char>& contents) {
+    char name[] = "/tmp/rom_image_test.XXXXXX";
+    int file = mkstemp(name);
+    EXPECT_NE(-1, file);
+    EXPECT_EQ(static_cast<ssize_t>(contents.size()), write(file, contents.data(), contents.size()));
+    close(file);
+    name_ = name;
+  }
+  ~TemporaryFile() { unlink(name_.c_str()); }
+
+  const string& name() const { return name_; }
+
+ private:
+  string name_;
+};
+
+} // namespace
+
+TEST(ROMImageTest, CopyHoldsTheBytes) {
+  vector<unsigned char> rom = TestROM(0x8000, 0x00, 0x00);
+  shared_ptr<const ROMImage> image = ROMImage::Copy(rom.data(), rom.size());
+  ASSERT_EQ(static_cast<long>(rom.size()), image->size());
+  EXPECT_EQ(rom, vector<unsigned char>(image->data(), image->data() + image->size()));
+}
+
+TEST(ROMImageTest, OpenSharesAnImageUntilItIsGone) {
+  vector<unsigned char> rom = TestROM(0x8000, 0x00, 0x00);
+  TemporaryFile file(rom);
+  shared_ptr<const ROMImage> image = ROMImage::Open(file.name());
+  ASSERT_EQ(static_cast<long>(rom.size()), image->size());
+  EXPECT_EQ(rom, vector<unsigned char>(image->data(), image->data() + image->size()));
+  EXPECT_EQ(image, ROMImage::Open(file.name()));
+
+  weak_ptr<const ROMImage> old_image = image;
+  image.reset();
+  EXPECT_TRUE(old_image.expired());
+  image = ROMImage::Open(file.name());
+  EXPECT_EQ(rom, vector<unsigned char>(image->data(), image->data() + image->size()));
+}
+
+// The MBC holds the image through its banks, and is deleted through its
+// MemorySegment base, so this fails if that does not run the MBC's destructor.
+TEST(ROMImageTest, MBCModuleLetsGoOfTheImage) {
+  const vector<vector<unsigned char>> roms = {
+    TestROM(0x8000, 0x00, 0x00), // No MBC.
+    TestROM(0x10000, 0x01, 0x01), // MBC1 with four banks.
+  };
+  for (const vector<unsigned char>& rom : roms) {
+    shared_ptr<const ROMImage> image = ROMImage::Copy(rom.data(), rom.size());
+    weak_ptr<const ROMImage> weak_image = image;
+    {
+      MBCModule mbc_module;
+      mbc_module.Init(image);
+      EXPECT_LT(1, image.use_count());
+    }
+    EXPECT_EQ(1, image.use_count());
+    image.reset();
+    EXPECT_TRUE(weak_image.expired());
+  }
+}
+
+} // namespace memory
+} // namespace back_end
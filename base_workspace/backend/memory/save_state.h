@@ -0,0 +1,104 @@
+#ifndef TURBO_SANTA_COMMON_BACK_END_MEMORY_SAVE_STATE_H_
+#define TURBO_SANTA_COMMON_BACK_END_MEMORY_SAVE_STATE_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include "submodules/glog/src/glog/logging.h"
+
+namespace back_end {
+namespace memory {
+
+// Writes a save state: fixed size fields, little-endian, one after another in
+// the order they are read back, with no tags or padding. It writes into a
+// buffer it is given and never allocates. Without a buffer it only counts, so
+// that the size of a state can be found before making one.
+class StateWriter {
+ public:
+  StateWriter() {}
+  StateWriter(unsigned char* buffer, size_t capacity) : buffer_(buffer), capacity_(capacity) {}
+
+  void Write8(unsigned char value) { Write(value, 1); }
+  void Write16(unsigned short value) { Write(value, 2); }
+  void Write32(unsigned long value) { Write(value, 4); }
+  void Write64(unsigned long long value) { Write(value, 8); }
+  void WriteBool(bool value) { Write(value ? 1 : 0, 1); }
+
+  void WriteBytes(const unsigned char* values, size_t count) {
+    if (Fits(count)) {
+      memcpy(buffer_ + size_, values, count);
+    }
+    size_ += count;
+  }
+
+  // Bytes written so far, or that would have been if they had fit.
+  size_t size() const { return size_; }
+
+  // Whether everything written so far is in the buffer.
+  bool fits() const { return buffer_ != nullptr && size_ <= capacity_; }
+
+ private:
+  bool Fits(size_t count) const { return buffer_ != nullptr && size_ + count <= capacity_; }
+
+  void Write(unsigned long long value, int bytes) {
+    if (Fits(bytes)) {
+      for (int i = 0; i < bytes; i++) {
+        buffer_[size_ + i] = static_cast<unsigned char>(value >> (8 * i));
+      }
+    }
+    size_ += bytes;
+  }
+
+  unsigned char* buffer_ = nullptr;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+};
+
+// Reads back what a StateWriter wrote, in the same order. The state must have
+// been checked to be the right size before it is read, so running off the
+// end is a bug.
+class StateReader {
+ public:
+  StateReader(const unsigned char* data, size_t size) : data_(data), size_(size) {}
+
+  unsigned char Read8() { return Read(1); }
+  unsigned short Read16() { return Read(2); }
+  unsigned long Read32() { return Read(4); }
+  unsigned long long Read64() { return Read(8); }
+  bool ReadBool() { return Read(1) != 0; }
+
+  void ReadBytes(unsigned char* values, size_t count) {
+    Need(count);
+    memcpy(values, data_ + offset_, count);
+    offset_ += count;
+  }
+
+  // Bytes read so far.
+  size_t offset() const { return offset_; }
+
+ private:
+  void Need(size_t count) {
+    if (offset_ + count > size_) {
+      LOG(FATAL) << "Read past the end of a save state of " << size_ << " bytes.";
+    }
+  }
+
+  unsigned long long Read(int bytes) {
+    Need(bytes);
+    unsigned long long value = 0;
+    for (int i = 0; i < bytes; i++) {
+      value |= static_cast<unsigned long long>(data_[offset_ + i]) << (8 * i);
+    }
+    offset_ += bytes;
+    return value;
+  }
+
+  const unsigned char* data_;
+  size_t size_;
+  size_t offset_ = 0;
+};
+
+} // namespace memory
+} // namespace back_end
+
+#endif // TURBO_SANTA_COMMON_BACK_END_MEMORY_SAVE_STATE_H_
@@ -0,0 +1,86 @@
+#include "backend/memory/save_state.h"
+
+#include <vector>
+#include "submodules/googletest/include/gtest/gtest.h"
+
+namespace back_end {
+namespace memory {
+
+using std::vector;
+
+namespace {
+
+const unsigned char kBytes[] = {0xde, 0xad, 0xbe, 0xef, 0x00};
+
+// One field of every width, with every byte of each different.
+void WriteFields(StateWriter* writer) {
+  writer->Write8(0x81);
+  writer->Write16(0x8382);
+  writer->Write32(0x87868584ul);
+  writer->Write64(0x8f8e8d8c8b8a8988ull);
+  writer->WriteBool(true);
+  writer->WriteBool(false);
+  writer->WriteBytes(kBytes, sizeof(kBytes));
+}
+
+const size_t kFieldsSize = 1 + 2 + 4 + 8 + 1 + 1 + sizeof(kBytes);
+
+} // namespace
+
+TEST(SaveStateTest, ReadsBackEveryWidth) {
+  vector<unsigned char> buffer(kFieldsSize);
+  StateWriter writer(buffer.data(), buffer.size());
+  WriteFields(&writer);
+  EXPECT_TRUE(writer.fits());
+  EXPECT_EQ(kFieldsSize, writer.size());
+
+  StateReader reader(buffer.data(), buffer.size());
+  EXPECT_EQ(0x81, reader.Read8());
+  EXPECT_EQ(0x8382, reader.Read16());
+  EXPECT_EQ(0x87868584ul, reader.Read32());
+  EXPECT_EQ(0x8f8e8d8c8b8a8988ull, reader.Read64());
+  EXPECT_TRUE(reader.ReadBool());
+  EXPECT_FALSE(reader.ReadBool());
+  unsigned char bytes[sizeof(kBytes)];
+  reader.ReadBytes(bytes, sizeof(bytes));
+  EXPECT_EQ(vector<unsigned char>(kBytes, kBytes + sizeof(kBytes)), vector<unsigned char>(bytes, bytes + sizeof(bytes)));
+  EXPECT_EQ(kFieldsSize, reader.offset());
+}
+
+TEST(SaveStateTest, WritesLittleEndian) {
+  unsigned char buffer[4];
+  StateWriter writer(buffer, sizeof(buffer));
+  writer.Write32(0x04030201ul);
+  EXPECT_EQ(vector<unsigned char>({1, 2, 3, 4}), vector<unsigned char>(buffer, buffer + sizeof(buffer)));
+}
+
+TEST(SaveStateTest, CountingMatchesWriting) {
+  StateWriter counter;
+  WriteFields(&counter);
+  EXPECT_EQ(kFieldsSize, counter.size());
+  EXPECT_FALSE(counter.fits());
+}
+
+TEST(SaveStateTest, StopsWritingWhenFull) {
+  // One byte short, with a guard byte after it.
+  vector<unsigned char> buffer(kFieldsSize, 0x55);
+  StateWriter writer(buffer.data(), kFieldsSize - 1);
+  WriteFields(&writer);
+  EXPECT_FALSE(writer.fits());
+  EXPECT_EQ(kFieldsSize, writer.size());
+  EXPECT_EQ(0x55, buffer[kFieldsSize - 1]);
+}
+
+TEST(SaveStateDeathTest, ReadingPastTheEndIsFatal) {
+  vector<unsigned char> buffer(kFieldsSize);
+  StateWriter writer(buffer.data(), buffer.size());
+  WriteFields(&writer);
+  EXPECT_DEATH({
+    StateReader reader(buffer.data(), 3);
+    reader.Read8();
+    reader.Read32();
+  }, "");
+}
+
+} // namespace memory
+} // namespace back_end
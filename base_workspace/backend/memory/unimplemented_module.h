@@ -19,11 +19,16 @@ class UnimplementedFlag : public Flag {
     LOG(ERROR) << "Attempted to read unimplemented flag: " << name_;
     return 0;
   }
+  virtual const unsigned char* backing_byte() { return nullptr; }
   virtual void Write(unsigned short, unsigned char value) {
     unsigned short value_short = value;
     LOG(ERROR) << "Attempted to write unimplemented flag: " << name_ << " = 0x" << std::hex << value_short;
   }
 
+  // Holds nothing, since writes are dropped.
+  virtual void SaveState(StateWriter*) {}
+  virtual void LoadState(StateReader*) {}
+
   virtual unsigned char flag() {
     LOG(FATAL) << "Attempted to access unimplemented flag: " << name_;
   }
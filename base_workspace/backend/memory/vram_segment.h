@@ -1,8 +1,10 @@
 #ifndef TURBO_SANTA_COMMON_BACK_END_MEMORY_VRAM_SEGMENT_H_
 #define TURBO_SANTA_COMMON_BACK_END_MEMORY_VRAM_SEGMENT_H_
 
+#include <cstring>
 #include <vector>
 
+#include "backend/graphics/pixel_kernels.h"
 #include "backend/memory/memory_segment.h"
 #include "submodules/glog/src/glog/logging.h"
 
@@ -63,51 +65,246 @@ class ConcreteTile : public Tile {
   friend class TileData;
 };
 
+// The tiles in 0x8000 - 0x97ff with one color index per byte, redecoded a row
+// at a time as the tile data is written, so that drawing a row of a tile is a
+// copy of eight bytes. Each row is kept both ways round for sprites that are
+// flipped left to right; flipping top to bottom is only a matter of which row.
+class DecodedTiles {
+ public:
+  static const int kTileCount = 384;
+  static const int kTileBytes = 16;
+
+  DecodedTiles() : rows_(kTileCount * Tile::kTileSize * 2 * Tile::kTileSize, 0) {}
+
+  // Redecodes the row that byte offset of data, all of the tile data, is in.
+  void Update(const std::vector<unsigned char>& data, unsigned int offset) {
+    unsigned int row = offset / 2;
+    unsigned char* decoded = rows_.data() + row * 2 * Tile::kTileSize;
+    graphics::DecodeTileRow(data[row * 2], data[row * 2 + 1], false, decoded);
+    graphics::DecodeTileRow(data[row * 2], data[row * 2 + 1], true, decoded + Tile::kTileSize);
+  }
+
+  // Row y of the tile that starts at byte offset of the tile data, from left
+  // to right, or from right to left if x_flip.
+  const unsigned char* row(unsigned int offset, unsigned int y, bool x_flip) {
+    return rows_.data() + (offset / 2 + y) * 2 * Tile::kTileSize + (x_flip ? Tile::kTileSize : 0);
+  }
+
+ private:
+  std::vector<unsigned char> rows_;
+};
+
+// One of the two ways of numbering the tiles in 0x8000 - 0x97ff. data holds all
+// of that memory, starting at 0x8000; the two overlap at 0x8800 - 0x8fff.
 class TileData : public ContiguousMemorySegment {
  public:
-  TileData(std::vector<unsigned char>* data, unsigned short start_address) :
-      data_(data), start_address_(start_address) {}
-  virtual unsigned char Read(unsigned short address) { return data_->at(address - lower_address_bound()); }
-  virtual void Write(unsigned short address, unsigned char value) { data_->at(address - lower_address_bound()) = value; }
+  TileData(std::vector<unsigned char>* data, DecodedTiles* decoded_tiles, unsigned short start_address) :
+      data_(data), decoded_tiles_(decoded_tiles), start_address_(start_address) {}
+  virtual unsigned char Read(unsigned short address) { return data_->at(address - kRawStartAddress); }
+  virtual void Write(unsigned short address, unsigned char value) {
+    data_->at(address - kRawStartAddress) = value;
+    decoded_tiles_->Update(*data_, address - kRawStartAddress);
+  }
   virtual Tile* tile(unsigned char value) {
-    tile_.start_ptr_ = data_->data() + static_cast<unsigned long>(value) * 16;
+    tile_.start_ptr_ = data_->data() + tile_offset(value);
     return &tile_;
   }
 
+  // The color indices of row y of the tile, as DecodedTiles::row.
+  const unsigned char* decoded_row(unsigned char value, unsigned int y, bool x_flip = false) {
+    return decoded_tiles_->row(tile_offset(value), y, x_flip);
+  }
+
   static const int kTileDataSize = 0x1000;
+  static const int kTileBytes = DecodedTiles::kTileBytes;
  protected:
+  static const unsigned short kRawStartAddress = 0x8000;
+
+  // Where tile number value starts in data_.
+  virtual int tile_offset(unsigned char value) { return value * kTileBytes; }
+
   unsigned short lower_address_bound() { return start_address_; }
   unsigned short upper_address_bound() { return lower_address_bound() + kTileDataSize - 1; } // Bound is not length!!!
  private:
   std::vector<unsigned char>* data_;
+  DecodedTiles* decoded_tiles_;
   unsigned short start_address_;
   ConcreteTile tile_;
 };
 
 class LowerTileData : public TileData {
  public:
-  LowerTileData(std::vector<unsigned char>* data) : TileData(data, 0x8000) {}
+  LowerTileData(std::vector<unsigned char>* data, DecodedTiles* decoded_tiles) :
+      TileData(data, decoded_tiles, 0x8000) {}
 };
 
 class UpperTileData : public TileData {
  public:
-  UpperTileData(std::vector<unsigned char>* data) : TileData(data, 0x8800) {}
+  UpperTileData(std::vector<unsigned char>* data, DecodedTiles* decoded_tiles) :
+      TileData(data, decoded_tiles, 0x8800) {}
 
-  virtual Tile* tile(unsigned char value) {
-    // Actually value is signed so we have to shift it.
-    return TileData::tile(static_cast<char>(value) + 0x80);
+ protected:
+  // Numbered from -128 to 127, with tile 0 at 0x9000.
+  virtual int tile_offset(unsigned char value) {
+    return 0x9000 - kRawStartAddress + static_cast<signed char>(value) * kTileBytes;
+  }
+};
+
+// A background map drawn out in full, as the color index of each of its
+// 256x256 pixels, so that a line of it is one or two copies however it is
+// scrolled. Only the cells that have changed are drawn again: the ones written
+// to in the map, and the ones showing a tile whose data was written to, which
+// are found through a list of the cells showing each tile number.
+class MapLayer {
+ public:
+  static const int kCellsPerSide = 32;
+  static const int kCells = kCellsPerSide * kCellsPerSide;
+  static const int kSize = kCellsPerSide * Tile::kTileSize; // Square.
+
+  // map is the kCells tile numbers of the map, a row at a time.
+  MapLayer(const std::vector<unsigned char>* map, DecodedTiles* decoded_tiles) :
+      map_(map),
+      decoded_tiles_(decoded_tiles),
+      pixels_(kSize * kSize, 0),
+      cells_showing_(kTileNumbers),
+      positions_(kCells),
+      cell_dirty_(kCells, false),
+      tile_number_dirty_(kTileNumbers, false) {
+    // The map starts out all tile number 0.
+    for (int cell = 0; cell < kCells; cell++) {
+      cells_showing_[0].push_back(cell);
+      positions_[cell] = cell;
+    }
+  }
+
+  // Called when cell of the map changes from old_value to new_value.
+  void CellChanged(unsigned int cell, unsigned char old_value, unsigned char new_value) {
+    if (old_value == new_value) {
+      return;
+    }
+    std::vector<unsigned short>* old_cells = &cells_showing_[old_value];
+    unsigned short moved_cell = old_cells->back();
+    (*old_cells)[positions_[cell]] = moved_cell;
+    positions_[moved_cell] = positions_[cell];
+    old_cells->pop_back();
+    positions_[cell] = cells_showing_[new_value].size();
+    cells_showing_[new_value].push_back(cell);
+    MarkCell(cell);
+  }
+
+  // Called when the tile data at byte offset from 0x8000 changes.
+  void TileChanged(unsigned int offset) {
+    int tile = offset / DecodedTiles::kTileBytes;
+    int value;
+    if (signed_tiles_) {
+      if (tile < 128) {
+        return;
+      }
+      value = (tile - 256) & 0xff;
+    } else {
+      if (tile >= 256) {
+        return;
+      }
+      value = tile;
+    }
+    if (!tile_number_dirty_[value]) {
+      tile_number_dirty_[value] = true;
+      dirty_tile_numbers_.push_back(value);
+    }
+  }
+
+  // Row y of the layer, drawn with the map's tile numbers counted as
+  // UpperTileData counts them if signed_tiles, and as LowerTileData does if
+  // not. Draws the cells that changed first.
+  const unsigned char* row(int y, bool signed_tiles) {
+    if (signed_tiles != signed_tiles_ || !dirty_cells_.empty() || !dirty_tile_numbers_.empty()) {
+      Update(signed_tiles);
+    }
+    return pixels_.data() + y * kSize;
+  }
+
+ private:
+  static const int kTileNumbers = 256;
+
+  void MarkCell(unsigned short cell) {
+    if (!cell_dirty_[cell]) {
+      cell_dirty_[cell] = true;
+      dirty_cells_.push_back(cell);
+    }
+  }
+
+  void Update(bool signed_tiles) {
+    // Every cell shows a different tile when the numbering changes.
+    if (signed_tiles != signed_tiles_) {
+      signed_tiles_ = signed_tiles;
+      for (int cell = 0; cell < kCells; cell++) {
+        MarkCell(cell);
+      }
+    }
+    for (unsigned char value : dirty_tile_numbers_) {
+      tile_number_dirty_[value] = false;
+      for (unsigned short cell : cells_showing_[value]) {
+        MarkCell(cell);
+      }
+    }
+    dirty_tile_numbers_.clear();
+    for (unsigned short cell : dirty_cells_) {
+      cell_dirty_[cell] = false;
+      DrawCell(cell);
+    }
+    dirty_cells_.clear();
   }
+
+  void DrawCell(unsigned short cell) {
+    unsigned char value = (*map_)[cell];
+    // As TileData::tile_offset.
+    int offset = signed_tiles_ ? 0x1000 + static_cast<signed char>(value) * DecodedTiles::kTileBytes
+                               : value * DecodedTiles::kTileBytes;
+    unsigned char* pixels = pixels_.data() +
+        (cell / kCellsPerSide) * Tile::kTileSize * kSize + (cell % kCellsPerSide) * Tile::kTileSize;
+    for (int y = 0; y < Tile::kTileSize; y++) {
+      memcpy(pixels + y * kSize, decoded_tiles_->row(offset, y, false), Tile::kTileSize);
+    }
+  }
+
+  const std::vector<unsigned char>* map_;
+  DecodedTiles* decoded_tiles_;
+  bool signed_tiles_ = false;
+  std::vector<unsigned char> pixels_;
+  // The cells showing each tile number, in no order, and where each cell is
+  // in its list.
+  std::vector<std::vector<unsigned short>> cells_showing_;
+  std::vector<unsigned short> positions_;
+  std::vector<bool> cell_dirty_;
+  std::vector<unsigned short> dirty_cells_;
+  std::vector<bool> tile_number_dirty_;
+  std::vector<unsigned char> dirty_tile_numbers_;
 };
 
 class BackgroundMap : public ContiguousMemorySegment {
  public:
-  BackgroundMap(unsigned short start_address) :
-      data_(kWidth * kHeight, 0x00), start_address_(start_address) {}
+  BackgroundMap(unsigned short start_address, DecodedTiles* decoded_tiles) :
+      data_(kWidth * kHeight, 0x00), start_address_(start_address), layer_(&data_, decoded_tiles) {}
   virtual unsigned char Read(unsigned short address) { return data_[address - lower_address_bound()]; }
-  virtual void Write(unsigned short address, unsigned char value) { data_[address - lower_address_bound()] = value; }
+  virtual void Write(unsigned short address, unsigned char value) { SetCell(address - lower_address_bound(), value); }
 
   virtual unsigned char Get(int y, int x) { return data_[x + y * kWidth]; }
-  virtual void Set(int y, int x, unsigned char value) { data_[x + y * kWidth] = value; }
+  virtual void Set(int y, int x, unsigned char value) { SetCell(x + y * kWidth, value); }
+
+  // The map drawn out, kept up to date by Write and Set, and by the
+  // VRAMSegment for writes to the tile data.
+  MapLayer* layer() { return &layer_; }
+
+  // All kWidth * kHeight entries, a row at a time.
+  const unsigned char* data() const { return data_.data(); }
+
+  virtual void SaveState(StateWriter* writer) { writer->WriteBytes(data_.data(), data_.size()); }
+
+  virtual void LoadState(StateReader* reader) {
+    for (unsigned int cell = 0; cell < data_.size(); cell++) {
+      SetCell(cell, reader->Read8());
+    }
+  }
 
   static const int kHeight = 32;
   static const int kWidth = 32;
@@ -115,20 +312,27 @@ class BackgroundMap : public ContiguousMemorySegment {
   unsigned short lower_address_bound() { return start_address_; }
   unsigned short upper_address_bound() { return lower_address_bound() + kWidth * kHeight - 1; }
  private:
+  void SetCell(unsigned int cell, unsigned char value) {
+    layer_.CellChanged(cell, data_[cell], value);
+    data_[cell] = value;
+  }
+
   std::vector<unsigned char> data_;
   unsigned short start_address_;
+  MapLayer layer_;
 };
 
 class VRAMSegment : public ContiguousMemorySegment {
  public:
   VRAMSegment() :
       raw_tile_data_(0x97ff - 0x8000 + 1, 0x00),
-      lower_background_map_(0x9800),
-      upper_background_map_(0x9c00),
-      lower_tile_data_(&raw_tile_data_),
-      upper_tile_data_(&raw_tile_data_) {}
+      lower_background_map_(0x9800, &decoded_tiles_),
+      upper_background_map_(0x9c00, &decoded_tiles_),
+      lower_tile_data_(&raw_tile_data_, &decoded_tiles_),
+      upper_tile_data_(&raw_tile_data_, &decoded_tiles_) {}
 
   virtual unsigned char Read(unsigned short address) {
+    Access();
     // if (!enabled_) {
     //   return 0xff;
     // }
@@ -147,26 +351,21 @@ class VRAMSegment : public ContiguousMemorySegment {
   }
 
   virtual void Write(unsigned short address, unsigned char value) {
+    Access();
     // if (!enabled_) {
     //   return;
     // }
 
     if (lower_background_map_.InRange(address)) {
-      LOG(INFO) << "Writting " << std::hex << 0x0000 + value << " to "
-                << std::hex << address << " in LowerBackgroundMap";
       lower_background_map_.Write(address, value);
     } else if (upper_background_map_.InRange(address)) {
-      LOG(INFO) << "Writting " << std::hex << 0x0000 + value << " to "
-                << std::hex << address << " in UpperBackgroundMap";
       upper_background_map_.Write(address, value);
     } else if (lower_tile_data_.InRange(address)) {
-      LOG(INFO) << "Writting " << std::hex << 0x0000 + value << " to "
-                << std::hex << address << " in LowerTileData";
       lower_tile_data_.Write(address, value);
+      TileDataWritten(address);
     } else if (upper_tile_data_.InRange(address)) {
-      LOG(INFO) << "Writting " << std::hex << 0x0000 + value << " to "
-                << std::hex << address << " in UpperTileData";
       upper_tile_data_.Write(address, value);
+      TileDataWritten(address);
     } else {
       LOG(FATAL) << "Attempted Write outside of owned region: " << address;
     }
@@ -176,18 +375,46 @@ class VRAMSegment : public ContiguousMemorySegment {
 
   virtual void Disable() { enabled_ = false; }
 
+  // The tile data and both maps. Whether VRAM is enabled is the
+  // GraphicsController's to restore, along with the mode.
+  virtual void SaveState(StateWriter* writer) {
+    writer->WriteBytes(raw_tile_data_.data(), raw_tile_data_.size());
+    lower_background_map_.SaveState(writer);
+    upper_background_map_.SaveState(writer);
+  }
+
+  virtual void LoadState(StateReader* reader) {
+    reader->ReadBytes(raw_tile_data_.data(), raw_tile_data_.size());
+    for (unsigned int offset = 0; offset < raw_tile_data_.size(); offset += 2) {
+      decoded_tiles_.Update(raw_tile_data_, offset);
+    }
+    for (unsigned int offset = 0; offset < raw_tile_data_.size(); offset += DecodedTiles::kTileBytes) {
+      TileDataWritten(0x8000 + offset);
+    }
+    lower_background_map_.LoadState(reader);
+    upper_background_map_.LoadState(reader);
+  }
+
   BackgroundMap* lower_background_map() { return &lower_background_map_; }
   BackgroundMap* upper_background_map() { return &upper_background_map_; }
   TileData* lower_tile_data() { return &lower_tile_data_; }
   TileData* upper_tile_data() { return &upper_tile_data_; }
+  // 0x8000 - 0x97ff.
+  const std::vector<unsigned char>& raw_tile_data() const { return raw_tile_data_; }
 
  protected:
   unsigned short lower_address_bound() { return 0x8000; }
   unsigned short upper_address_bound() { return 0x9fff; }
 
  private:
+  void TileDataWritten(unsigned short address) {
+    lower_background_map_.layer()->TileChanged(address - 0x8000);
+    upper_background_map_.layer()->TileChanged(address - 0x8000);
+  }
+
   bool enabled_ = true;
   std::vector<unsigned char> raw_tile_data_;
+  DecodedTiles decoded_tiles_;
   BackgroundMap lower_background_map_;
   BackgroundMap upper_background_map_;
   LowerTileData lower_tile_data_;
@@ -201,7 +428,8 @@ class SpriteAttribute {
   unsigned char y() { return data_[0]; }
   unsigned char x() { return data_[1]; }
   unsigned char tile_index() { return data_[2]; }
-  bool over_background() { return bit(7); }
+  // Set if the background and window show through wherever their color is not 0.
+  bool behind_background() { return bit(7); }
   bool y_flip() { return bit(6); }
   bool x_flip() { return bit(5); }
   bool palette() { return bit(4); }
@@ -224,12 +452,39 @@ class OAMSegment : public ContiguousMemorySegment {
 
   OAMSegment() : data_(kEndAddress - kStartAddress + 1, 0) {}
 
-  virtual unsigned char Read(unsigned short address) { return data_[address - kStartAddress]; }
-  virtual void Write(unsigned short address, unsigned char value) { data_[address - kStartAddress] = value; }
+  virtual unsigned char Read(unsigned short address) {
+    Access();
+    return data_[address - kStartAddress];
+  }
+
+  virtual void Write(unsigned short address, unsigned char value) {
+    Access();
+    data_[address - kStartAddress] = value;
+    writes_++;
+  }
 
   virtual void Enable() { enabled_ = true; }
   virtual void Disable() { enabled_ = false; }
 
+  // Replaces all of OAM at once, as a DMA transfer does.
+  void WriteBlock(const unsigned char* values) {
+    Access();
+    memcpy(data_.data(), values, data_.size());
+    writes_++;
+  }
+
+  virtual void SaveState(StateWriter* writer) { writer->WriteBytes(data_.data(), data_.size()); }
+
+  // Counts as a write.
+  virtual void LoadState(StateReader* reader) {
+    reader->ReadBytes(data_.data(), data_.size());
+    writes_++;
+  }
+
+  // How many times OAM has been written to, by the CPU or by a DMA transfer,
+  // so that anything worked out from it knows when to work it out again.
+  unsigned long writes() const { return writes_; }
+
   virtual SpriteAttribute* sprite_attribute(unsigned int value) {
     if (value >= kAttributeNumber) {
       LOG(FATAL) << "Attempted to access sprite beyond 40: " << value;
@@ -240,12 +495,16 @@ class OAMSegment : public ContiguousMemorySegment {
 
   static const int kAttributeNumber = 40;
 
+  // All of OAM, from kStartAddress.
+  const std::vector<unsigned char>& data() const { return data_; }
+
  protected:
   unsigned short lower_address_bound() { return kStartAddress; }
   unsigned short upper_address_bound() { return kEndAddress; }
  private:
   std::vector<unsigned char> data_;
   SpriteAttribute sprite_attribute_;
+  unsigned long writes_ = 0;
   bool enabled_ = true;
 };
 
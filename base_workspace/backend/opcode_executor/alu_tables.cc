@@ -0,0 +1,174 @@
+#include "backend/opcode_executor/alu_tables.h"
+
+namespace back_end {
+namespace handlers {
+
+namespace {
+constexpr unsigned int Bit(unsigned int value, int n) {
+  return (value >> n) & 1;
+}
+
+// Same as DoesOverflow and DoesUnderflow in opcode_handlers.cc.
+constexpr bool Overflows(unsigned int left, unsigned int right, int bit) {
+  return (Bit(left, bit) && Bit(right, bit)) ||
+      ((Bit(left, bit) || Bit(right, bit)) && !Bit(left + right, bit));
+}
+
+constexpr bool Underflows(unsigned int left, unsigned int right, int bit) {
+  return (!Bit(left, bit) && (Bit(right, bit) || Bit(left - right, bit))) ||
+      (Bit(left, bit) && Bit(right, bit) && Bit(left - right, bit));
+}
+
+// Z always comes from the result.
+constexpr AluResult Entry(unsigned int value, bool n, bool h, bool c) {
+  return (value & 0xff) |
+      (((value & 0xff) == 0 ? kZFlag : 0) | (n ? kNFlag : 0) |
+       (h ? kHFlag : 0) | (c ? kCFlag : 0)) << 8;
+}
+
+constexpr AluResult Add(unsigned int index) {
+  return Entry((index >> 8) + (index & 0xff), false,
+               Overflows(index >> 8, index & 0xff, 3),
+               Overflows(index >> 8, index & 0xff, 7));
+}
+
+// SUB has always set H and C when there is no borrow.
+constexpr AluResult Sub(unsigned int index) {
+  return Entry((index >> 8) - (index & 0xff), true,
+               !Underflows(index >> 8, index & 0xff, 3),
+               !Underflows(index >> 8, index & 0xff, 7));
+}
+
+// ADC and SBC with the carry set. The carry goes into each half rather than
+// into n, which would lose it when n is 0xff.
+constexpr AluResult AddCarry(unsigned int index) {
+  return Entry((index >> 8) + (index & 0xff) + 1, false,
+               ((index >> 8) & 0xf) + (index & 0xf) + 1 > 0xf,
+               (index >> 8) + (index & 0xff) + 1 > 0xff);
+}
+
+constexpr AluResult SubCarry(unsigned int index) {
+  return Entry((index >> 8) - (index & 0xff) - 1, true,
+               ((index >> 8) & 0xf) >= (index & 0xf) + 1,
+               (index >> 8) >= (index & 0xff) + 1);
+}
+
+constexpr AluResult Inc(unsigned int value) {
+  return Entry(value + 1, false, Overflows(value, 1, 3), false);
+}
+
+constexpr AluResult Dec(unsigned int value) {
+  return Entry(value - 1, true, Underflows(value, 1, 3), false);
+}
+
+// The loop in the DAA handler, one iteration per call.
+constexpr unsigned int DaaSum(unsigned int sum, unsigned int n, unsigned int mul) {
+  return n == 0 ? sum : DaaSum((sum + n * mul) & 0xff, n / 10, (mul * 0x0F) & 0xff);
+}
+
+constexpr AluResult Daa(unsigned int value) {
+  return Entry(DaaSum(value, value / 10, 0x6), false, false, value > 0x64);
+}
+
+// For the shift table, index is AluIndex(carry in, value).
+constexpr AluResult Rlc(unsigned int index) {
+  return Entry((index << 1) | Bit(index, 7), false, false, Bit(index, 7));
+}
+
+constexpr AluResult Rrc(unsigned int index) {
+  return Entry(((index & 0xff) >> 1) | Bit(index, 0) << 7, false, false, Bit(index, 0));
+}
+
+constexpr AluResult Rl(unsigned int index) {
+  return Entry((index << 1) | Bit(index, 8), false, false, Bit(index, 7));
+}
+
+constexpr AluResult Rr(unsigned int index) {
+  return Entry(((index & 0xff) >> 1) | Bit(index, 8) << 7, false, false, Bit(index, 0));
+}
+
+constexpr AluResult Sla(unsigned int index) {
+  return Entry(index << 1, false, false, Bit(index, 7));
+}
+
+constexpr AluResult Sra(unsigned int index) {
+  return Entry(((index & 0xff) >> 1) | (index & 0x80), false, false, Bit(index, 0));
+}
+
+constexpr AluResult Srl(unsigned int index) {
+  return Entry((index & 0xff) >> 1, false, false, Bit(index, 0));
+}
+
+constexpr AluResult Swap(unsigned int index) {
+  return Entry((index << 4) | ((index & 0xff) >> 4), false, false, false);
+}
+} // namespace
+
+// Expands to entry(start), entry(start + 1), ... for 16, 256, 4096 or 65536
+// consecutive indices. C++11 constexpr functions cannot loop over an array,
+// so the initializer lists are spelled out by the preprocessor instead.
+#define ALU_ENTRIES_16(entry, start) \
+    entry(start + 0x0), entry(start + 0x1), entry(start + 0x2), entry(start + 0x3), \
+    entry(start + 0x4), entry(start + 0x5), entry(start + 0x6), entry(start + 0x7), \
+    entry(start + 0x8), entry(start + 0x9), entry(start + 0xa), entry(start + 0xb), \
+    entry(start + 0xc), entry(start + 0xd), entry(start + 0xe), entry(start + 0xf)
+#define ALU_ENTRIES_256(entry, start) \
+    ALU_ENTRIES_16(entry, start + 0x00), ALU_ENTRIES_16(entry, start + 0x10), \
+    ALU_ENTRIES_16(entry, start + 0x20), ALU_ENTRIES_16(entry, start + 0x30), \
+    ALU_ENTRIES_16(entry, start + 0x40), ALU_ENTRIES_16(entry, start + 0x50), \
+    ALU_ENTRIES_16(entry, start + 0x60), ALU_ENTRIES_16(entry, start + 0x70), \
+    ALU_ENTRIES_16(entry, start + 0x80), ALU_ENTRIES_16(entry, start + 0x90), \
+    ALU_ENTRIES_16(entry, start + 0xa0), ALU_ENTRIES_16(entry, start + 0xb0), \
+    ALU_ENTRIES_16(entry, start + 0xc0), ALU_ENTRIES_16(entry, start + 0xd0), \
+    ALU_ENTRIES_16(entry, start + 0xe0), ALU_ENTRIES_16(entry, start + 0xf0)
+#define ALU_ENTRIES_4K(entry, start) \
+    ALU_ENTRIES_256(entry, start + 0x000), ALU_ENTRIES_256(entry, start + 0x100), \
+    ALU_ENTRIES_256(entry, start + 0x200), ALU_ENTRIES_256(entry, start + 0x300), \
+    ALU_ENTRIES_256(entry, start + 0x400), ALU_ENTRIES_256(entry, start + 0x500), \
+    ALU_ENTRIES_256(entry, start + 0x600), ALU_ENTRIES_256(entry, start + 0x700), \
+    ALU_ENTRIES_256(entry, start + 0x800), ALU_ENTRIES_256(entry, start + 0x900), \
+    ALU_ENTRIES_256(entry, start + 0xa00), ALU_ENTRIES_256(entry, start + 0xb00), \
+    ALU_ENTRIES_256(entry, start + 0xc00), ALU_ENTRIES_256(entry, start + 0xd00), \
+    ALU_ENTRIES_256(entry, start + 0xe00), ALU_ENTRIES_256(entry, start + 0xf00)
+#define ALU_ENTRIES_64K(entry) \
+    ALU_ENTRIES_4K(entry, 0x0000), ALU_ENTRIES_4K(entry, 0x1000), \
+    ALU_ENTRIES_4K(entry, 0x2000), ALU_ENTRIES_4K(entry, 0x3000), \
+    ALU_ENTRIES_4K(entry, 0x4000), ALU_ENTRIES_4K(entry, 0x5000), \
+    ALU_ENTRIES_4K(entry, 0x6000), ALU_ENTRIES_4K(entry, 0x7000), \
+    ALU_ENTRIES_4K(entry, 0x8000), ALU_ENTRIES_4K(entry, 0x9000), \
+    ALU_ENTRIES_4K(entry, 0xa000), ALU_ENTRIES_4K(entry, 0xb000), \
+    ALU_ENTRIES_4K(entry, 0xc000), ALU_ENTRIES_4K(entry, 0xd000), \
+    ALU_ENTRIES_4K(entry, 0xe000), ALU_ENTRIES_4K(entry, 0xf000)
+#define ALU_ENTRIES_512(entry) \
+    ALU_ENTRIES_256(entry, 0x000), ALU_ENTRIES_256(entry, 0x100)
+
+constexpr AluResult kAddTable[2][0x10000] = {
+  {ALU_ENTRIES_64K(Add)},
+  {ALU_ENTRIES_64K(AddCarry)},
+};
+constexpr AluResult kSubTable[2][0x10000] = {
+  {ALU_ENTRIES_64K(Sub)},
+  {ALU_ENTRIES_64K(SubCarry)},
+};
+constexpr AluResult kIncTable[0x100] = {ALU_ENTRIES_256(Inc, 0)};
+constexpr AluResult kDecTable[0x100] = {ALU_ENTRIES_256(Dec, 0)};
+constexpr AluResult kDaaTable[0x100] = {ALU_ENTRIES_256(Daa, 0)};
+constexpr AluResult kShiftTable[SHIFT_OPERATION_COUNT][0x200] = {
+  {ALU_ENTRIES_512(Rlc)},
+  {ALU_ENTRIES_512(Rrc)},
+  {ALU_ENTRIES_512(Rl)},
+  {ALU_ENTRIES_512(Rr)},
+  {ALU_ENTRIES_512(Sla)},
+  {ALU_ENTRIES_512(Sra)},
+  {ALU_ENTRIES_512(Srl)},
+  {ALU_ENTRIES_512(Swap)},
+};
+
+#undef ALU_ENTRIES_512
+#undef ALU_ENTRIES_64K
+#undef ALU_ENTRIES_4K
+#undef ALU_ENTRIES_256
+#undef ALU_ENTRIES_16
+
+} // namespace handlers
+} // namespace back_end
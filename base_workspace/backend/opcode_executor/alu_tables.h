@@ -0,0 +1,64 @@
+#ifndef TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_ALU_TABLES_H_
+#define TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_ALU_TABLES_H_
+
+namespace back_end {
+namespace handlers {
+
+// Precomputed results of the 8-bit ALU operations, so that a handler gets its
+// result and every flag it sets from one load. Each entry holds the result in
+// the low byte and the flags in the high byte, in the same bit positions the
+// F register uses on hardware. The tables are constant initialized, so they
+// sit in the binary rather than being filled in at startup, and without a
+// carry in they agree exactly with the DoesCarry8 family of helpers in
+// opcode_handlers.h.
+typedef unsigned short AluResult;
+
+const unsigned char kZFlag = 0x80;
+const unsigned char kNFlag = 0x40;
+const unsigned char kHFlag = 0x20;
+const unsigned char kCFlag = 0x10;
+const unsigned char kAllFlags = kZFlag | kNFlag | kHFlag | kCFlag;
+
+inline unsigned char AluValue(AluResult entry) {
+  return entry & 0xff;
+}
+
+inline unsigned char AluFlags(AluResult entry) {
+  return entry >> 8;
+}
+
+inline int AluIndex(unsigned char left, unsigned char right) {
+  return left << 8 | right;
+}
+
+// ADC A,n and SBC A,n, indexed by the carry in and then by AluIndex(A, n).
+// ADD and SUB are the entries for no carry, and CP uses the flags from those
+// in kSubTable.
+extern const AluResult kAddTable[2][0x10000];
+extern const AluResult kSubTable[2][0x10000];
+
+// INC and DEC of a byte; C is left alone, so it is never set here.
+extern const AluResult kIncTable[0x100];
+extern const AluResult kDecTable[0x100];
+
+// DAA of A; N is left alone, so it is never set here.
+extern const AluResult kDaaTable[0x100];
+
+// Rotates, shifts and SWAP, indexed by operation and then by
+// AluIndex(carry in, value). Only RL and RR look at the carry.
+enum ShiftOperation {
+  SHIFT_RLC,
+  SHIFT_RRC,
+  SHIFT_RL,
+  SHIFT_RR,
+  SHIFT_SLA,
+  SHIFT_SRA,
+  SHIFT_SRL,
+  SHIFT_SWAP,
+  SHIFT_OPERATION_COUNT
+};
+extern const AluResult kShiftTable[SHIFT_OPERATION_COUNT][0x200];
+
+} // namespace handlers
+} // namespace back_end
+#endif // TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_ALU_TABLES_H_
@@ -0,0 +1,106 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "backend/opcode_executor/alu_tables.h"
+#include "backend/opcode_executor/opcode_handlers.h"
+#include "submodules/glog/src/glog/logging.h"
+
+// Times ADD and SUB flag computation through the lookup tables against the
+// DoesCarry8 family of helpers they replaced, after checking that both give
+// the same answer for every pair of operands.
+//
+// bazel run -c opt //backend/opcode_executor:alu_tables_benchmark
+
+using back_end::handlers::AluFlags;
+using back_end::handlers::AluResult;
+using back_end::handlers::AluValue;
+using back_end::handlers::DoesBorrow8;
+using back_end::handlers::DoesCarry8;
+using back_end::handlers::DoesHalfBorrow8;
+using back_end::handlers::DoesHalfCarry8;
+using back_end::handlers::kAddTable;
+using back_end::handlers::kCFlag;
+using back_end::handlers::kHFlag;
+using back_end::handlers::kNFlag;
+using back_end::handlers::kSubTable;
+using back_end::handlers::kZFlag;
+using std::vector;
+
+namespace {
+const int kOperandCount = 1 << 20;
+const int kPasses = 64;
+
+AluResult AddWithHelpers(unsigned char left, unsigned char right) {
+  unsigned char value = left + right;
+  unsigned char flags = (value == 0 ? kZFlag : 0) |
+      (DoesHalfCarry8(left, right) ? kHFlag : 0) |
+      (DoesCarry8(left, right) ? kCFlag : 0);
+  return value | flags << 8;
+}
+
+AluResult SubWithHelpers(unsigned char left, unsigned char right) {
+  unsigned char value = left - right;
+  unsigned char flags = (value == 0 ? kZFlag : 0) | kNFlag |
+      (!DoesHalfBorrow8(left, right) ? kHFlag : 0) |
+      (!DoesBorrow8(left, right) ? kCFlag : 0);
+  return value | flags << 8;
+}
+
+void CheckTables() {
+  for (int left = 0; left < 0x100; left++) {
+    for (int right = 0; right < 0x100; right++) {
+      int index = back_end::handlers::AluIndex(left, right);
+      if (kAddTable[0][index] != AddWithHelpers(left, right)) {
+        LOG(FATAL) << "kAddTable disagrees for " << left << " + " << right;
+      }
+      if (kSubTable[0][index] != SubWithHelpers(left, right)) {
+        LOG(FATAL) << "kSubTable disagrees for " << left << " - " << right;
+      }
+    }
+  }
+}
+
+// Runs compute over every operand pair kPasses times and prints how long each
+// one took. The sum is printed so the work cannot be optimized away.
+template<typename Compute>
+void Time(const char* name, const vector<unsigned short>& operands, Compute compute) {
+  unsigned int sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < kPasses; pass++) {
+    for (unsigned short operand : operands) {
+      AluResult result = compute(operand);
+      sum += AluValue(result) + AluFlags(result);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+  printf("%-14s %6.2f ns/op (sum %u)\n", name,
+         nanoseconds / (static_cast<double>(kPasses) * operands.size()), sum);
+}
+} // namespace
+
+int main() {
+  CheckTables();
+
+  vector<unsigned short> operands(kOperandCount);
+  unsigned int seed = 12345;
+  for (unsigned short& operand : operands) {
+    seed = seed * 1103515245 + 12345;
+    operand = seed >> 16;
+  }
+
+  Time("ADD helpers", operands, [](unsigned short operand) {
+    return AddWithHelpers(operand >> 8, operand & 0xff);
+  });
+  Time("ADD table", operands, [](unsigned short operand) {
+    return kAddTable[0][operand];
+  });
+  Time("SUB helpers", operands, [](unsigned short operand) {
+    return SubWithHelpers(operand >> 8, operand & 0xff);
+  });
+  Time("SUB table", operands, [](unsigned short operand) {
+    return kSubTable[0][operand];
+  });
+  return 0;
+}
@@ -0,0 +1,86 @@
+#include "backend/opcode_executor/decode_cache.h"
+
+namespace back_end {
+namespace handlers {
+
+namespace {
+// Writes to the MBC control registers or to the flag that unmaps the boot ROM
+// change which banks are mapped rather than the contents of memory.
+bool MayRemap(unsigned short address) {
+  return address <= 0x7fff || address == 0xff50;
+}
+
+// 0xe000 - 0xfdff echoes 0xc000 - 0xddff, so a write to either is a write to
+// both.
+bool IsEchoed(unsigned short address) {
+  return (0xc000 <= address && address <= 0xddff) || (0xe000 <= address && address <= 0xfdff);
+}
+
+unsigned short EchoOf(unsigned short address) {
+  return address < 0xe000 ? address + 0x2000 : address - 0x2000;
+}
+} // namespace
+
+void DecodeCache::Insert(unsigned short address, const DecodedInstruction& decoded) {
+  if (memory_mapper_->IsLocked(address)) {
+    return;
+  }
+  if (banks_stale_) {
+    RefreshBanks();
+  }
+  // Decoding looks at the byte after the opcode, which for the last address of
+  // a window lives in the next window and may be in a different bank.
+  if (((address + 1) & (kWindowSize - 1)) == 0) {
+    return;
+  }
+  std::unique_ptr<DecodedInstruction[]>& sub_page = SubPage(address);
+  if (sub_page == nullptr) {
+    sub_page.reset(new DecodedInstruction[kSubPageSize]);
+  }
+  sub_page[address & (kSubPageSize - 1)] = decoded;
+}
+
+void DecodeCache::OnWrite(unsigned short address) {
+  if (banks_stale_) {
+    RefreshBanks();
+  }
+  Invalidate(address);
+  if (IsEchoed(address)) {
+    Invalidate(EchoOf(address));
+  }
+  if (MayRemap(address)) {
+    banks_stale_ = true;
+  }
+}
+
+void DecodeCache::Clear() {
+  for (int window = 0; window < kWindowCount; window++) {
+    pages_[window].clear();
+  }
+  banks_stale_ = true;
+}
+
+void DecodeCache::RefreshBanks() {
+  for (int window = 0; window < kWindowCount; window++) {
+    int bank = memory_mapper_->Bank(window << kWindowBits);
+    current_pages_[window] = &pages_[window][bank];
+  }
+  banks_stale_ = false;
+}
+
+void DecodeCache::Invalidate(unsigned short address) {
+  // Decoding reads the opcode and the byte after it.
+  DecodedInstruction* entry = Find(address);
+  if (entry != nullptr) {
+    entry->opcode = nullptr;
+  }
+  if (address > 0) {
+    entry = Find(address - 1);
+    if (entry != nullptr) {
+      entry->opcode = nullptr;
+    }
+  }
+}
+
+} // namespace handlers
+} // namespace back_end
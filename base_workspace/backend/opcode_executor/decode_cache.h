@@ -0,0 +1,100 @@
+#ifndef TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_DECODE_CACHE_H_
+#define TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_DECODE_CACHE_H_
+
+#include <map>
+#include <memory>
+
+#include "backend/memory/memory_mapper.h"
+#include "backend/opcode_executor/opcodes.h"
+
+namespace back_end {
+namespace handlers {
+
+// The result of decoding the instruction at some address: everything
+// ReadInstruction works out from the opcode bytes before calling the handler.
+struct DecodedInstruction {
+  // nullptr if nothing has been decoded here.
+  const opcodes::Opcode* opcode = nullptr;
+  // The opcode as fetched, including any 0xCB or STOP prefix.
+  unsigned short opcode_name = 0;
+  // The bit index for BIT, SET and RES.
+  unsigned char magic = 0;
+  // Number of opcode bytes, not counting immediate operands.
+  unsigned char length = 0;
+};
+
+// Remembers how instructions were decoded so that code which runs more than
+// once, which is nearly all of it, does not go back through the MemoryMapper
+// and the prefix logic on every fetch.
+//
+// The address space is split into 8KB windows and each window keeps a
+// separate page of decoded instructions for every bank that has been mapped
+// there, so entries are keyed by (bank, address) and switching ROM banks back
+// and forth does not throw anything away. A page is only a table of 256 byte
+// sub-pages, each allocated the first time something in it is decoded, so the
+// cache grows with the code that has actually run rather than with the ROM.
+// Writes through the MemoryMapper drop the entries they could have changed,
+// which covers self modifying code and code copied into RAM.
+class DecodeCache : public memory::WriteListener {
+ public:
+  DecodeCache(memory::MemoryMapper* memory_mapper) : memory_mapper_(memory_mapper) {}
+
+  // Returns the decoded instruction at address for the banks that are mapped
+  // right now, or nullptr if it has to be decoded again.
+  const DecodedInstruction* Lookup(unsigned short address) {
+    // Code on a locked bus reads as 0xff, which is not worth keeping in place
+    // of what is really there.
+    if (memory_mapper_->IsLocked(address)) {
+      return nullptr;
+    }
+    if (banks_stale_) {
+      RefreshBanks();
+    }
+    const DecodedInstruction* entry = Find(address);
+    return entry == nullptr || entry->opcode == nullptr ? nullptr : entry;
+  }
+
+  void Insert(unsigned short address, const DecodedInstruction& decoded);
+
+  virtual void OnWrite(unsigned short address);
+
+  // Forgets everything decoded, for when all of memory has changed at once.
+  void Clear();
+
+ private:
+  static const int kWindowBits = 13;
+  static const int kWindowSize = 1 << kWindowBits;
+  static const int kWindowCount = 0x10000 / kWindowSize;
+  static const int kSubPageBits = 8;
+  static const int kSubPageSize = 1 << kSubPageBits;
+  static const int kSubPageCount = kWindowSize / kSubPageSize;
+
+  // The instructions decoded from one bank of one window.
+  struct Page {
+    std::unique_ptr<DecodedInstruction[]> sub_pages[kSubPageCount];
+  };
+
+  std::unique_ptr<DecodedInstruction[]>& SubPage(unsigned short address) {
+    return current_pages_[address >> kWindowBits]->sub_pages[(address & (kWindowSize - 1)) >> kSubPageBits];
+  }
+
+  // nullptr if nothing in the sub-page of address has been decoded.
+  DecodedInstruction* Find(unsigned short address) {
+    std::unique_ptr<DecodedInstruction[]>& sub_page = SubPage(address);
+    return sub_page == nullptr ? nullptr : &sub_page[address & (kSubPageSize - 1)];
+  }
+
+  void RefreshBanks();
+  void Invalidate(unsigned short address);
+
+  memory::MemoryMapper* memory_mapper_;
+  // For each window, the pages decoded so far indexed by bank.
+  std::map<int, Page> pages_[kWindowCount];
+  // For each window, the page for the bank that is currently mapped there.
+  Page* current_pages_[kWindowCount];
+  bool banks_stale_ = true;
+};
+
+} // namespace handlers
+} // namespace back_end
+#endif // TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_DECODE_CACHE_H_
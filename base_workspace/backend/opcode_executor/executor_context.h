@@ -0,0 +1,47 @@
+#ifndef TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_EXECUTOR_CONTEXT_H_
+#define TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_EXECUTOR_CONTEXT_H_
+
+#include "backend/memory/memory_mapper.h"
+#include "backend/opcode_executor/opcodes.h"
+#include "backend/opcode_executor/registers.h"
+
+namespace back_end {
+namespace handlers {
+
+struct ExecutorContext {
+  ExecutorContext(bool* interrupt_master_enable_,
+                  unsigned short* instruction_ptr_, 
+                  const opcodes::Opcode* opcode_, 
+                  memory::MemoryMapper* memory_mapper_, 
+                  registers::GB_CPU* cpu_,
+                  unsigned char magic_,
+                  unsigned short instruction_address_) :
+      interrupt_master_enable(interrupt_master_enable_),
+      instruction_ptr(instruction_ptr_),
+      opcode(opcode_),
+      memory_mapper(memory_mapper_), 
+      cpu(cpu_),
+      magic(magic_),
+      instruction_address(instruction_address_) {}
+
+  ExecutorContext(ExecutorContext* context) : 
+      interrupt_master_enable(context->interrupt_master_enable),
+      instruction_ptr(context->instruction_ptr),
+      opcode(context->opcode),
+      memory_mapper(context->memory_mapper),
+      cpu(context->cpu),
+      magic(context->magic),
+      instruction_address(context->instruction_address) {}
+
+  bool* interrupt_master_enable;
+  unsigned short* instruction_ptr;
+  const opcodes::Opcode* opcode;
+  memory::MemoryMapper* memory_mapper;
+  registers::GB_CPU* cpu;
+  unsigned char magic;
+  unsigned short instruction_address;
+};
+
+} // namespace handlers
+} // namespace back_end
+#endif // TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_EXECUTOR_CONTEXT_H_
@@ -0,0 +1,61 @@
+#include "backend/opcode_executor/jit_arena.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "submodules/glog/src/glog/logging.h"
+
+namespace back_end {
+namespace handlers {
+
+JitArena::JitArena(size_t size) : page_size_(sysconf(_SC_PAGESIZE)) {
+  size_ = (size + page_size_ - 1) / page_size_ * page_size_;
+  void* memory = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    LOG(ERROR) << "Could not map " << size_ << " bytes for the JIT: " << strerror(errno);
+    base_ = nullptr;
+  } else {
+    base_ = static_cast<unsigned char*>(memory);
+  }
+}
+
+JitArena::~JitArena() {
+  if (base_ != nullptr) {
+    munmap(base_, size_);
+  }
+}
+
+void* JitArena::Add(const unsigned char* code, size_t length) {
+  if (base_ == nullptr || length > size_ - used_) {
+    return nullptr;
+  }
+  const size_t begin = used_;
+  const size_t end = used_ + length;
+  if (!Protect(begin, end, PROT_READ | PROT_WRITE)) {
+    return nullptr;
+  }
+  memcpy(base_ + begin, code, length);
+  if (!Protect(begin, end, PROT_READ | PROT_EXEC)) {
+    return nullptr;
+  }
+  // Keep entry points 16 byte aligned.
+  used_ = (end + 15) & ~static_cast<size_t>(15);
+  if (used_ > size_) {
+    used_ = size_;
+  }
+  return base_ + begin;
+}
+
+bool JitArena::Protect(size_t begin, size_t end, int protection) {
+  size_t first_page = begin / page_size_ * page_size_;
+  if (mprotect(base_ + first_page, end - first_page, protection) != 0) {
+    LOG(ERROR) << "Could not change protection of JIT memory: " << strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+} // namespace handlers
+} // namespace back_end
@@ -0,0 +1,39 @@
+#ifndef TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_JIT_ARENA_H_
+#define TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_JIT_ARENA_H_
+
+#include <cstddef>
+
+namespace back_end {
+namespace handlers {
+
+// A fixed size region of memory that generated machine code is copied into.
+// Pages are only ever writable or executable, never both: Add makes the pages
+// it touches writable, copies the code in and makes them executable again.
+// Space is never reclaimed one block at a time; once the arena is full it has
+// to be Reset, which throws away everything in it.
+class JitArena {
+ public:
+  JitArena(size_t size);
+  ~JitArena();
+
+  // False if the memory could not be mapped, in which case Add always fails.
+  bool ok() const { return base_ != nullptr; }
+
+  // Copies length bytes of code into the arena and returns where they ended
+  // up, or nullptr if there is not enough room left.
+  void* Add(const unsigned char* code, size_t length);
+
+  void Reset() { used_ = 0; }
+
+ private:
+  bool Protect(size_t begin, size_t end, int protection);
+
+  unsigned char* base_;
+  size_t size_;
+  size_t used_ = 0;
+  size_t page_size_;
+};
+
+} // namespace handlers
+} // namespace back_end
+#endif // TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_JIT_ARENA_H_
@@ -0,0 +1,542 @@
+#include "backend/opcode_executor/jit_compiler.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "backend/opcode_executor/opcode_handlers.h"
+#include "submodules/glog/src/glog/logging.h"
+
+namespace back_end {
+namespace handlers {
+
+using std::map;
+using std::unique_ptr;
+using std::vector;
+using opcodes::OpcodeHandler;
+using registers::GB_CPU;
+using registers::Register8;
+using registers::Register16;
+using registers::rA;
+using registers::rB;
+using registers::rC;
+using registers::rD;
+using registers::rE;
+using registers::rH;
+using registers::rL;
+using registers::rBC;
+using registers::rDE;
+using registers::rHL;
+using registers::rSP;
+
+namespace {
+
+// Instructions that are translated instead of calling their handler. They are
+// recognised by handler rather than by opcode so that they always do exactly
+// what the interpreter would.
+struct NativeOp {
+  enum Kind {
+    NONE,
+    NOP,
+    LOAD_R_R,
+    LOAD_R_N,
+    LOAD_RR_NN,
+    INC_RR,
+    DEC_RR,
+  };
+
+  Kind kind;
+  int destination;
+  int source;
+};
+
+typedef map<OpcodeHandler, NativeOp> NativeOpMap;
+
+template<Register8 destination, Register8 source>
+void AddLoad(NativeOpMap* ops) {
+  (*ops)[&LoadRR8Bit<destination, source>] = {NativeOp::LOAD_R_R, destination, source};
+}
+
+template<Register8 destination>
+void AddLoadsInto(NativeOpMap* ops) {
+  AddLoad<destination, rA>(ops);
+  AddLoad<destination, rB>(ops);
+  AddLoad<destination, rC>(ops);
+  AddLoad<destination, rD>(ops);
+  AddLoad<destination, rE>(ops);
+  AddLoad<destination, rH>(ops);
+  AddLoad<destination, rL>(ops);
+  (*ops)[&LoadNA<destination>] = {NativeOp::LOAD_R_R, destination, rA};
+  (*ops)[&LoadN<destination>] = {NativeOp::LOAD_R_N, destination, 0};
+}
+
+template<Register16 reg>
+void AddWideOps(NativeOpMap* ops) {
+  (*ops)[&LoadNN<reg>] = {NativeOp::LOAD_RR_NN, reg, 0};
+  (*ops)[&Inc16Bit<reg>] = {NativeOp::INC_RR, reg, 0};
+  (*ops)[&Dec16Bit<reg>] = {NativeOp::DEC_RR, reg, 0};
+}
+
+NativeOpMap CreateNativeOpMap() {
+  NativeOpMap ops;
+  ops[&NOP] = {NativeOp::NOP, 0, 0};
+  AddLoadsInto<rA>(&ops);
+  AddLoadsInto<rB>(&ops);
+  AddLoadsInto<rC>(&ops);
+  AddLoadsInto<rD>(&ops);
+  AddLoadsInto<rE>(&ops);
+  AddLoadsInto<rH>(&ops);
+  AddLoadsInto<rL>(&ops);
+  AddWideOps<rBC>(&ops);
+  AddWideOps<rDE>(&ops);
+  AddWideOps<rHL>(&ops);
+  AddWideOps<rSP>(&ops);
+  return ops;
+}
+
+NativeOp FindNativeOp(OpcodeHandler handler) {
+  static const NativeOpMap* native_ops = new NativeOpMap(CreateNativeOpMap());
+  auto found = native_ops->find(handler);
+  if (found == native_ops->end()) {
+    return {NativeOp::NONE, 0, 0};
+  }
+  return found->second;
+}
+
+// Where each register lives relative to the start of GB_CPU.
+int Offset8(GB_CPU* cpu, int reg) {
+  unsigned char* field;
+  switch (static_cast<Register8>(reg)) {
+    case rA: field = &registers::Get8<rA>(cpu); break;
+    case rB: field = &registers::Get8<rB>(cpu); break;
+    case rC: field = &registers::Get8<rC>(cpu); break;
+    case rD: field = &registers::Get8<rD>(cpu); break;
+    case rE: field = &registers::Get8<rE>(cpu); break;
+    case rH: field = &registers::Get8<rH>(cpu); break;
+    case rL: field = &registers::Get8<rL>(cpu); break;
+    default:
+      LOG(FATAL) << "No 8-bit register " << reg;
+      return 0;
+  }
+  return field - reinterpret_cast<unsigned char*>(cpu);
+}
+
+int Offset16(GB_CPU* cpu, int reg) {
+  unsigned short* field;
+  switch (static_cast<Register16>(reg)) {
+    case registers::rAF: field = &registers::Get16<registers::rAF>(cpu); break;
+    case rBC: field = &registers::Get16<rBC>(cpu); break;
+    case rDE: field = &registers::Get16<rDE>(cpu); break;
+    case rHL: field = &registers::Get16<rHL>(cpu); break;
+    case rSP: field = &registers::Get16<rSP>(cpu); break;
+    case registers::rPC: field = &registers::Get16<registers::rPC>(cpu); break;
+    default:
+      LOG(FATAL) << "No 16-bit register " << reg;
+      return 0;
+  }
+  return reinterpret_cast<unsigned char*>(field) - reinterpret_cast<unsigned char*>(cpu);
+}
+
+// Bytes of immediate operand following a primary opcode.
+int OperandLength(unsigned short opcode) {
+  if (opcode > 0xff) {
+    return 0; // CB prefixed instructions and STOP have no operands.
+  }
+  switch (opcode) {
+    case 0x01: case 0x08: case 0x11: case 0x21: case 0x31:
+    case 0xc2: case 0xc3: case 0xc4: case 0xca: case 0xcc: case 0xcd:
+    case 0xd2: case 0xd4: case 0xda: case 0xdc:
+    case 0xea: case 0xfa:
+      return 2;
+    case 0x06: case 0x0e: case 0x16: case 0x1e: case 0x26: case 0x2e: case 0x36: case 0x3e:
+    case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+    case 0xc6: case 0xce: case 0xd6: case 0xde: case 0xe6: case 0xee: case 0xf6: case 0xfe:
+    case 0xe0: case 0xe8: case 0xf0: case 0xf8:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+// Instructions after which execution never falls through to the next one.
+bool EndsBlock(unsigned short opcode) {
+  switch (opcode) {
+    case 0x18: // JR n
+    case 0x76: // HALT
+    case 0xc3: // JP nn
+    case 0xc9: // RET
+    case 0xcd: // CALL nn
+    case 0xd9: // RETI
+    case 0xe9: // JP (HL)
+    case 0x1000: // STOP
+      return true;
+    default:
+      return opcode <= 0xff && (opcode & 0xc7) == 0xc7; // RST n
+  }
+}
+
+// Just enough of an x86-64 assembler for the code blocks are made of. While a
+// block runs rbx holds the JitCompiler and r12 the GB_CPU.
+class Emitter {
+ public:
+  const vector<unsigned char>& code() const { return code_; }
+
+  void Prologue(JitCompiler* jit, GB_CPU* cpu) {
+    Bytes({0x53});                   // push rbx
+    Bytes({0x41, 0x54});             // push r12
+    Bytes({0x48, 0x83, 0xec, 0x08}); // sub rsp, 8 (keeps calls 16 byte aligned)
+    Bytes({0x48, 0xbb});             // mov rbx, jit
+    Imm64(reinterpret_cast<uintptr_t>(jit));
+    Bytes({0x49, 0xbc});             // mov r12, cpu
+    Imm64(reinterpret_cast<uintptr_t>(cpu));
+  }
+
+  // Emits the shared exit and points every earlier jump to it.
+  void Epilogue() {
+    for (size_t fixup : exit_fixups_) {
+      int32_t displacement = code_.size() - (fixup + 4);
+      for (int i = 0; i < 4; i++) {
+        code_[fixup + i] = (displacement >> (8 * i)) & 0xff;
+      }
+    }
+    Bytes({0x48, 0x83, 0xc4, 0x08}); // add rsp, 8
+    Bytes({0x41, 0x5c});             // pop r12
+    Bytes({0x5b});                   // pop rbx
+    Bytes({0xc3});                   // ret
+  }
+
+  // movzx eax, byte [r12 + from]; mov [r12 + to], al
+  void CopyByte(int to, int from) {
+    Bytes({0x41, 0x0f, 0xb6, 0x44, 0x24});
+    Byte(from);
+    Bytes({0x41, 0x88, 0x44, 0x24});
+    Byte(to);
+  }
+
+  // mov byte [r12 + to], value
+  void StoreByte(int to, unsigned char value) {
+    Bytes({0x41, 0xc6, 0x44, 0x24});
+    Byte(to);
+    Byte(value);
+  }
+
+  // mov word [r12 + to], value
+  void StoreWord(int to, unsigned short value) {
+    Bytes({0x66, 0x41, 0xc7, 0x44, 0x24});
+    Byte(to);
+    Imm16(value);
+  }
+
+  // inc word [r12 + to]
+  void IncrementWord(int to) {
+    Bytes({0x66, 0x41, 0xff, 0x44, 0x24});
+    Byte(to);
+  }
+
+  // dec word [r12 + to]
+  void DecrementWord(int to) {
+    Bytes({0x66, 0x41, 0xff, 0x4c, 0x24});
+    Byte(to);
+  }
+
+  // function(jit, pointer)
+  void Call(const void* function, const void* pointer) {
+    Bytes({0x48, 0x89, 0xdf}); // mov rdi, rbx
+    Bytes({0x48, 0xbe});       // mov rsi, pointer
+    Imm64(reinterpret_cast<uintptr_t>(pointer));
+    CallRax(function);
+  }
+
+  // function(jit, first, second)
+  void Call(const void* function, int first, int second) {
+    Bytes({0x48, 0x89, 0xdf}); // mov rdi, rbx
+    Byte(0xbe);                // mov esi, first
+    Imm32(first);
+    Byte(0xba);                // mov edx, second
+    Imm32(second);
+    CallRax(function);
+  }
+
+  // Leaves the block if eax is -1.
+  void ExitIfMinusOne() {
+    Bytes({0x83, 0xf8, 0xff}); // cmp eax, -1
+    Bytes({0x75, 0x05});       // jne past the jmp
+    Exit();
+  }
+
+  // Leaves the block unless eax is -1.
+  void ExitUnlessMinusOne() {
+    Bytes({0x83, 0xf8, 0xff}); // cmp eax, -1
+    Bytes({0x74, 0x05});       // je past the jmp
+    Exit();
+  }
+
+  // mov eax, value
+  void SetResult(int value) {
+    Byte(0xb8);
+    Imm32(value);
+  }
+
+  // jmp to the epilogue
+  void Exit() {
+    Byte(0xe9);
+    exit_fixups_.push_back(code_.size());
+    Imm32(0);
+  }
+
+ private:
+  void CallRax(const void* function) {
+    Bytes({0x48, 0xb8}); // mov rax, function
+    Imm64(reinterpret_cast<uintptr_t>(function));
+    Bytes({0xff, 0xd0}); // call rax
+  }
+
+  void Byte(unsigned char value) { code_.push_back(value); }
+
+  void Bytes(std::initializer_list<unsigned char> values) {
+    code_.insert(code_.end(), values.begin(), values.end());
+  }
+
+  void Imm16(uint16_t value) {
+    for (int i = 0; i < 2; i++) {
+      Byte((value >> (8 * i)) & 0xff);
+    }
+  }
+
+  void Imm32(uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+      Byte((value >> (8 * i)) & 0xff);
+    }
+  }
+
+  void Imm64(uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+      Byte((value >> (8 * i)) & 0xff);
+    }
+  }
+
+  vector<unsigned char> code_;
+  vector<size_t> exit_fixups_;
+};
+
+// 0xe000 - 0xfdff echoes 0xc000 - 0xddff.
+bool IsEchoed(unsigned short address) {
+  return (0xc000 <= address && address <= 0xddff) || (0xe000 <= address && address <= 0xfdff);
+}
+
+unsigned short EchoOf(unsigned short address) {
+  return address < 0xe000 ? address + 0x2000 : address - 0x2000;
+}
+} // namespace
+
+JitCompiler::JitCompiler(JitHost* host, memory::MemoryMapper* memory_mapper, GB_CPU* cpu) :
+    host_(host), memory_mapper_(memory_mapper), cpu_(cpu), arena_(kArenaSize) {}
+
+int JitCompiler::Run(unsigned short address) {
+  // As for the DecodeCache, nothing is compiled from or run on a locked bus.
+  if (memory_mapper_->IsLocked(address)) {
+    return kNotCompiled;
+  }
+  if (banks_stale_) {
+    RefreshBanks();
+  }
+  const int offset = address & (kWindowSize - 1);
+  SubPage* sub_page = current_pages_[address >> kWindowBits]->Find(offset);
+  Block* block = sub_page == nullptr ? nullptr : sub_page->block(offset);
+  if (block == nullptr) {
+    block = Compile(address);
+    if (block == nullptr) {
+      return kNotCompiled;
+    }
+  }
+  exit_requested_ = false;
+  return block->entry();
+}
+
+void JitCompiler::OnWrite(unsigned short address) {
+  if (banks_stale_) {
+    RefreshBanks();
+  }
+  Invalidate(address);
+  if (IsEchoed(address)) {
+    Invalidate(EchoOf(address));
+  }
+  if (address <= 0x7fff || address == 0xff50) {
+    // MBC control registers and the boot ROM flag change what is mapped.
+    banks_stale_ = true;
+    exit_requested_ = true;
+  } else if (address == 0xff46) {
+    // A DMA transfer locks the bus, which the rest of the block may be on.
+    exit_requested_ = true;
+  }
+}
+
+int JitCompiler::ExecuteTrampoline(JitCompiler* jit, const JitInstruction* instruction) {
+  return jit->host_->ExecuteDecoded(instruction->decoded, instruction->address);
+}
+
+int JitCompiler::FinishTrampoline(JitCompiler* jit, int cycles, int next_address) {
+  if (jit->exit_requested_) {
+    return cycles;
+  }
+  return jit->host_->FinishInstruction(cycles, next_address);
+}
+
+JitCompiler::Block* JitCompiler::Compile(unsigned short address) {
+  const int window_end = ((address >> kWindowBits) + 1) << kWindowBits;
+  unique_ptr<Block> block(new Block());
+  int next_address = address;
+  while (block->instructions.size() < kMaxBlockInstructions &&
+         next_address + kMaxInstructionBytes <= window_end) {
+    DecodedInstruction decoded = host_->Decode(next_address);
+    if (decoded.opcode == nullptr) {
+      break; // Leave it to the interpreter to report.
+    }
+    block->instructions.push_back({decoded, static_cast<unsigned short>(next_address)});
+    next_address += decoded.length + OperandLength(decoded.opcode_name);
+    if (EndsBlock(decoded.opcode_name)) {
+      break;
+    }
+  }
+  if (block->instructions.empty()) {
+    return nullptr;
+  }
+  block->begin = address & (kWindowSize - 1);
+  // Decoding peeks at the byte after an instruction.
+  block->end = block->begin + (next_address - address) + 1;
+
+  Emitter emitter;
+  emitter.Prologue(this, cpu_);
+  for (size_t i = 0; i < block->instructions.size(); i++) {
+    const JitInstruction& instruction = block->instructions[i];
+    const int cycles = instruction.decoded.opcode->clock_cycles;
+    const int operand_address = instruction.address + instruction.decoded.length;
+    const int fall_through = operand_address + OperandLength(instruction.decoded.opcode_name);
+    NativeOp op = FindNativeOp(instruction.decoded.opcode->handler);
+    // Immediates in I/O space are not safe to read ahead of time.
+    if (op.kind == NativeOp::LOAD_R_N || op.kind == NativeOp::LOAD_RR_NN) {
+      if (fall_through > 0xff00) {
+        op.kind = NativeOp::NONE;
+      }
+    }
+
+    switch (op.kind) {
+      case NativeOp::NONE:
+        emitter.Call(reinterpret_cast<const void*>(&JitCompiler::ExecuteTrampoline), &instruction);
+        emitter.ExitIfMinusOne();
+        break;
+      case NativeOp::NOP:
+        break;
+      case NativeOp::LOAD_R_R:
+        emitter.CopyByte(Offset8(cpu_, op.destination), Offset8(cpu_, op.source));
+        break;
+      case NativeOp::LOAD_R_N:
+        emitter.StoreByte(Offset8(cpu_, op.destination), memory_mapper_->Read(operand_address));
+        break;
+      case NativeOp::LOAD_RR_NN:
+        emitter.StoreWord(Offset16(cpu_, op.destination),
+                          memory_mapper_->Read(operand_address + 1) << 8 | memory_mapper_->Read(operand_address));
+        break;
+      case NativeOp::INC_RR:
+        emitter.IncrementWord(Offset16(cpu_, op.destination));
+        break;
+      case NativeOp::DEC_RR:
+        emitter.DecrementWord(Offset16(cpu_, op.destination));
+        break;
+    }
+    if (op.kind != NativeOp::NONE) {
+      emitter.StoreWord(Offset16(cpu_, registers::rPC), fall_through);
+    }
+
+    if (i + 1 == block->instructions.size()) {
+      emitter.SetResult(cycles);
+    } else {
+      emitter.Call(reinterpret_cast<const void*>(&JitCompiler::FinishTrampoline), cycles, fall_through);
+      emitter.ExitUnlessMinusOne();
+    }
+  }
+  emitter.Epilogue();
+
+  void* entry = arena_.Add(emitter.code().data(), emitter.code().size());
+  if (entry == nullptr) {
+    // Out of room; start again from an empty arena.
+    Flush();
+    entry = arena_.Add(emitter.code().data(), emitter.code().size());
+    if (entry == nullptr) {
+      return nullptr;
+    }
+  }
+  block->entry = reinterpret_cast<BlockEntry>(entry);
+
+  Block* compiled = block.get();
+  AddBlock(current_pages_[address >> kWindowBits], std::move(block));
+  return compiled;
+}
+
+JitCompiler::SubPage* JitCompiler::Page::Get(int offset) {
+  std::unique_ptr<SubPage>& sub_page = sub_pages[offset >> kSubPageBits];
+  if (sub_page == nullptr) {
+    sub_page.reset(new SubPage());
+  }
+  return sub_page.get();
+}
+
+void JitCompiler::AddBlock(Page* page, unique_ptr<Block> block) {
+  for (int chunk = block->begin >> kChunkBits; chunk <= (block->end - 1) >> kChunkBits; chunk++) {
+    page->Get(chunk << kChunkBits)->chunk_count(chunk << kChunkBits)++;
+  }
+  page->Get(block->begin)->block(block->begin) = block.get();
+  all_blocks_.push_back(std::move(block));
+}
+
+void JitCompiler::RemoveBlock(Page* page, int offset) {
+  Block* block = page->Find(offset)->block(offset);
+  for (int chunk = block->begin >> kChunkBits; chunk <= (block->end - 1) >> kChunkBits; chunk++) {
+    page->Find(chunk << kChunkBits)->chunk_count(chunk << kChunkBits)--;
+  }
+  // The block itself stays in all_blocks_, and its code in the arena, until
+  // the next Flush since it may be the one running right now.
+  page->Find(offset)->block(offset) = nullptr;
+}
+
+void JitCompiler::Invalidate(unsigned short address) {
+  Page* page = current_pages_[address >> kWindowBits];
+  const int offset = address & (kWindowSize - 1);
+  SubPage* sub_page = page->Find(offset);
+  if (sub_page == nullptr || sub_page->chunk_count(offset) == 0) {
+    return;
+  }
+  for (int start = std::max(0, offset - kMaxBlockBytes); start <= offset; start++) {
+    SubPage* start_sub_page = page->Find(start);
+    Block* block = start_sub_page == nullptr ? nullptr : start_sub_page->block(start);
+    if (block != nullptr && block->begin <= offset && offset < block->end) {
+      RemoveBlock(page, start);
+      exit_requested_ = true;
+    }
+  }
+}
+
+void JitCompiler::Flush() {
+  LOG(INFO) << "JIT arena is full, discarding " << all_blocks_.size() << " blocks.";
+  Clear();
+  // The block being compiled goes straight into the current page.
+  RefreshBanks();
+}
+
+void JitCompiler::Clear() {
+  for (int window = 0; window < kWindowCount; window++) {
+    pages_[window].clear();
+  }
+  all_blocks_.clear();
+  arena_.Reset();
+  banks_stale_ = true;
+}
+
+void JitCompiler::RefreshBanks() {
+  for (int window = 0; window < kWindowCount; window++) {
+    current_pages_[window] = &pages_[window][memory_mapper_->Bank(window << kWindowBits)];
+  }
+  banks_stale_ = false;
+}
+
+} // namespace handlers
+} // namespace back_end
@@ -0,0 +1,151 @@
+#ifndef TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_JIT_COMPILER_H_
+#define TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_JIT_COMPILER_H_
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "backend/memory/memory_mapper.h"
+#include "backend/opcode_executor/decode_cache.h"
+#include "backend/opcode_executor/jit_arena.h"
+#include "backend/opcode_executor/registers.h"
+
+namespace back_end {
+namespace handlers {
+
+// The parts of the executor that compiled code calls back into.
+class JitHost {
+ public:
+  // Returns the decoded instruction at address; the opcode is null if the
+  // instruction does not exist.
+  virtual DecodedInstruction Decode(unsigned short address) = 0;
+
+  // Runs one instruction with its interpreter handler, leaving PC wherever the
+  // handler put it. Returns -1 if the handler failed and 0 otherwise.
+  virtual int ExecuteDecoded(const DecodedInstruction& decoded, unsigned short address) = 0;
+
+  // Called after each instruction in a block except the last, with the cycles
+  // it took and the address of the next instruction in the block. Returns -1
+  // to run the next instruction; anything else ends the block and is returned
+  // from ReadInstruction as the cycles nobody has been told about yet.
+  virtual int FinishInstruction(int cycles, unsigned short next_address) = 0;
+};
+
+// Translates straight line runs of LR35902 code into x86-64.
+//
+// A block starts wherever PC happens to be and runs until an unconditional
+// jump, call, return or restart, an opcode that does not exist, the end of an
+// 8KB window or kMaxBlockInstructions, whichever comes first. Register to
+// register loads, immediate loads and 16-bit increments are translated
+// directly; every other instruction becomes a call to its interpreter handler,
+// which keeps the two modes in agreement. After each instruction the block
+// asks the JitHost whether to carry on, which is where cycles are reported,
+// branches are noticed and interrupts get a chance to run.
+//
+// Blocks are keyed by (bank, address) the same way as the DecodeCache, with
+// each page split the same way into 256 byte sub-pages that are only allocated
+// once a block covers them, and a write through the MemoryMapper to any byte a
+// block was compiled from throws the block away.
+class JitCompiler : public memory::WriteListener {
+ public:
+  // Returned by Run if there is no block for the address and one could not be
+  // compiled, so the instruction must be interpreted.
+  static const int kNotCompiled = -2;
+
+  JitCompiler(JitHost* host, memory::MemoryMapper* memory_mapper, registers::GB_CPU* cpu);
+
+  // False if compiled code cannot be run at all on this machine.
+  bool ok() const { return arena_.ok(); }
+
+  // Runs the block starting at address, compiling it first if need be.
+  // Returns what the block returned, or kNotCompiled.
+  int Run(unsigned short address);
+
+  virtual void OnWrite(unsigned short address);
+
+  // Throws every block away, for when all of memory has changed at once.
+  void Clear();
+
+ private:
+  static const int kMaxBlockInstructions = 32;
+  // Longest an instruction, its operands and the byte decoding peeks at can
+  // be.
+  static const int kMaxInstructionBytes = 4;
+  static const int kMaxBlockBytes = kMaxBlockInstructions * kMaxInstructionBytes;
+  static const size_t kArenaSize = 4 * 1024 * 1024;
+
+  static const int kWindowBits = 13;
+  static const int kWindowSize = 1 << kWindowBits;
+  static const int kWindowCount = 0x10000 / kWindowSize;
+  static const int kSubPageBits = 8;
+  static const int kSubPageSize = 1 << kSubPageBits;
+  static const int kSubPageCount = kWindowSize / kSubPageSize;
+  static const int kChunkBits = 6;
+  static const int kSubPageChunks = kSubPageSize >> kChunkBits;
+
+  typedef int (*BlockEntry)();
+
+  struct JitInstruction {
+    DecodedInstruction decoded;
+    unsigned short address;
+  };
+
+  struct Block {
+    BlockEntry entry = nullptr;
+    // Every byte the block was compiled from is in [begin, end), relative to
+    // the start of the window.
+    int begin = 0;
+    int end = 0;
+    // Instructions left to their handlers; compiled code points into this, so
+    // it is never resized once the code has been generated.
+    std::vector<JitInstruction> instructions;
+  };
+
+  // The blocks starting in 256 bytes of a window. Offsets are from the start
+  // of the window.
+  struct SubPage {
+    Block* blocks[kSubPageSize] = {};
+    // How many blocks cover each 64 byte chunk, so that writes to data can
+    // skip looking for blocks to invalidate.
+    int chunk_blocks[kSubPageChunks] = {};
+
+    Block*& block(int offset) { return blocks[offset & (kSubPageSize - 1)]; }
+    int& chunk_count(int offset) { return chunk_blocks[(offset & (kSubPageSize - 1)) >> kChunkBits]; }
+  };
+
+  // The blocks compiled from one bank of one window.
+  struct Page {
+    std::unique_ptr<SubPage> sub_pages[kSubPageCount];
+
+    // nullptr if no block covers anything in the sub-page of offset.
+    SubPage* Find(int offset) { return sub_pages[offset >> kSubPageBits].get(); }
+    // Allocates the sub-page of offset the first time it is asked for.
+    SubPage* Get(int offset);
+  };
+
+  static int ExecuteTrampoline(JitCompiler* jit, const JitInstruction* instruction);
+  static int FinishTrampoline(JitCompiler* jit, int cycles, int next_address);
+
+  Block* Compile(unsigned short address);
+  void AddBlock(Page* page, std::unique_ptr<Block> block);
+  void RemoveBlock(Page* page, int offset);
+  void Invalidate(unsigned short address);
+  void Flush();
+  void RefreshBanks();
+
+  JitHost* host_;
+  memory::MemoryMapper* memory_mapper_;
+  registers::GB_CPU* cpu_;
+  JitArena arena_;
+  std::vector<std::unique_ptr<Block>> all_blocks_;
+  std::map<int, Page> pages_[kWindowCount];
+  Page* current_pages_[kWindowCount];
+  bool banks_stale_ = true;
+  // Set by OnWrite when running code may have been changed or remapped, so the
+  // block that made the write stops after the current instruction.
+  bool exit_requested_ = false;
+};
+
+} // namespace handlers
+} // namespace back_end
+#endif // TURBO_SANTA_COMMON_BACK_END_OPCODE_EXECUTOR_JIT_COMPILER_H_
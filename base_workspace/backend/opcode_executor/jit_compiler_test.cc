@@ -0,0 +1,444 @@
+#include "backend/opcode_executor/jit_compiler.h"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "backend/memory/memory_mapper.h"
+#include "backend/memory/module.h"
+#include "backend/memory/primary_flags.h"
+#include "backend/memory/ram_segment.h"
+#include "backend/memory/save_state.h"
+#include "backend/opcode_executor/opcode_executor.h"
+#include "submodules/googletest/include/gtest/gtest.h"
+#include "submodules/glog/src/glog/logging.h"
+
+namespace back_end {
+namespace handlers {
+
+using std::unique_ptr;
+using std::vector;
+using memory::StateReader;
+using memory::StateWriter;
+
+namespace {
+
+const unsigned short kCodeStart = 0x0100;
+const unsigned short kDataStart = 0xc000;
+const int kDataSize = 0x200;
+const unsigned short kStackStart = 0xdff0;
+
+// RAM everywhere but the IO ports, so that code can be put anywhere and can
+// write over itself.
+class RAMModule : public memory::Module {
+ public:
+  RAMModule() {
+    add_memory_segment(&low_);
+    add_memory_segment(&high_);
+  }
+
+  void Load(unsigned short address, const vector<unsigned char>& values) {
+    for (unsigned char value : values) {
+      low_.Write(address++, value);
+    }
+  }
+
+ private:
+  memory::RAMSegment low_{0x0000, 0xfeff};
+  memory::RAMSegment high_{0xff80, 0xfffe};
+};
+
+// Counts what a block reports between its instructions.
+class CycleCounter : public CycleListener {
+ public:
+  virtual void OnCycles(int cycles) {
+    instructions_++;
+    cycles_ += cycles;
+  }
+
+  long instructions() const { return instructions_; }
+  long cycles() const { return cycles_; }
+
+ private:
+  long instructions_ = 0;
+  long cycles_ = 0;
+};
+
+// An OpcodeExecutor on a RAMModule holding program at kCodeStart and data at
+// kDataStart, about to run program with every other register 0 and interrupts
+// off.
+class TestMachine {
+ public:
+  TestMachine(const vector<unsigned char>& program, const vector<unsigned char>& data) {
+    primary_flags_.Init();
+    ram_.Load(kCodeStart, program);
+    ram_.Load(kDataStart, data);
+    unique_ptr<memory::MemoryMapper> memory_mapper(new memory::MemoryMapper());
+    memory_mapper->RegisterModule(primary_flags_);
+    memory_mapper->RegisterModule(ram_);
+    executor_ = unique_ptr<OpcodeExecutor>(new OpcodeExecutor(std::move(memory_mapper), &primary_flags_));
+
+    // A state starts with AF, A, BC, DE, HL, SP, PC and IME.
+    vector<unsigned char> state = State();
+    StateWriter registers(state.data(), state.size());
+    registers.Write16(0);
+    registers.Write8(0);
+    for (int i = 0; i < 4; i++) {
+      registers.Write16(0);
+    }
+    registers.Write16(kCodeStart);
+    registers.WriteBool(false);
+    StateReader reader(state.data(), state.size());
+    executor_->LoadState(&reader);
+  }
+
+  OpcodeExecutor* executor() { return executor_.get(); }
+
+  // The registers, every flag, IME and all of memory.
+  vector<unsigned char> State() {
+    StateWriter counter;
+    executor_->SaveState(&counter);
+    vector<unsigned char> state(counter.size());
+    StateWriter writer(state.data(), state.size());
+    executor_->SaveState(&writer);
+    return state;
+  }
+
+ private:
+  memory::PrimaryFlags primary_flags_;
+  RAMModule ram_;
+  unique_ptr<OpcodeExecutor> executor_;
+};
+
+// Writes random programs that keep to the registers and memory set aside for
+// them, never reach an opcode that does not exist, and finish in a loop at
+// end(). As well as the usual arithmetic, loads and stores, they branch, loop,
+// call, and write over their own operands and opcodes, both a few
+// instructions ahead and inside loops that have already been round.
+class ProgramWriter {
+ public:
+  explicit ProgramWriter(unsigned int seed) : random_(seed) {}
+
+  vector<unsigned char> Write(int pieces) {
+    // JR over the subroutine that CALLs go to.
+    Emit(0x18);
+    size_t over = code_.size();
+    Emit(0);
+    subroutine_ = Address();
+    int subroutine_pieces = 1 + Random(3);
+    for (int i = 0; i < subroutine_pieces; i++) {
+      Straight(false);
+    }
+    Emit(0xc9); // RET
+    code_[over] = code_.size() - over - 1;
+
+    Emit(0x31); // LD SP,nn
+    EmitWord(kStackStart);
+    Emit(0x21); // LD HL,nn
+    EmitWord(kDataStart + Random(0x100));
+    Emit(0x01); // LD BC,nn
+    EmitWord(Random(0x10000));
+    Emit(0x11); // LD DE,nn
+    EmitWord(Random(0x10000));
+    Emit(0xc5); // PUSH BC
+    Emit(0xf1); // POP AF
+
+    for (int i = 0; i < pieces; i++) {
+      switch (Random(8)) {
+        case 0: SkipAhead(3); break;
+        case 1: Loop(); break;
+        case 2:
+          Emit(0xcd); // CALL nn
+          EmitWord(subroutine_);
+          break;
+        default: Straight(true); break;
+      }
+    }
+
+    end_ = Address();
+    Emit(0x18); // JR end
+    Emit(0xfe);
+    return code_;
+  }
+
+  unsigned short end() const { return end_; }
+
+  vector<unsigned char> Data() {
+    vector<unsigned char> data(kDataSize);
+    for (unsigned char& value : data) {
+      value = Random(0x100);
+    }
+    return data;
+  }
+
+ private:
+  int Random(int limit) { return random_() % limit; }
+
+  unsigned short Address() const { return kCodeStart + code_.size(); }
+
+  void Emit(int value) { code_.push_back(value); }
+
+  void EmitWord(int value) {
+    Emit(value & 0xff);
+    Emit(value >> 8);
+  }
+
+  // B, C unless it is counting a loop, D, E or A, numbered as in the opcodes.
+  int Destination() {
+    static const int kFree[] = {0, 1, 2, 3, 7};
+    for (;;) {
+      int target = kFree[Random(5)];
+      if (target != 1 || !in_loop_) {
+        return target;
+      }
+    }
+  }
+
+  // Any register, H and L included.
+  int Source() {
+    static const int kAny[] = {0, 1, 2, 3, 4, 5, 7};
+    return kAny[Random(7)];
+  }
+
+  // A few instructions that run straight through. Patches write over the
+  // code that comes after them.
+  void Straight(bool patches) {
+    static const unsigned char kAccumulatorOps[] = {0x07, 0x0f, 0x17, 0x1f, 0x27, 0x2f, 0x37, 0x3f};
+    switch (Random(patches ? 13 : 11)) {
+      case 0: // LD r,n
+        Emit(0x06 + Destination() * 8);
+        Emit(Random(0x100));
+        break;
+      case 1: // LD r,r'
+        Emit(0x40 + Destination() * 8 + Source());
+        break;
+      case 2: // ADD, ADC, SUB, SBC, AND, XOR, OR or CP with a register.
+        Emit(0x80 + Random(8) * 8 + Source());
+        break;
+      case 3: // The same with an immediate.
+        Emit(0xc6 + Random(8) * 8);
+        Emit(Random(0x100));
+        break;
+      case 4: // INC r or DEC r
+        Emit(0x04 + Destination() * 8 + Random(2));
+        break;
+      case 5: // INC or DEC BC or DE.
+        Emit((in_loop_ || Random(2) == 0 ? 0x13 : 0x03) + Random(2) * 8);
+        break;
+      case 6: // Rotates, shifts, SWAP, BIT, RES and SET.
+        Emit(0xcb);
+        Emit((Random(0x100) & 0xf8) | Destination());
+        break;
+      case 7:
+        switch (Random(4)) {
+          case 0: Emit(0x22); break; // LD (HL+),A
+          case 1: Emit(0x2a); break; // LD A,(HL+)
+          case 2: Emit(0x70 + Source()); break; // LD (HL),r
+          default: Emit(0x46 + Destination() * 8); break; // LD r,(HL)
+        }
+        break;
+      case 8:
+        Emit(kAccumulatorOps[Random(8)]);
+        break;
+      case 9: {
+        static const unsigned char kPush[] = {0xc5, 0xd5, 0xf5};
+        static const unsigned char kPop[] = {0xd1, 0xf1, 0xc1};
+        Emit(kPush[Random(3)]);
+        Emit(kPop[Random(in_loop_ ? 2 : 3)]);
+        break;
+      }
+      case 10: // ADD HL,rr and then back into the data.
+        Emit(0x09 + Random(4) * 0x10);
+        Emit(0x21);
+        EmitWord(kDataStart + Random(0x100));
+        break;
+      case 11: PatchOperand(); break;
+      default: PatchOpcode(); break;
+    }
+  }
+
+  // Writes a new immediate into an LD B,n a few instructions on.
+  void PatchOperand() {
+    Emit(0x3e); // LD A,n
+    Emit(Random(0x100));
+    Emit(0xea); // LD (nn),A
+    size_t target = code_.size();
+    EmitWord(0);
+    int between = Random(4);
+    for (int i = 0; i < between; i++) {
+      Straight(false);
+    }
+    unsigned short operand = Address() + 1;
+    code_[target] = operand & 0xff;
+    code_[target + 1] = operand >> 8;
+    Emit(0x06); // LD B,n
+    Emit(Random(0x100));
+  }
+
+  // Swaps an instruction a few on for another one byte instruction.
+  void PatchOpcode() {
+    static const unsigned char kSwappable[] = {0x00, 0x04, 0x05, 0x14, 0x15, 0x1c, 0x1d, 0x3c, 0x3d, 0x2f, 0x37, 0x3f};
+    const int kSwappableCount = sizeof(kSwappable);
+    Emit(0x3e); // LD A,n
+    Emit(kSwappable[Random(kSwappableCount)]);
+    Emit(0xea); // LD (nn),A
+    size_t target = code_.size();
+    EmitWord(0);
+    int between = Random(4);
+    for (int i = 0; i < between; i++) {
+      Straight(false);
+    }
+    code_[target] = Address() & 0xff;
+    code_[target + 1] = Address() >> 8;
+    Emit(kSwappable[Random(kSwappableCount)]);
+  }
+
+  // JR NZ, Z, NC or C over up to most pieces.
+  void SkipAhead(int most) {
+    Emit(0x20 + Random(4) * 8);
+    size_t offset = code_.size();
+    Emit(0);
+    int skipped = 1 + Random(most);
+    for (int i = 0; i < skipped; i++) {
+      Straight(true);
+    }
+    code_[offset] = code_.size() - offset - 1;
+  }
+
+  // Goes round a few pieces up to 8 times, counting in C. Half of the loops
+  // also count in the operand of an LD B,n at the top, which is written over
+  // every time round, after it has been run.
+  void Loop() {
+    Emit(0x0e); // LD C,n
+    Emit(1 + Random(8));
+    size_t top = code_.size();
+    in_loop_ = true;
+    bool count_in_code = Random(2) == 0;
+    unsigned short counter = Address() + 1;
+    if (count_in_code) {
+      Emit(0x06); // LD B,n
+      Emit(Random(0x100));
+    }
+    int pieces = 1 + Random(3);
+    for (int i = 0; i < pieces; i++) {
+      if (Random(4) == 0) {
+        SkipAhead(1);
+      } else {
+        Straight(true);
+      }
+    }
+    if (count_in_code) {
+      Emit(0xfa); // LD A,(nn)
+      EmitWord(counter);
+      Emit(0x3c); // INC A
+      Emit(0xea); // LD (nn),A
+      EmitWord(counter);
+    }
+    in_loop_ = false;
+    Emit(0x0d); // DEC C
+    Emit(0x20); // JR NZ,top
+    int offset = static_cast<int>(top) - static_cast<int>(code_.size() + 1);
+    CHECK_GE(offset, -128);
+    Emit(offset & 0xff);
+  }
+
+  std::mt19937 random_;
+  vector<unsigned char> code_;
+  unsigned short subroutine_ = 0;
+  unsigned short end_ = 0;
+  bool in_loop_ = false;
+};
+
+// Runs program with the JIT, in blocks as long as it will compile them, until
+// it reaches end. Then runs the same number of instructions in the
+// interpreter, and expects the two to have taken the same cycles and to have
+// left every register, flag and byte of memory the same.
+void ExpectJITMatchesInterpreter(const vector<unsigned char>& program,
+                                 const vector<unsigned char>& data,
+                                 unsigned short end) {
+  const long kMaxInstructions = 1000000;
+  TestMachine jit(program, data);
+  CycleCounter cycle_counter;
+  jit.executor()->set_execution_mode(JIT);
+  jit.executor()->set_cycle_listener(&cycle_counter);
+  long blocks = 0;
+  long unreported_instructions = 0;
+  long unreported_cycles = 0;
+  while (jit.executor()->pc() != end) {
+    ASSERT_LT(cycle_counter.instructions() + unreported_instructions, kMaxInstructions) << "Never got to the end.";
+    int cycles = jit.executor()->ReadInstruction();
+    ASSERT_GE(cycles, 0);
+    blocks++;
+    // 0 if every instruction was reported, which only happens when an
+    // interrupt is due.
+    if (cycles > 0) {
+      unreported_instructions++;
+      unreported_cycles += cycles;
+    }
+  }
+  long instructions = cycle_counter.instructions() + unreported_instructions;
+
+  TestMachine interpreter(program, data);
+  long cycles = 0;
+  for (long i = 0; i < instructions; i++) {
+    int instruction_cycles = interpreter.executor()->ReadInstruction();
+    ASSERT_GT(instruction_cycles, 0);
+    cycles += instruction_cycles;
+  }
+  EXPECT_EQ(cycles, cycle_counter.cycles() + unreported_cycles);
+
+  vector<unsigned char> expected = interpreter.State();
+  vector<unsigned char> actual = jit.State();
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(static_cast<int>(expected[i]), static_cast<int>(actual[i])) << "at byte " << i << " of the state";
+  }
+#if defined(__x86_64__)
+  // Otherwise every block ran a single instruction, and nothing was checked
+  // that opcode_handlers_jit_test does not check already.
+  EXPECT_LT(blocks, instructions);
+#endif
+}
+
+} // namespace
+
+TEST(JitCompilerTest, LoopWritingOverItsOwnOperand) {
+  vector<unsigned char> program = {
+    0xaf,             // 0100 XOR A
+    0x0e, 0x04,       // 0101 LD C,4
+    0xc6, 0x01,       // 0103 ADD A,1
+    0x47,             // 0105 LD B,A
+    0xfa, 0x04, 0x01, // 0106 LD A,(0104)
+    0x3c,             // 0109 INC A
+    0xea, 0x04, 0x01, // 010a LD (0104),A
+    0x78,             // 010d LD A,B
+    0x0d,             // 010e DEC C
+    0x20, 0xf2,       // 010f JR NZ,0103
+    0x18, 0xfe,       // 0111 JR 0111
+  };
+  ExpectJITMatchesInterpreter(program, {}, 0x0111);
+
+  TestMachine jit(program, {});
+  jit.executor()->set_execution_mode(JIT);
+  CycleCounter cycle_counter;
+  jit.executor()->set_cycle_listener(&cycle_counter);
+  while (jit.executor()->pc() != 0x0111) {
+    ASSERT_GE(jit.executor()->ReadInstruction(), 0);
+  }
+  // A comes straight after AF.
+  EXPECT_EQ(1 + 2 + 3 + 4, jit.State()[2]);
+}
+
+TEST(JitCompilerTest, RandomProgramsMatchInterpreter) {
+  const int kPrograms = 50;
+  const int kPieces = 150;
+  for (int seed = 0; seed < kPrograms; seed++) {
+    SCOPED_TRACE("seed " + std::to_string(seed));
+    ProgramWriter writer(seed);
+    vector<unsigned char> program = writer.Write(kPieces);
+    ExpectJITMatchesInterpreter(program, writer.Data(), writer.end());
+  }
+}
+
+} // namespace handlers
+} // namespace back_end
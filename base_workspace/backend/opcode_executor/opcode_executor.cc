@@ -1,5 +1,6 @@
 #include "backend/opcode_executor/opcode_executor.h"
 
+#include "backend/opcode_executor/opcode_handlers.h"
 #include "submodules/glog/src/glog/logging.h"
 
 namespace back_end {
@@ -10,65 +11,169 @@ using opcodes::Opcode;
 int OpcodeExecutor::ReadInstruction() {
   HandleInterrupts(); // Before a fetch we must check for and handle interrupts.
   unsigned short opcode_address = cpu_.rPC;
-  unsigned short instruction_ptr = cpu_.rPC;
-  unsigned short opcode = memory_mapper_->Read(instruction_ptr);
-  instruction_ptr++;
-  unsigned short next_byte = memory_mapper_->Read(instruction_ptr);
-
-  // This is jank.
-  unsigned char magic = 0;
-  if (opcode == 0xCB && (next_byte & 0b11000000) > 0) {
-    instruction_ptr++;
-    magic = (0b00111000 & next_byte) >> 3;
-    opcode = (opcode << 8) | (next_byte & 0b11000111);
-  } else if (opcode == 0xCB) {
-    instruction_ptr++;
-    opcode = (opcode << 8) | next_byte;
-  } else if (next_byte == 0x10 && opcode == 0x00) {
-    instruction_ptr++;
-    opcode = next_byte << 8 | opcode;
+  if (use_jit_) {
+    int result = jit_->Run(opcode_address);
+    if (result != JitCompiler::kNotCompiled) {
+      return result;
+    }
   }
-  cpu_.rPC = instruction_ptr;
-
-  Opcode opcode_struct;
-  auto opcode_iter = opcode_map_.find(opcode);
-  if (opcode_iter == opcode_map_.end()) {
-    LOG(ERROR) << "Opcode instruction, " << std::hex << opcode << ", does not exist. Next value is " << std::hex << next_byte;
-    return -1; // Let the clocktroller know that we cannot continue.
-  } else {
-    LOG(INFO) << "Fetched opcode: " << std::hex << opcode << " address: " << std::hex << opcode_address;
-    LOG(INFO) << "A is " << std::hex << std::hex << 0x0000 + cpu_.flag_struct.rA;
-    LOG(INFO) << "C is " << std::hex << std::hex << 0x0000 + cpu_.bc_struct.rC;
-    LOG(INFO) << "HL is " << std::hex << std::hex << 0x0000 + cpu_.rHL;
-    opcode_struct = opcode_iter->second;
+#ifdef THREADED_INTERPRETER
+  return RunThreaded();
+#else
+  const DecodedInstruction* decoded = decode_cache_.Lookup(opcode_address);
+  DecodedInstruction decoded_now;
+  if (decoded == nullptr) {
+    decoded_now = DecodeInstruction(opcode_address);
+    if (decoded_now.opcode == nullptr) {
+      cpu_.rPC = opcode_address + decoded_now.length;
+      return -1; // Let the clocktroller know that we cannot continue.
+    }
+    decode_cache_.Insert(opcode_address, decoded_now);
+    decoded = &decoded_now;
   }
+  // The handler may write over the cache entry.
+  const Opcode* table_entry = decoded->opcode;
 
-  ExecutorContext context(&interrupt_master_enable_,
-                          &cpu_.rPC,
-                          &opcode_struct,
-                          memory_mapper_.get(),
-                          &cpu_,
-                          magic,
-                          opcode_address);
-  
   // XXX(Brendan): A hack to poke tetris.
-  // if (opcode_address == 0x034c && opcode_struct.opcode_name == 0xf0) {
+  // if (opcode_address == 0x034c && table_entry->opcode_name == 0xf0) {
   //   LOG(INFO) << "TETRIS HACK!!!!";
   //   memory_mapper_.Write(0xff80, 0x00);
   // }
-  // if (opcode_address == 0x36c && opcode_struct.opcode_name == 0xf0) {
+  // if (opcode_address == 0x36c && table_entry->opcode_name == 0xf0) {
   //   LOG(INFO) << "TETRIS HACK!!!!";
   //   memory_mapper_.Write(0xff85, 0xff);
   // }
   
-  int handler_result = opcode_struct.handler(&context);
+  if (ExecuteDecoded(*decoded, opcode_address) == -1) {
+    return -1;
+  }
+  return table_entry->clock_cycles;
+#endif
+}
+
+void OpcodeExecutor::set_execution_mode(ExecutionMode mode) {
+  use_jit_ = false;
+  if (mode != JIT) {
+    return;
+  }
+#if defined(__x86_64__)
+  if (jit_ == nullptr) {
+    jit_ = std::unique_ptr<JitCompiler>(new JitCompiler(this, memory_mapper_.get(), &cpu_));
+    memory_mapper_->add_write_listener(jit_.get());
+  }
+  if (jit_->ok()) {
+    use_jit_ = true;
+  } else {
+    LOG(ERROR) << "JIT could not be started, interpreting instead.";
+  }
+#else
+  LOG(ERROR) << "JIT is only supported on x86-64, interpreting instead.";
+#endif
+}
+
+void OpcodeExecutor::SaveState(memory::StateWriter* writer) {
+  MaterializeFlags(&cpu_);
+  // The flags fill a word of their own, so rAF does not take in A.
+  writer->Write16(cpu_.rAF);
+  writer->Write8(cpu_.flag_struct.rA);
+  writer->Write16(cpu_.rBC);
+  writer->Write16(cpu_.rDE);
+  writer->Write16(cpu_.rHL);
+  writer->Write16(cpu_.rSP);
+  writer->Write16(cpu_.rPC);
+  writer->WriteBool(interrupt_master_enable_);
+  memory_mapper_->SaveState(writer);
+}
+
+void OpcodeExecutor::LoadState(memory::StateReader* reader) {
+  cpu_.rAF = reader->Read16();
+  cpu_.flag_struct.rA = reader->Read8();
+  cpu_.rBC = reader->Read16();
+  cpu_.rDE = reader->Read16();
+  cpu_.rHL = reader->Read16();
+  cpu_.rSP = reader->Read16();
+  cpu_.rPC = reader->Read16();
+  cpu_.pending_h.operation = FLAG_READY;
+  cpu_.pending_c.operation = FLAG_READY;
+  interrupt_master_enable_ = reader->ReadBool();
+  memory_mapper_->LoadState(reader);
+  decode_cache_.Clear();
+  if (jit_ != nullptr) {
+    jit_->Clear();
+  }
+}
+
+DecodedInstruction OpcodeExecutor::Decode(unsigned short address) {
+  const DecodedInstruction* decoded = decode_cache_.Lookup(address);
+  if (decoded != nullptr) {
+    return *decoded;
+  }
+  DecodedInstruction decoded_now = DecodeInstruction(address);
+  if (decoded_now.opcode != nullptr) {
+    decode_cache_.Insert(address, decoded_now);
+  }
+  return decoded_now;
+}
+
+int OpcodeExecutor::ExecuteDecoded(const DecodedInstruction& decoded, unsigned short address) {
+  cpu_.rPC = address + decoded.length;
+  ExecutorContext context(&interrupt_master_enable_,
+                          &cpu_.rPC,
+                          decoded.opcode,
+                          memory_mapper_.get(),
+                          &cpu_,
+                          decoded.magic,
+                          address);
+  int handler_result = decoded.opcode->handler(&context);
   if (handler_result == -1) {
     return -1;
+  }
+  cpu_.rPC = handler_result;
+  return 0;
+}
+
+// Compiled blocks only run on past an instruction when nothing outside the CPU
+// could tell the difference from running it through ReadInstruction: the
+// cycles have somewhere to go, execution falls through to the next instruction
+// in the block and no interrupt is waiting.
+int OpcodeExecutor::FinishInstruction(int cycles, unsigned short next_address) {
+  if (cycle_listener_ == nullptr || cpu_.rPC != next_address) {
+    return cycles;
+  }
+  cycle_listener_->OnCycles(cycles);
+  if (interrupt_master_enable_ && CheckInterrupts()) {
+    return 0;
+  }
+  return -1;
+}
+
+DecodedInstruction OpcodeExecutor::DecodeInstruction(unsigned short address) {
+  unsigned short opcode = memory_mapper_->Read(address);
+  unsigned short next_byte = memory_mapper_->Read(address + 1);
+
+  DecodedInstruction decoded;
+  decoded.length = 1;
+  if (opcode == 0xCB) {
+    decoded.length = 2;
+    if ((next_byte & 0b11000000) > 0) {
+      decoded.magic = (0b00111000 & next_byte) >> 3;
+    }
+    decoded.opcode = &opcode_table_->cb_prefixed[next_byte];
+    opcode = (opcode << 8) | next_byte;
+  } else if (next_byte == 0x10 && opcode == 0x00) {
+    decoded.length = 2;
+    decoded.opcode = &opcode_table_->stop;
+    opcode = next_byte << 8 | opcode;
   } else {
-    cpu_.rPC = handler_result;
+    decoded.opcode = &opcode_table_->primary[opcode];
   }
+  decoded.opcode_name = opcode;
 
-  return context.opcode->clock_cycles;
+  if (decoded.opcode->handler == nullptr) {
+    LOG(ERROR) << "Opcode instruction, " << std::hex << opcode << ", does not exist. Next value is " << std::hex << next_byte;
+    decoded.opcode = nullptr;
+  }
+  return decoded;
 }
 
 // 1) Check interrupt_master_enable_ (IME)
@@ -79,29 +184,28 @@ void OpcodeExecutor::HandleInterrupts() {
     interrupt_master_enable_ = false;
 
     if (interrupt_flag_->v_blank() && interrupt_enable_->v_blank()) {
-      LOG(INFO) << "Handling V blank interrupt.";
       interrupt_flag_->set_v_blank(false);
       cpu_.rPC = 0x0040;
     } else if (interrupt_flag_->lcd_stat() && interrupt_enable_->lcd_stat()) {
-      LOG(INFO) << "Handling LCD stat interrupt.";
       interrupt_flag_->set_lcd_stat(false);
       cpu_.rPC = 0x0048;
     } else if (interrupt_flag_->timer() && interrupt_enable_->timer()) {
-      LOG(INFO) << "Handling timer interrupt.";
       interrupt_flag_->set_timer(false);
       cpu_.rPC = 0x0050;
     } else if (interrupt_flag_->serial() && interrupt_enable_->serial()) {
-      LOG(INFO) << "Handling serial interrupt.";
       interrupt_flag_->set_serial(false);
       cpu_.rPC = 0x0058;
     } else if (interrupt_flag_->joypad() && interrupt_enable_->joypad()) {
-      LOG(INFO) << "Handling joypad interrupt.";
       interrupt_flag_->set_joypad(false);
       cpu_.rPC = 0x0060;
     }
   }
 }
 
+bool OpcodeExecutor::WaitingForInterrupt() {
+  return memory_mapper_->Read(cpu_.rPC) == 0x76 && !CheckInterrupts();
+}
+
 bool OpcodeExecutor::CheckInterrupts() {
   return (interrupt_flag_->v_blank() && interrupt_enable_->v_blank()) ||
       (interrupt_flag_->lcd_stat() && interrupt_enable_->lcd_stat()) ||
@@ -1,74 +1,113 @@
 #ifndef TURBO_SANTA_COMMON_BACK_END_OPCODE_PARSER_H_
 #define TURBO_SANTA_COMMON_BACK_END_OPCODE_PARSER_H_
 
-#include <map>
 #include <memory>
 #include "backend/memory/interrupt_flag.h"
 #include "backend/memory/memory_mapper.h"
 #include "backend/memory/primary_flags.h"
+#include "backend/opcode_executor/decode_cache.h"
+#include "backend/opcode_executor/executor_context.h"
+#include "backend/opcode_executor/jit_compiler.h"
 #include "backend/opcode_executor/opcodes.h"
 #include "backend/opcode_executor/opcode_map.h"
 #include "backend/opcode_executor/registers.h"
 
+namespace test_harness {
+class TestHarness;
+} // namespace test_harness
+
 namespace back_end {
 namespace handlers {
 
-class OpcodeExecutor {
+enum ExecutionMode {
+  INTERPRETER,
+  // Compiles blocks of code to x86-64 as they are reached; see JitCompiler.
+  JIT,
+};
+
+// Told how many cycles each instruction took as soon as it finishes.
+class CycleListener {
+ public:
+  virtual void OnCycles(int cycles) = 0;
+};
+
+class OpcodeExecutor : private JitHost {
  public:
   OpcodeExecutor(std::unique_ptr<memory::MemoryMapper> memory_mapper, 
                  memory::PrimaryFlags* primary_flags) :
       memory_mapper_(std::move(memory_mapper)),
+      decode_cache_(memory_mapper_.get()),
       interrupt_enable_(primary_flags->interrupt_enable()),
-      interrupt_flag_(primary_flags->interrupt_flag()) {}
+      interrupt_flag_(primary_flags->interrupt_flag()) {
+    memory_mapper_->add_write_listener(&decode_cache_);
+  }
 
+  // Returns the number of clock cycles taken that have not been reported to
+  // the CycleListener, or -1 if execution cannot continue. Under the JIT, with
+  // a CycleListener set, this runs a whole block, reporting each instruction
+  // but the last as it goes. Without one it runs a single instruction in
+  // either mode. Builds with THREADED_INTERPRETER defined interpret with
+  // RunThreaded, which follows the same rules for up to 64 instructions.
   int ReadInstruction();
 
+  // The JIT needs x86-64; asking for it anywhere else, or if it cannot get
+  // executable memory, logs an error and keeps interpreting.
+  void set_execution_mode(ExecutionMode mode);
+
+  void set_cycle_listener(CycleListener* cycle_listener) { cycle_listener_ = cycle_listener; }
+
+  unsigned short pc() const { return cpu_.rPC; }
+
+  // Whether the next instruction is a HALT that will wait, which it does
+  // until a scheduled event requests an enabled interrupt.
+  bool WaitingForInterrupt();
+
+  // If pc() is the top of a loop that only polls memory, the cycles each time
+  // around it takes, otherwise 0. See polling_loop.cc.
+  int PollingLoopCycles();
+
+  // Saves or loads the registers, IME and all of memory. Only safe between
+  // calls to ReadInstruction. Everything decoded or compiled is thrown away on
+  // loading.
+  void SaveState(memory::StateWriter* writer);
+  void LoadState(memory::StateReader* reader);
+
  private:
   bool CheckInterrupts();
   void HandleInterrupts();
+  // Fetches and decodes the instruction at address; the result has a null
+  // opcode if the instruction does not exist.
+  DecodedInstruction DecodeInstruction(unsigned short address);
+
+  // JitHost
+  virtual DecodedInstruction Decode(unsigned short address);
+  virtual int ExecuteDecoded(const DecodedInstruction& decoded, unsigned short address);
+  virtual int FinishInstruction(int cycles, unsigned short next_address);
+
+#ifdef THREADED_INTERPRETER
+  // ReadInstruction for the threaded interpreter, see threaded_interpreter.cc.
+  int RunThreaded();
+#endif
     
   registers::GB_CPU cpu_;
   std::unique_ptr<memory::MemoryMapper> memory_mapper_;
-  std::map<unsigned short, opcodes::Opcode> opcode_map_ = opcodes::CreateOpcodeMap(&cpu_);
+  DecodeCache decode_cache_;
+  const opcodes::OpcodeTable* opcode_table_ = &opcodes::GetOpcodeTable();
   // This is a special flag/register that can only be set or unset and can
   // only be accessed by the user using the EI, DI or RETI instructions.
   bool interrupt_master_enable_ = false;
   memory::InterruptEnable* interrupt_enable_;
   memory::InterruptFlag* interrupt_flag_;
-};
-
-struct ExecutorContext {
-  ExecutorContext(bool* interrupt_master_enable_,
-                  unsigned short* instruction_ptr_, 
-                  opcodes::Opcode* opcode_, 
-                  memory::MemoryMapper* memory_mapper_, 
-                  registers::GB_CPU* cpu_,
-                  unsigned char magic_,
-                  unsigned short instruction_address_) :
-      interrupt_master_enable(interrupt_master_enable_),
-      instruction_ptr(instruction_ptr_),
-      opcode(opcode_),
-      memory_mapper(memory_mapper_), 
-      cpu(cpu_),
-      magic(magic_),
-      instruction_address(instruction_address_) {}
-
-  ExecutorContext(ExecutorContext* context) : 
-      interrupt_master_enable(context->interrupt_master_enable),
-      instruction_ptr(context->instruction_ptr),
-      opcode(context->opcode),
-      memory_mapper(context->memory_mapper),
-      cpu(context->cpu),
-      magic(context->magic),
-      instruction_address(context->instruction_address) {}
-
-  bool* interrupt_master_enable;
-  unsigned short* instruction_ptr;
-  opcodes::Opcode* opcode;
-  memory::MemoryMapper* memory_mapper;
-  registers::GB_CPU* cpu;
-  unsigned char magic;
-  unsigned short instruction_address;
+  // Created the first time the JIT is turned on and kept, still listening for
+  // writes, if it is turned off again.
+  std::unique_ptr<JitCompiler> jit_;
+  bool use_jit_ = false;
+  CycleListener* cycle_listener_ = nullptr;
+#ifdef THREADED_INTERPRETER
+  void* threaded_dispatch_[257];
+  bool threaded_dispatch_ready_ = false;
+#endif
+  friend class test_harness::TestHarness;
 };
 
 } // namespace handlers
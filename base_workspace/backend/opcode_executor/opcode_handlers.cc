@@ -159,375 +159,228 @@ bool DoesCarry16(unsigned int left, unsigned int right) {
   return DoesOverflow(left, right, 15);
 }
 
-void Add8BitImpl(unsigned char value, GB_CPU* cpu) {
-  cpu->flag_struct.rF.C = DoesCarry8(cpu->flag_struct.rA, value);
-  cpu->flag_struct.rF.H = DoesHalfCarry8(cpu->flag_struct.rA, value);
-  cpu->flag_struct.rA += value;
-  SetZFlag(cpu->flag_struct.rA, cpu);
-  SetNFlag(false, cpu);
+bool ComputeFlag(const registers::PendingFlag& flag) {
+  switch (static_cast<FlagOperation>(flag.operation)) {
+    case HALF_CARRY_8:
+      return DoesHalfCarry8(flag.left, flag.right);
+    case CARRY_8:
+      return DoesCarry8(flag.left, flag.right);
+    case HALF_BORROW_8:
+      return DoesHalfBorrow8(flag.left, flag.right);
+    case BORROW_8:
+      return DoesBorrow8(flag.left, flag.right);
+    case HALF_CARRY_16:
+      return DoesHalfCarry16(flag.left, flag.right);
+    case CARRY_16:
+      return DoesCarry16(flag.left, flag.right);
+    case HALF_BORROW_16:
+      return DoesHalfBorrow16(flag.left, flag.right);
+    case BORROW_16:
+      return DoesBorrow16(flag.left, flag.right);
+    case FLAG_READY:
+      break;
+  }
+  LOG(FATAL) << "Flag has nothing pending.";
+  return false;
 }
 
-int Add8Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  Add8BitImpl(*opcode.reg1, context->cpu);
-  // PrintInstruction(context->frame_factory, "ADD", "A", RegisterName8(opcode.reg1, context->cpu));
-  return instruction_ptr;
+void MaterializeHFlag(GB_CPU* cpu) {
+  cpu->flag_struct.rF.H = ComputeFlag(cpu->pending_h);
+  cpu->pending_h.operation = FLAG_READY;
+}
+
+void MaterializeCFlag(GB_CPU* cpu) {
+  cpu->flag_struct.rF.C = ComputeFlag(cpu->pending_c);
+  cpu->pending_c.operation = FLAG_READY;
+}
+
+void Add8BitImpl(unsigned char value, GB_CPU* cpu) {
+  AluResult result = kAddTable[0][AluIndex(cpu->flag_struct.rA, value)];
+  cpu->flag_struct.rA = AluValue(result);
+  SetFlags(AluFlags(result), kAllFlags, cpu);
 }
 
 int Add8BitAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  Add8BitImpl(context->memory_mapper->Read(*opcode.reg1), context->cpu);
-  // PrintInstruction(context->frame_factory, "ADD", "A", "(" + RegisterName16(opcode.reg1, context->cpu) + ")");
-  return instruction_ptr;
+  Add8BitImpl(context->memory_mapper->Read(context->cpu->rHL), context->cpu);
+  // PrintInstruction(context->frame_factory, "ADD", "A", "(HL)");
+  return *context->instruction_ptr;
 }
 
 int Add8BitLiteral(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   Add8BitImpl(GetParameterValue(context->memory_mapper, instruction_ptr), context->cpu);
   // PrintInstruction(context->frame_factory, "ADD", "A", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
   return instruction_ptr + 1;
 }
 
 void ADC8BitImpl(unsigned char value, GB_CPU* cpu) {
-  char carry = cpu->flag_struct.rF.C;
-  cpu->flag_struct.rF.C = DoesCarry8(cpu->flag_struct.rA, value + carry);
-  cpu->flag_struct.rF.H = DoesHalfCarry8(cpu->flag_struct.rA, value + carry);
-  cpu->flag_struct.rA += value;
-  cpu->flag_struct.rA += carry;
-  SetZFlag(cpu->flag_struct.rA, cpu);
-  SetNFlag(false, cpu);
-}
-
-int ADC8Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  ADC8BitImpl(*opcode->reg1, context->cpu);
-  // PrintInstruction(context->frame_factory, "ADC", "A", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+  AluResult result = kAddTable[GetCFlag(cpu)][AluIndex(cpu->flag_struct.rA, value)];
+  cpu->flag_struct.rA = AluValue(result);
+  SetFlags(AluFlags(result), kAllFlags, cpu);
 }
 
 int ADC8BitAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  ADC8BitImpl(context->memory_mapper->Read(*opcode->reg1), context->cpu);
-  // PrintInstruction(context->frame_factory, "ADC", "A", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  return instruction_ptr;
+  ADC8BitImpl(context->memory_mapper->Read(context->cpu->rHL), context->cpu);
+  // PrintInstruction(context->frame_factory, "ADC", "A", "(HL)");
+  return *context->instruction_ptr;
 }
 
 int ADC8BitLiteral(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   ADC8BitImpl(GetParameterValue(context->memory_mapper, instruction_ptr), context->cpu);
   // PrintInstruction(context->frame_factory, "ADC", "A", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
   return instruction_ptr + 1;
 }
 
 void Sub8BitImpl(unsigned char value, GB_CPU* cpu) {
-  cpu->flag_struct.rF.C = !DoesBorrow8(cpu->flag_struct.rA, value);
-  cpu->flag_struct.rF.H = !DoesHalfBorrow8(cpu->flag_struct.rA, value);
-  cpu->flag_struct.rA -= value;
-  SetZFlag(cpu->flag_struct.rA, cpu);
-  SetNFlag(true, cpu);
-}
-
-int Sub8Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  Sub8BitImpl(*opcode->reg1, context->cpu);
-  // PrintInstruction(context->frame_factory, "SUB", "A", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+  AluResult result = kSubTable[0][AluIndex(cpu->flag_struct.rA, value)];
+  cpu->flag_struct.rA = AluValue(result);
+  SetFlags(AluFlags(result), kAllFlags, cpu);
 }
 
 int Sub8BitAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  Sub8BitImpl(context->memory_mapper->Read(*opcode->reg1), context->cpu);
-  // PrintInstruction(context->frame_factory, "SUB", "A", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  return instruction_ptr;
+  Sub8BitImpl(context->memory_mapper->Read(context->cpu->rHL), context->cpu);
+  // PrintInstruction(context->frame_factory, "SUB", "A", "(HL)");
+  return *context->instruction_ptr;
 }
-  
+
 int Sub8BitLiteral(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   Sub8BitImpl(GetParameterValue(context->memory_mapper, instruction_ptr), context->cpu);
   // PrintInstruction(context->frame_factory, "SUB", "A", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
   return instruction_ptr + 1;
 }
 
 void SBC8BitImpl(unsigned char value, GB_CPU* cpu) {
-    char carry = cpu->flag_struct.rF.C;
-    cpu->flag_struct.rF.C = !DoesBorrow8(cpu->flag_struct.rA, value + carry);
-    cpu->flag_struct.rF.H = !DoesHalfBorrow8(cpu->flag_struct.rA, value + carry);
-    cpu->flag_struct.rA -= value;
-    cpu->flag_struct.rA -= carry;
-    SetZFlag(cpu->flag_struct.rA, cpu);
-    SetNFlag(true, cpu);
-}
-
-int SBC8Bit(handlers::ExecutorContext* context) {
-    SBC8BitImpl(*context->opcode->reg1, context->cpu);
-    // PrintInstruction(context->frame_factory, "SBC", "A", RegisterName8(context->opcode->reg1, context->cpu));
-    return *context->instruction_ptr;
+    AluResult result = kSubTable[GetCFlag(cpu)][AluIndex(cpu->flag_struct.rA, value)];
+    cpu->flag_struct.rA = AluValue(result);
+    SetFlags(AluFlags(result), kAllFlags, cpu);
 }
 
 int SBC8BitAddress(handlers::ExecutorContext* context) {
-  SBC8BitImpl(context->memory_mapper->Read(*context->opcode->reg1), context->cpu);
-  // PrintInstruction(context->frame_factory, "SBC", "A", "(" + RegisterName16(context->opcode->reg1, context->cpu) + ")");
+  SBC8BitImpl(context->memory_mapper->Read(context->cpu->rHL), context->cpu);
+  // PrintInstruction(context->frame_factory, "SBC", "A", "(HL)");
   return *context->instruction_ptr;
 }
 
 int SBC8BitLiteral(handlers::ExecutorContext* context) {
     SBC8BitImpl(GetParameterValue(context->memory_mapper, *context->instruction_ptr), context->cpu);
     // PrintInstruction(context->frame_factory, "SBC", "A", Hex(GetParameterValue(context->memory_mapper, *context->instruction_ptr)));
-    return *context->instruction_ptr;
+    return *context->instruction_ptr + 1;
 }
 
-int And8Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  context->cpu->flag_struct.rA &= *opcode->reg1;
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = 1;
-  context->cpu->flag_struct.rF.C = 0;
-  // PrintInstruction(context->frame_factory, "AND", "A", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+void And8BitImpl(unsigned char value, GB_CPU* cpu) {
+  cpu->flag_struct.rA &= value;
+  SetZFlag(cpu->flag_struct.rA, cpu);
+  SetNFlag(false, cpu);
+  SetHFlag(true, cpu);
+  SetCFlag(false, cpu);
 }
-  
+
 int And8BitAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  context->cpu->flag_struct.rA &= context->memory_mapper->Read(*opcode->reg1);
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = 1;
-  context->cpu->flag_struct.rF.C = 0;
-  // PrintInstruction(context->frame_factory, "AND", "A", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  return instruction_ptr;
+  And8BitImpl(context->memory_mapper->Read(context->cpu->rHL), context->cpu);
+  // PrintInstruction(context->frame_factory, "AND", "A", "(HL)");
+  return *context->instruction_ptr;
 }
-  
+
 int And8BitLiteral(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  context->cpu->flag_struct.rA &= GetParameterValue(context->memory_mapper, instruction_ptr);
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = 1;
-  context->cpu->flag_struct.rF.C = 0;
+  And8BitImpl(GetParameterValue(context->memory_mapper, instruction_ptr), context->cpu);
   // PrintInstruction(context->frame_factory, "AND", "A", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
   return instruction_ptr + 1;
 }
 
-int Or8Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  context->cpu->flag_struct.rA |= *opcode->reg1;
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = 0;
-  context->cpu->flag_struct.rF.C = 0;
-  // PrintInstruction(context->frame_factory, "OR", "A", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+void Or8BitImpl(unsigned char value, GB_CPU* cpu) {
+  cpu->flag_struct.rA |= value;
+  SetZFlag(cpu->flag_struct.rA, cpu);
+  SetNFlag(false, cpu);
+  SetHFlag(false, cpu);
+  SetCFlag(false, cpu);
 }
 
 int Or8BitAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  context->cpu->flag_struct.rA |= context->memory_mapper->Read(*opcode->reg1);
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = 0;
-  context->cpu->flag_struct.rF.C = 0;
-  // PrintInstruction(context->frame_factory, "OR", "A", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  return instruction_ptr;
+  Or8BitImpl(context->memory_mapper->Read(context->cpu->rHL), context->cpu);
+  // PrintInstruction(context->frame_factory, "OR", "A", "(HL)");
+  return *context->instruction_ptr;
 }
-  
+
 int Or8BitLiteral(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  context->cpu->flag_struct.rA |= GetParameterValue(context->memory_mapper, instruction_ptr);
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = 0;
-  context->cpu->flag_struct.rF.C = 0;
+  Or8BitImpl(GetParameterValue(context->memory_mapper, instruction_ptr), context->cpu);
   // PrintInstruction(context->frame_factory, "OR", "A", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
   return instruction_ptr + 1;
 }
 
-int Xor8Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  context->cpu->flag_struct.rA ^= *opcode->reg1;
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = 0;
-  context->cpu->flag_struct.rF.C = 0;
-  // PrintInstruction(context->frame_factory, "XOR", "A", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+void Xor8BitImpl(unsigned char value, GB_CPU* cpu) {
+  cpu->flag_struct.rA ^= value;
+  SetZFlag(cpu->flag_struct.rA, cpu);
+  SetNFlag(false, cpu);
+  SetHFlag(false, cpu);
+  SetCFlag(false, cpu);
 }
 
 int Xor8BitAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  context->cpu->flag_struct.rA ^= context->memory_mapper->Read(*opcode->reg1);
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = 0;
-  context->cpu->flag_struct.rF.C = 0;
-  // PrintInstruction(context->frame_factory, "XOR", "A", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  return instruction_ptr;
+  Xor8BitImpl(context->memory_mapper->Read(context->cpu->rHL), context->cpu);
+  // PrintInstruction(context->frame_factory, "XOR", "A", "(HL)");
+  return *context->instruction_ptr;
 }
 
 int Xor8BitLiteral(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  context->cpu->flag_struct.rA ^= GetParameterValue(context->memory_mapper, instruction_ptr);
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = 0;
-  context->cpu->flag_struct.rF.C = 0;
+  Xor8BitImpl(GetParameterValue(context->memory_mapper, instruction_ptr), context->cpu);
   // PrintInstruction(context->frame_factory, "XOR", "A", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
   return instruction_ptr + 1;
 }
 
-int Cp8Bit(handlers::ExecutorContext* context) {
-  Opcode* opcode = context->opcode;
-
-  int instruction_ptr = *context->instruction_ptr;
-  unsigned char result = context->cpu->flag_struct.rA - *opcode->reg1;
-  SetZFlag(result, context->cpu);
-  SetNFlag(true, context->cpu); // Performed subtraction.
-  context->cpu->flag_struct.rF.H = !DoesHalfBorrow8(context->cpu->flag_struct.rA, *opcode->reg1);
-  context->cpu->flag_struct.rF.C = !DoesBorrow8(context->cpu->flag_struct.rA, *opcode->reg1);
-  // PrintInstruction(context->frame_factory, "CP", "A", RegisterName8(opcode->reg1, context->cpu));
-  LOG(INFO) << "Z flag = " << 0x0000 + context->cpu->flag_struct.rF.Z;
-  LOG(INFO) << "N flag = " << 0x0000 + context->cpu->flag_struct.rF.N;
-  LOG(INFO) << "H flag = " << 0x0000 + context->cpu->flag_struct.rF.H;
-  LOG(INFO) << "C flag = " << 0x0000 + context->cpu->flag_struct.rF.C;
-  return instruction_ptr;
+void Cp8BitImpl(unsigned char value, GB_CPU* cpu) {
+  // Same flags as SUB, without storing the result.
+  SetFlags(AluFlags(kSubTable[0][AluIndex(cpu->flag_struct.rA, value)]), kAllFlags, cpu);
 }
 
 int Cp8BitAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char value = context->memory_mapper->Read(*opcode->reg1);
-  unsigned char result = context->cpu->flag_struct.rA - value;
-  SetZFlag(result, context->cpu);
-  SetNFlag(true, context->cpu); // Performed subtraction.
-  context->cpu->flag_struct.rF.H = !DoesHalfBorrow8(context->cpu->flag_struct.rA, value);
-  context->cpu->flag_struct.rF.C = !DoesBorrow8(context->cpu->flag_struct.rA, value);
-  // PrintInstruction(context->frame_factory, "CP", "A", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  LOG(INFO) << "Z flag = " << 0x0000 + context->cpu->flag_struct.rF.Z;
-  LOG(INFO) << "N flag = " << 0x0000 + context->cpu->flag_struct.rF.N;
-  LOG(INFO) << "H flag = " << 0x0000 + context->cpu->flag_struct.rF.H;
-  LOG(INFO) << "C flag = " << 0x0000 + context->cpu->flag_struct.rF.C;
-  return instruction_ptr;
+  Cp8BitImpl(context->memory_mapper->Read(context->cpu->rHL), context->cpu);
+  // PrintInstruction(context->frame_factory, "CP", "A", "(HL)");
+  return *context->instruction_ptr;
 }
-  
-  
+
 int Cp8BitLiteral(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char value = GetParameterValue(context->memory_mapper, instruction_ptr);
-  unsigned char result = context->cpu->flag_struct.rA - value;
-  SetZFlag(result, context->cpu);
-  SetNFlag(true, context->cpu); // Performed subtraction.
-  context->cpu->flag_struct.rF.H = !DoesHalfBorrow8(context->cpu->flag_struct.rA, value);
-  context->cpu->flag_struct.rF.C = !DoesBorrow8(context->cpu->flag_struct.rA, value);
+  Cp8BitImpl(GetParameterValue(context->memory_mapper, instruction_ptr), context->cpu);
   // PrintInstruction(context->frame_factory, "CP", "A", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
-  LOG(INFO) << "Z flag = " << 0x0000 + context->cpu->flag_struct.rF.Z;
-  LOG(INFO) << "N flag = " << 0x0000 + context->cpu->flag_struct.rF.N;
-  LOG(INFO) << "H flag = " << 0x0000 + context->cpu->flag_struct.rF.H;
-  LOG(INFO) << "C flag = " << 0x0000 + context->cpu->flag_struct.rF.C;
   return instruction_ptr + 1;
 }
 
-int Inc8Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char* reg = (unsigned char*) opcode.reg1;
-  bool half_carry = DoesHalfCarry8(*reg, 1);
-  ++(*reg);
-  
-  SetZFlag(*reg, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = half_carry;
-  // PrintInstruction(context->frame_factory, "INC", RegisterName8(opcode.reg1, context->cpu));
-  return instruction_ptr;
-}
-
 int Inc8BitAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char val = context->memory_mapper->Read(*opcode.reg1);
-  bool half_carry = DoesHalfCarry8(val, 1);
-  context->memory_mapper->Write(*opcode.reg1, ++val);
-
-  SetZFlag(val, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = half_carry;
-  // PrintInstruction(context->frame_factory, "INC", "(" + RegisterName16(opcode.reg1, context->cpu) + ")");
-  return instruction_ptr;
-}
-  
-int Dec8Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char* reg = (unsigned char*) opcode.reg1;
-  bool borrowed_h = DoesHalfBorrow8(*reg, 1);
-  --(*reg);
-  
-  SetZFlag(*reg, context->cpu);
-  SetNFlag(true, context->cpu);
-  context->cpu->flag_struct.rF.H = borrowed_h;
-  if (opcode.opcode_name == 0x05) {
-    LOG(INFO) << "B decremented to " << std::hex << 0x0000 + *reg;
-    LOG(INFO) << "Z flag is " << std::dec << 0x0000 + context->cpu->flag_struct.rF.Z;
-  }
-  // PrintInstruction(context->frame_factory, "DEC", RegisterName8(opcode.reg1, context->cpu));
-  return instruction_ptr;
+  unsigned short address = context->cpu->rHL;
+  unsigned char val = context->memory_mapper->Read(address);
+  AluResult result = kIncTable[val];
+  context->memory_mapper->Write(address, AluValue(result));
+  SetFlags(AluFlags(result), kZFlag | kNFlag | kHFlag, context->cpu);
+  // PrintInstruction(context->frame_factory, "INC", "(HL)");
+  return *context->instruction_ptr;
 }
 
 int Dec8BitAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char val = context->memory_mapper->Read(*opcode.reg1);
-  bool borrowed_h = DoesHalfBorrow8(val, 1);
-  context->memory_mapper->Write(*opcode.reg1, --val);
-  
-  SetZFlag(val, context->cpu);
-  SetNFlag(true, context->cpu);
-  context->cpu->flag_struct.rF.H = borrowed_h;
-  // PrintInstruction(context->frame_factory, "DEC", "(" + RegisterName16(opcode.reg1, context->cpu) + ")");
-  return instruction_ptr;
-}
-  
-int Add16Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  context->cpu->flag_struct.rF.H = DoesHalfCarry16(context->cpu->rHL, *opcode.reg1);
-  context->cpu->flag_struct.rF.C = DoesCarry16(context->cpu->rHL, *opcode.reg1);
-  context->cpu->rHL += *opcode.reg1;
-  SetNFlag(false, context->cpu);
-  // PrintInstruction(context->frame_factory, "ADD", "HL", RegisterName16(opcode.reg1, context->cpu));
-  return instruction_ptr;
+  unsigned short address = context->cpu->rHL;
+  unsigned char val = context->memory_mapper->Read(address);
+  AluResult result = kDecTable[val];
+  context->memory_mapper->Write(address, AluValue(result));
+  SetFlags(AluFlags(result), kZFlag | kNFlag | kHFlag, context->cpu);
+  // PrintInstruction(context->frame_factory, "DEC", "(HL)");
+  return *context->instruction_ptr;
 }
 
 int AddSPLiteral(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   // This value is signed.
   char value = static_cast<char>(GetParameterValue(context->memory_mapper, instruction_ptr));
   if (NthBit(value, 7)) {
     // TODO(Brendan): Make sure this works the same for signed.
-    context->cpu->flag_struct.rF.H = DoesHalfBorrow16(context->cpu->rSP, value);
-    context->cpu->flag_struct.rF.C = DoesBorrow16(context->cpu->rSP, value);
+    DeferHFlag(HALF_BORROW_16, context->cpu->rSP, value, context->cpu);
+    DeferCFlag(BORROW_16, context->cpu->rSP, value, context->cpu);
   } else {
-    context->cpu->flag_struct.rF.H = DoesHalfCarry16(context->cpu->rSP, value);
-    context->cpu->flag_struct.rF.C = DoesCarry16(context->cpu->rSP, value);
+    DeferHFlag(HALF_CARRY_16, context->cpu->rSP, value, context->cpu);
+    DeferCFlag(CARRY_16, context->cpu->rSP, value, context->cpu);
   }
   SetNFlag(false, context->cpu);
   context->cpu->flag_struct.rF.Z = 0;
@@ -536,75 +389,33 @@ int AddSPLiteral(handlers::ExecutorContext* context) {
   return instruction_ptr + 1;
 }
 
-int Inc16Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  ++(*opcode.reg1);
-  // No flags are affected by this instruction
-  // PrintInstruction(context->frame_factory, "INC", RegisterName16(opcode.reg1, context->cpu));
-  return instruction_ptr;
-}
-
-int Dec16Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  --(*opcode.reg1);
-  // No flags are affected by this instruction
-  // PrintInstruction(context->frame_factory, "DEC", RegisterName16(opcode.reg1, context->cpu));
-  return instruction_ptr;
+unsigned char SwapImpl(unsigned char value, GB_CPU* cpu) {
+  AluResult result = kShiftTable[SHIFT_SWAP][value];
+  SetFlags(AluFlags(result), kAllFlags, cpu);
+  return AluValue(result);
 }
 
-int Swap(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char* reg = (unsigned char*) opcode->reg1;
-  unsigned char value = *reg;
-  *reg = (value << 4) | (value >> 4);
-  SetZFlag(*reg, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = 0;
-  context->cpu->flag_struct.rF.C = 0;
-  // PrintInstruction(context->frame_factory, "SWAP", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
-}
-  
 int SwapAddress(handlers::ExecutorContext* context) {
-  unsigned char val = context->memory_mapper->Read(*context->opcode->reg1);
-  unsigned char swapVal = (val << 4) | (val >> 4);
-  context->memory_mapper->Write(*context->opcode->reg1, swapVal);
-  SetZFlag(swapVal, context->cpu);
-  SetNFlag(false, context->cpu);
-  context->cpu->flag_struct.rF.H = 0;
-  context->cpu->flag_struct.rF.C = 0;
-  // PrintInstruction(context->frame_factory, "SWAP", "(" + RegisterName16(context->opcode->reg1, context->cpu) + ")");
+  unsigned short address = context->cpu->rHL;
+  context->memory_mapper->Write(address, SwapImpl(context->memory_mapper->Read(address), context->cpu));
+  // PrintInstruction(context->frame_factory, "SWAP", "(HL)");
   return *context->instruction_ptr;
 }
 
 int DAA(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-
-  unsigned char mul = 0x6;
-  unsigned char sum = context->cpu->flag_struct.rA;
-  unsigned char n = sum / 10;
-  while (n > 0) {
-    sum += n * mul;
-    n /= 10;
-    mul *= 0x0F;
-  }
-  context->cpu->flag_struct.rF.C = context->cpu->flag_struct.rA > 0x64;
-  context->cpu->flag_struct.rA = sum;
-  context->cpu->flag_struct.rF.H = 0;
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
+
+  AluResult result = kDaaTable[context->cpu->flag_struct.rA];
+  context->cpu->flag_struct.rA = AluValue(result);
+  SetFlags(AluFlags(result), kZFlag | kHFlag | kCFlag, context->cpu);
   // PrintInstruction(context->frame_factory, "DAA");
   return instruction_ptr;
 }
 
 int CPL(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   context->cpu->flag_struct.rA = ~context->cpu->flag_struct.rA;
-  context->cpu->flag_struct.rF.H = 1;
+  SetHFlag(true, context->cpu);
   SetNFlag(true, context->cpu);
   // PrintInstruction(context->frame_factory, "CPL");
   return instruction_ptr;
@@ -612,10 +423,9 @@ int CPL(handlers::ExecutorContext* context) {
 
 int CCF(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   context->cpu->flag_struct.rA = ~context->cpu->flag_struct.rA;
-  context->cpu->flag_struct.rF.C = !context->cpu->flag_struct.rF.C;
-  context->cpu->flag_struct.rF.H = 0;
+  SetCFlag(!GetCFlag(context->cpu), context->cpu);
+  SetHFlag(false, context->cpu);
   SetNFlag(false, context->cpu);
   // PrintInstruction(context->frame_factory, "CCF");
   return instruction_ptr;
@@ -623,33 +433,32 @@ int CCF(handlers::ExecutorContext* context) {
 
 int SCF(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  context->cpu->flag_struct.rF.C = 1;
-  context->cpu->flag_struct.rF.H = 0;
+  SetCFlag(true, context->cpu);
+  SetHFlag(false, context->cpu);
   SetNFlag(false, context->cpu);
   // PrintInstruction(context->frame_factory, "SCF");
   return instruction_ptr;
 }
 
 int NOP(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   // PrintInstruction(context->frame_factory, "NOP");
-  return instruction_ptr;
+  return *context->instruction_ptr;
 }
 
+// The CPU waits until an enabled interrupt is requested, which is done by
+// running HALT again until IF & IE is non-zero. The interrupt is then handled
+// before the next fetch, or if IME is off, execution carries on after HALT.
 int Halt(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  LOG(WARNING) << "UNINPLEMENTED OPCODE: Halt";
-  // TODO: We should actually halt instead of just nop
+  memory::MemoryMapper* memory_mapper = context->memory_mapper;
   // PrintInstruction(context->frame_factory, "HALT");
-  return instruction_ptr;
+  if ((memory_mapper->Read(0xff0f) & memory_mapper->Read(0xffff) & 0x1f) == 0) {
+    return context->instruction_address;
+  }
+  return *context->instruction_ptr;
 }
 
 int Stop(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   LOG(WARNING) << "UNINPLEMENTED OPCODE: Stop";
   // TODO: We should actually stop instead of just nop
   // PrintInstruction(context->frame_factory, "STOP");
@@ -658,7 +467,6 @@ int Stop(handlers::ExecutorContext* context) {
 
 int DI(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   *context->interrupt_master_enable = false;
   // PrintInstruction(context->frame_factory, "DI");
   return instruction_ptr;
@@ -666,7 +474,6 @@ int DI(handlers::ExecutorContext* context) {
 
 int EI(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   *context->interrupt_master_enable = true;
   // PrintInstruction(context->frame_factory, "EI");
   return instruction_ptr;
@@ -674,420 +481,182 @@ int EI(handlers::ExecutorContext* context) {
 
 int RLCA(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char msb = NthBit(context->cpu->flag_struct.rA, 7);
-  context->cpu->flag_struct.rF.C = msb;
-  context->cpu->flag_struct.rA = (context->cpu->flag_struct.rA << 1) | msb;
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
+  context->cpu->flag_struct.rA = RLCImpl(context->cpu->flag_struct.rA, context->cpu);
   // PrintInstruction(context->frame_factory, "RLCA");
   return instruction_ptr;
 }
 
 int RLA(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char carry = context->cpu->flag_struct.rF.C;
-  context->cpu->flag_struct.rF.C = NthBit(context->cpu->flag_struct.rA, 7);
-  context->cpu->flag_struct.rA = context->cpu->flag_struct.rA << 1;
-  context->cpu->flag_struct.rA |= carry;
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
+  context->cpu->flag_struct.rA = RLImpl(context->cpu->flag_struct.rA, context->cpu);
   // PrintInstruction(context->frame_factory, "RLA");
   return instruction_ptr;
 }
 
 int RRCA(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char lsb = NthBit(context->cpu->flag_struct.rA, 0);
-  context->cpu->flag_struct.rF.C = lsb;
-  context->cpu->flag_struct.rA = (context->cpu->flag_struct.rA >> 1) | (lsb << 7);
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
+  context->cpu->flag_struct.rA = RRCImpl(context->cpu->flag_struct.rA, context->cpu);
   // PrintInstruction(context->frame_factory, "RRCA");
   return instruction_ptr;
 }
 
 int RRA(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char carry = context->cpu->flag_struct.rF.C;
-  context->cpu->flag_struct.rF.C = NthBit(context->cpu->flag_struct.rA, 0);
-  context->cpu->flag_struct.rA = context->cpu->flag_struct.rA >> 1;
-  context->cpu->flag_struct.rA |= (carry << 7);
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(context->cpu->flag_struct.rA, context->cpu);
+  context->cpu->flag_struct.rA = RRImpl(context->cpu->flag_struct.rA, context->cpu);
   // PrintInstruction(context->frame_factory, "RRA");
   return instruction_ptr;
 }
 
-int RLC(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char* reg = (unsigned char*) opcode->reg1;
-  unsigned char msb = NthBit(*reg, 7);
-  context->cpu->flag_struct.rF.C = msb;
-  *reg = (*reg << 1) | msb;
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(*reg, context->cpu);
-  // PrintInstruction(context->frame_factory, "RLC", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+unsigned char RLCImpl(unsigned char value, GB_CPU* cpu) {
+  AluResult result = kShiftTable[SHIFT_RLC][value];
+  SetFlags(AluFlags(result), kAllFlags, cpu);
+  return AluValue(result);
 }
 
 int RLCAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char value = context->memory_mapper->Read(*opcode->reg1);
-  unsigned char msb = NthBit(value, 7);
-  context->cpu->flag_struct.rF.C = msb;
-  value = (value << 1) | msb;
-  context->memory_mapper->Write(*opcode->reg1, value);
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(value, context->cpu);
-  // PrintInstruction(context->frame_factory, "RLC", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  return instruction_ptr;
+  unsigned short address = context->cpu->rHL;
+  context->memory_mapper->Write(address, RLCImpl(context->memory_mapper->Read(address), context->cpu));
+  // PrintInstruction(context->frame_factory, "RLC", "(HL)");
+  return *context->instruction_ptr;
 }
 
-int RL(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char* reg = (unsigned char*) opcode->reg1;
-  unsigned char carry = context->cpu->flag_struct.rF.C;
-  context->cpu->flag_struct.rF.C = NthBit(*reg, 7);
-  *reg = *reg << 1;
-  *reg |= carry;
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(*reg, context->cpu);
-  // PrintInstruction(context->frame_factory, "RL", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+unsigned char RLImpl(unsigned char value, GB_CPU* cpu) {
+  AluResult result = kShiftTable[SHIFT_RL][AluIndex(GetCFlag(cpu), value)];
+  SetFlags(AluFlags(result), kAllFlags, cpu);
+  return AluValue(result);
 }
 
 int RLAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char value = context->memory_mapper->Read(*opcode->reg1);
-  unsigned char carry = context->cpu->flag_struct.rF.C;
-  context->cpu->flag_struct.rF.C = NthBit(value, 7);
-  value = value << 1;
-  value |= carry;
-  context->memory_mapper->Write(*opcode->reg1, value);
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(value, context->cpu);
-  // PrintInstruction(context->frame_factory, "RL", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  return instruction_ptr;
+  unsigned short address = context->cpu->rHL;
+  context->memory_mapper->Write(address, RLImpl(context->memory_mapper->Read(address), context->cpu));
+  // PrintInstruction(context->frame_factory, "RL", "(HL)");
+  return *context->instruction_ptr;
 }
 
-int RRC(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char* reg = (unsigned char*) opcode->reg1;
-  unsigned char lsb = NthBit(*reg, 0);
-  context->cpu->flag_struct.rF.C = lsb;
-  *reg = (*reg >> 1) | (lsb << 7);
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(*reg, context->cpu);
-  // PrintInstruction(context->frame_factory, "RRC", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+unsigned char RRCImpl(unsigned char value, GB_CPU* cpu) {
+  AluResult result = kShiftTable[SHIFT_RRC][value];
+  SetFlags(AluFlags(result), kAllFlags, cpu);
+  return AluValue(result);
 }
 
 int RRCAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char value = context->memory_mapper->Read(*opcode->reg1);
-  unsigned char lsb = NthBit(value, 0);
-  context->cpu->flag_struct.rF.C = lsb;
-  value = (value >> 1) | (lsb << 7);
-  context->memory_mapper->Write(*opcode->reg1, value);
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(value, context->cpu);
-  // PrintInstruction(context->frame_factory, "RRC", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  return instruction_ptr;
+  unsigned short address = context->cpu->rHL;
+  context->memory_mapper->Write(address, RRCImpl(context->memory_mapper->Read(address), context->cpu));
+  // PrintInstruction(context->frame_factory, "RRC", "(HL)");
+  return *context->instruction_ptr;
 }
 
-int RR(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char* reg = (unsigned char*) opcode->reg1;
-  unsigned char carry = context->cpu->flag_struct.rF.C;
-  context->cpu->flag_struct.rF.C = NthBit(*reg, 0);
-  *reg = *reg >> 1;
-  *reg |= (carry << 7);
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(*reg, context->cpu);
-  // PrintInstruction(context->frame_factory, "RR", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+unsigned char RRImpl(unsigned char value, GB_CPU* cpu) {
+  AluResult result = kShiftTable[SHIFT_RR][AluIndex(GetCFlag(cpu), value)];
+  SetFlags(AluFlags(result), kAllFlags, cpu);
+  return AluValue(result);
 }
 
 int RRAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char value = context->memory_mapper->Read(*opcode->reg1);
-  unsigned char carry = context->cpu->flag_struct.rF.C;
-  context->cpu->flag_struct.rF.C = NthBit(value, 0);
-  value = value >> 1;
-  value |= (carry << 7);
-  context->memory_mapper->Write(*opcode->reg1, value);
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(value, context->cpu);
-  // PrintInstruction(context->frame_factory, "RR", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  return instruction_ptr;
+  unsigned short address = context->cpu->rHL;
+  context->memory_mapper->Write(address, RRImpl(context->memory_mapper->Read(address), context->cpu));
+  // PrintInstruction(context->frame_factory, "RR", "(HL)");
+  return *context->instruction_ptr;
 }
 
-int SLA(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char* reg = (unsigned char*) opcode->reg1;
-  context->cpu->flag_struct.rF.C = NthBit(*reg, 7);
-  *reg = *reg << 1;
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(*reg, context->cpu);
-  // PrintInstruction(context->frame_factory, "SLA", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+unsigned char SLAImpl(unsigned char value, GB_CPU* cpu) {
+  AluResult result = kShiftTable[SHIFT_SLA][value];
+  SetFlags(AluFlags(result), kAllFlags, cpu);
+  return AluValue(result);
 }
 
 int SLAAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char value = context->memory_mapper->Read(*opcode->reg1);
-  context->cpu->flag_struct.rF.C = NthBit(value, 7);
-  value = value << 1;
-  context->memory_mapper->Write(*opcode->reg1, value);
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(value, context->cpu);
-  // PrintInstruction(context->frame_factory, "SLA", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  return instruction_ptr;
+  unsigned short address = context->cpu->rHL;
+  context->memory_mapper->Write(address, SLAImpl(context->memory_mapper->Read(address), context->cpu));
+  // PrintInstruction(context->frame_factory, "SLA", "(HL)");
+  return *context->instruction_ptr;
 }
 
-int SRA(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char* reg = (unsigned char*) opcode->reg1;
-  context->cpu->flag_struct.rF.C = NthBit(*reg, 0);
-  unsigned char msb = NthBit(*reg, 7) << 7;
-  *reg = *reg >> 1;
-  *reg |= msb;
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(*reg, context->cpu);
-  // PrintInstruction(context->frame_factory, "SRA", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+unsigned char SRAImpl(unsigned char value, GB_CPU* cpu) {
+  AluResult result = kShiftTable[SHIFT_SRA][value];
+  SetFlags(AluFlags(result), kAllFlags, cpu);
+  return AluValue(result);
 }
 
 int SRAAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char value = context->memory_mapper->Read(*opcode->reg1);
-  context->cpu->flag_struct.rF.C = NthBit(value, 0);
-  unsigned char msb = NthBit(value, 7) << 7;
-  value = value >> 1;
-  value |= msb;
-  context->memory_mapper->Write(*opcode->reg1, value);
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(value, context->cpu);
-  // PrintInstruction(context->frame_factory, "SRA", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  return instruction_ptr;
+  unsigned short address = context->cpu->rHL;
+  context->memory_mapper->Write(address, SRAImpl(context->memory_mapper->Read(address), context->cpu));
+  // PrintInstruction(context->frame_factory, "SRA", "(HL)");
+  return *context->instruction_ptr;
 }
 
-int SRL(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char* reg = (unsigned char*) opcode->reg1;
-  context->cpu->flag_struct.rF.C = NthBit(*reg, 0);
-  *reg = *reg >> 1;
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(*reg, context->cpu);
-  // PrintInstruction(context->frame_factory, "SRL", RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+unsigned char SRLImpl(unsigned char value, GB_CPU* cpu) {
+  AluResult result = kShiftTable[SHIFT_SRL][value];
+  SetFlags(AluFlags(result), kAllFlags, cpu);
+  return AluValue(result);
 }
 
 int SRLAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char value = context->memory_mapper->Read(*opcode->reg1);
-  context->cpu->flag_struct.rF.C = NthBit(value, 0);
-  value = value >> 1;
-  context->memory_mapper->Write(*opcode->reg1, value);
-  context->cpu->flag_struct.rF.H = 0;
-  SetNFlag(false, context->cpu);
-  SetZFlag(value, context->cpu);
-  // PrintInstruction(context->frame_factory, "SRL", "(" + RegisterName16(opcode->reg1, context->cpu) + ")");
-  return instruction_ptr;
-}
-
-int Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char* reg = (unsigned char*) opcode->reg1;
-  unsigned char bit = NthBit(*reg, context->magic);
-  context->cpu->flag_struct.rF.H = 1;
-  SetZFlag(bit, context->cpu);
-  SetNFlag(false, context->cpu);
-  
-  // PrintInstruction(context->frame_factory, "BIT", Hex(context->magic), RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+  unsigned short address = context->cpu->rHL;
+  context->memory_mapper->Write(address, SRLImpl(context->memory_mapper->Read(address), context->cpu));
+  // PrintInstruction(context->frame_factory, "SRL", "(HL)");
+  return *context->instruction_ptr;
 }
 
 int BitAddress(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
   unsigned char val = context->memory_mapper->Read(context->cpu->rHL);
   unsigned char bit = NthBit(val, context->magic);
-  context->cpu->flag_struct.rF.H = 1;
+  SetHFlag(true, context->cpu);
   SetZFlag(bit, context->cpu);
   SetNFlag(false, context->cpu);
-  
+
   // PrintInstruction(context->frame_factory, "BIT", Hex(context->magic), "(HL)");
   return instruction_ptr;
 }
-  
-int Set(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char* reg = (unsigned char*) opcode->reg1;
-  unsigned char bit = context->magic;
-  *reg |= (0x1 << bit);
-  
-  // PrintInstruction(context->frame_factory, "SET", Hex(context->magic), RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
-}
 
-int Res(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char* reg = (unsigned char*) opcode->reg1;
-  unsigned char bit = context->magic;
-  *reg &= ~(0x1 << bit);
-  
-  // PrintInstruction(context->frame_factory, "RES", Hex(context->magic), RegisterName8(opcode->reg1, context->cpu));
-  return instruction_ptr;
+int SetAddress(handlers::ExecutorContext* context) {
+  unsigned short address = context->cpu->rHL;
+  unsigned char val = context->memory_mapper->Read(address);
+  context->memory_mapper->Write(address, val | (0x1 << context->magic));
+
+  // PrintInstruction(context->frame_factory, "SET", Hex(context->magic), "(HL)");
+  return *context->instruction_ptr;
 }
 
+int ResAddress(handlers::ExecutorContext* context) {
+  unsigned short address = context->cpu->rHL;
+  unsigned char val = context->memory_mapper->Read(address);
+  context->memory_mapper->Write(address, val & ~(0x1 << context->magic));
+
+  // PrintInstruction(context->frame_factory, "RES", Hex(context->magic), "(HL)");
+  return *context->instruction_ptr;
+}
 
 int Jump(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   instruction_ptr = GetAddress16(context->memory_mapper, instruction_ptr);
-  
-  // PrintInstruction(context->frame_factory, "JP", Hex(instruction_ptr));
-  return instruction_ptr;
-}
 
-int JumpConditional(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  switch (opcode.opcode_name) {
-    case 0xC2:
-      // PrintInstruction(context->frame_factory, "JP", "NZ", Hex(GetAddress16(context->memory_mapper, instruction_ptr)));
-      if (!context->cpu->flag_struct.rF.Z) {
-        return Jump(context);
-      }
-      return instruction_ptr;
-    case 0xCA:
-      // PrintInstruction(context->frame_factory, "JP", "Z", Hex(GetAddress16(context->memory_mapper, instruction_ptr)));
-      if (context->cpu->flag_struct.rF.Z) {
-        return Jump(context);
-      }
-      return instruction_ptr;
-    case 0xD2:
-      // PrintInstruction(context->frame_factory, "JP", "NC", Hex(GetAddress16(context->memory_mapper, instruction_ptr)));
-      if (!context->cpu->flag_struct.rF.C) {
-        return Jump(context);
-      }
-      return instruction_ptr;
-    case 0xDA:
-      // PrintInstruction(context->frame_factory, "JP", "C", Hex(GetAddress16(context->memory_mapper, instruction_ptr)));
-      if (context->cpu->flag_struct.rF.C) {
-        return Jump(context);
-      }
-      return instruction_ptr;
-  }
+  // PrintInstruction(context->frame_factory, "JP", Hex(instruction_ptr));
   return instruction_ptr;
 }
 
 int JumpHL(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  instruction_ptr = context->cpu->rHL;
-  
   // PrintInstruction(context->frame_factory, "JP", "(HL)");
-  return instruction_ptr;
+  return context->cpu->rHL;
 }
 
-int JumpRelativeImpl(handlers::ExecutorContext* context) {
+int JumpRelative(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   instruction_ptr += 1 + static_cast<char>(GetParameterValue(context->memory_mapper, instruction_ptr));
 
-  LOG(INFO) << "Jumping to " << std::hex << instruction_ptr;
-
-  return instruction_ptr;
-}
-
-int JumpRelative(handlers::ExecutorContext* context) {
-  int instruction_ptr = JumpRelativeImpl(context);
   // PrintInstruction(context->frame_factory, "JR", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
   return instruction_ptr;
 }
 
-int JumpRelativeConditional(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  switch (opcode.opcode_name) {
-    case 0x20:
-      // PrintInstruction(context->frame_factory, "JR", "NZ", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
-      if (!context->cpu->flag_struct.rF.Z) {
-        return JumpRelativeImpl(context);
-      }
-      return instruction_ptr + 1; // Have to account for the 8-bit parameter 
-                                  // whether we use it or not.
-    case 0x28:
-      // PrintInstruction(context->frame_factory, "JR", "Z", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
-      if (context->cpu->flag_struct.rF.Z) {
-        return JumpRelativeImpl(context);
-      }
-      return instruction_ptr + 1;
-    case 0x30:
-      // PrintInstruction(context->frame_factory, "JR", "NC", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
-      if (!context->cpu->flag_struct.rF.C) {
-        return JumpRelativeImpl(context);
-      }
-      return instruction_ptr + 1;
-    case 0x38:
-      // PrintInstruction(context->frame_factory, "JR", "C", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
-      if (context->cpu->flag_struct.rF.C) {
-        return JumpRelativeImpl(context);
-      }
-  }
-  LOG(INFO) << "Not jumping";
-  return instruction_ptr + 1;
-}
-
 // TODO(Brendan, Diego, Aaron, Dave): We should make sure we are doing endian
 // specific work in functions that we can either swap out at compile time or at
 // runtime to preserve correct endianness.
 unsigned char GetLSB(unsigned short value) {
-  LOG(INFO) << "Pushing, lsb is " << std::hex << 0x0000 + static_cast<unsigned char>(value);
   return static_cast<unsigned char>(value);
 }
 
 unsigned char GetMSB(unsigned short value) {
-  LOG(INFO) << "Pushing, msb is " << std::hex << 0x0000 + static_cast<unsigned char>(value >> 8);
   return static_cast<unsigned char>(value >> 8);
 }
 
@@ -1111,7 +680,6 @@ void PopRegister(MemoryMapper* memory_mapper, GB_CPU* cpu, unsigned short* reg)
 
 int Call(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   GB_CPU* cpu = context->cpu;
   unsigned short* rPC = &cpu->rPC;
 
@@ -1120,81 +688,13 @@ int Call(handlers::ExecutorContext* context) {
   // context->call_stack->Push({context->frame_factory->current_timestamp(), *rPC});
   PushRegister(context->memory_mapper, cpu, rPC);
 
-  LOG(INFO) << "Calling address: " << std::hex << address;
   instruction_ptr = address;
-  
-  // PrintInstruction(context->frame_factory, "CALL", Hex(address));
-  return instruction_ptr;
-}
-
-int CallConditional(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  switch (opcode.opcode_name) {
-    case 0xC4:
-      // PrintInstruction(context->frame_factory, "CALL", "NZ", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
-      if (!context->cpu->flag_struct.rF.Z) {
-        return Call(context);
-      }
-      return instruction_ptr;
-    case 0xCC:
-      // PrintInstruction(context->frame_factory, "CALL", "Z", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
-      if (context->cpu->flag_struct.rF.Z) {
-        return Call(context);
-      }
-      return instruction_ptr;
-    case 0xD4:
-      // PrintInstruction(context->frame_factory, "CALL", "NC", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
-      if (!context->cpu->flag_struct.rF.C) {
-        return Call(context);
-      }
-      return instruction_ptr;
-    case 0xDC:
-      // PrintInstruction(context->frame_factory, "CALL", "C", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
-      if (context->cpu->flag_struct.rF.C) {
-        return Call(context);
-      }
-      return instruction_ptr;
-  }
-  return instruction_ptr;
-}
-
-int Restart(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char accum = 0;
-  switch (opcode.opcode_name) {
-    case 0xFF:
-      accum += 0x08;
-    case 0xF7:
-      accum += 0x08;
-    case 0xEF:
-      accum += 0x08;
-    case 0xE7:
-      accum += 0x08;
-    case 0xDF:
-      accum += 0x08;
-    case 0xD7:
-      accum += 0x08;
-    case 0xCF:
-      accum += 0x08;
-    case 0xC7:
-      instruction_ptr = accum;
-  }
-
-  GB_CPU* cpu = context->cpu;
-  // context->call_stack->Push({context->frame_factory->current_timestamp(), cpu->rPC});
-  PushRegister(context->memory_mapper, cpu, &cpu->rPC);
 
-  LOG(INFO) << "Restarting at address: " << std::hex << instruction_ptr;
-  
-  // PrintInstruction(context->frame_factory, "RST", Hex(opcode.opcode_name));
+  // PrintInstruction(context->frame_factory, "CALL", Hex(address));
   return instruction_ptr;
 }
 
 int Return(handlers::ExecutorContext* context) {
-  LOG(INFO) << "Returning";
-  Opcode opcode = *context->opcode;
   PopRegister(context->memory_mapper, context->cpu, &context->cpu->rPC);
   // PrintInstruction(context->frame_factory, "RET");
   // if (!context->call_stack->PeekCheck(context->cpu->rPC)) {
@@ -1208,176 +708,61 @@ int Return(handlers::ExecutorContext* context) {
   return context->cpu->rPC;
 }
 
-int ReturnConditional(handlers::ExecutorContext* context) {
-  LOG(INFO) << "Conditional return";
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  switch (opcode.opcode_name) {
-    case 0xC0:
-      // PrintInstruction(context->frame_factory, "RET", "NZ");
-      if (!context->cpu->flag_struct.rF.Z) {
-        return Return(context);
-      }
-      return instruction_ptr;
-    case 0xC8:
-      // PrintInstruction(context->frame_factory, "RET", "Z");
-      if (context->cpu->flag_struct.rF.Z) {
-        return Return(context);
-      }
-      return instruction_ptr;
-    case 0xD0:
-      // PrintInstruction(context->frame_factory, "RET", "NC");
-      if (!context->cpu->flag_struct.rF.C) {
-        return Return(context);
-      }
-      return instruction_ptr;
-    case 0xD8:
-      // PrintInstruction(context->frame_factory, "RET", "C");
-      if (context->cpu->flag_struct.rF.C) {
-        return Return(context);
-      }
-  }
-  return instruction_ptr;
-}
-
 int ReturnInterrupt(handlers::ExecutorContext* context) {
-  LOG(INFO) << "Returning from interrupt.";
-  ExecutorContext new_context(context);
   EI(context);
-  
+
   // PrintInstruction(context->frame_factory, "RETI");
   return Return(context);
 }
 
-int LoadN(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode* opcode = context->opcode;
-  unsigned char value = GetParameterValue(context->memory_mapper, instruction_ptr);
-  *((unsigned char*) opcode->reg1) = value;
-  
-  // PrintInstruction(context->frame_factory, "LD", RegisterName8(opcode->reg1, context->cpu), Hex(value));
-  return instruction_ptr + 1;
-}
-
-int LoadRR8Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char* reg1 = (unsigned char*)opcode.reg1;
-  unsigned char* reg2 = (unsigned char*)opcode.reg2;
-  *((unsigned char*) reg1) = *((unsigned char*) reg2);
-  
-  // PrintInstruction(context->frame_factory, "LD", RegisterName8(opcode.reg1, context->cpu), RegisterName8(opcode.reg2, context->cpu));
-  return instruction_ptr;
-}
-
-int LoadRR8BitAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char* reg1 = (unsigned char*) opcode.reg1;
-  *reg1 = context->memory_mapper->Read(*opcode.reg2);
-  
-  // PrintInstruction(context->frame_factory, "LD", RegisterName8(opcode.reg1, context->cpu), "(HL)");
-  return instruction_ptr;
-}
-
-int LoadRR8BitIntoAddress(handlers::ExecutorContext* context) {
-  Opcode opcode = *context->opcode;
-  context->memory_mapper->Write(*opcode.reg1, *opcode.reg2);
-  
-  // PrintInstruction(context->frame_factory, "LD", "(HL)", RegisterName8(opcode.reg2, context->cpu));
-  return *context->instruction_ptr;
-}
-  
 int Load8BitLiteral(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   unsigned short val = (unsigned short)GetParameterValue(context->memory_mapper, instruction_ptr);
-  context->memory_mapper->Write(*opcode.reg1, val);
-  
+  context->memory_mapper->Write(context->cpu->rHL, val);
+
   // PrintInstruction(context->frame_factory, "LD", "(HL)", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
   return instruction_ptr + 1;
 
 }
-  
-int LoadRR16Bit(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  *opcode.reg1 = *opcode.reg2;
-  
-  // PrintInstruction(context->frame_factory, "LD", RegisterName16(opcode.reg1, context->cpu), RegisterName16(opcode.reg2, context->cpu));
-  return instruction_ptr;
-}
-
-int LoadAN(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  context->cpu->flag_struct.rA = context->memory_mapper->Read(*opcode.reg1);
-  
-  // PrintInstruction(context->frame_factory, "LD", "(" + RegisterName16(opcode.reg1, context->cpu) + ")", "A");
-  return instruction_ptr;
-}
 
 int LoadAN16BitLiteral(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   unsigned short address = GetParameterValue16(context->memory_mapper, instruction_ptr);
   context->cpu->flag_struct.rA = context->memory_mapper->Read(address);
-  
+
   // PrintInstruction(context->frame_factory, "LD", "(" + Hex(address) + ")", "A");
   return instruction_ptr + 2;
 }
-  
+
 int LoadAN8BitLiteral(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   context->cpu->flag_struct.rA = GetParameterValue(context->memory_mapper, instruction_ptr);
-  
+
   // PrintInstruction(context->frame_factory, "LD", "A", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
   return instruction_ptr + 1;
 }
 
-int LoadNA(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  unsigned char* reg1 = (unsigned char*)opcode.reg1;
-  *reg1 = (unsigned char)context->cpu->flag_struct.rA;
-  
-  // PrintInstruction(context->frame_factory, "LD", RegisterName8(opcode.reg1, context->cpu), "A");
-  return instruction_ptr;
-}
-
-int LoadNAAddress(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  context->memory_mapper->Write(*opcode.reg1, context->cpu->flag_struct.rA);
-  
-  // PrintInstruction(context->frame_factory, "LD", "(" + RegisterName16(opcode.reg1, context->cpu) + ")", "A");
-  return instruction_ptr;
-}
-  
 int LoadNA16BitLiteral(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
   unsigned short address = GetParameterValue16(context->memory_mapper, instruction_ptr);
   context->memory_mapper->Write(address, context->cpu->flag_struct.rA);
-  
+
   // PrintInstruction(context->frame_factory, "LD", Hex(address), "A");
   return instruction_ptr + 2;
 }
 
 int LoadAC(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   context->cpu->flag_struct.rA = context->memory_mapper->Read(0xFF00 + context->cpu->bc_struct.rC);
-  
+
   // PrintInstruction(context->frame_factory, "LD", "A", "(C)");
   return instruction_ptr;
 }
 
 int LoadCA(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   context->memory_mapper->Write(0xFF00 + context->cpu->bc_struct.rC, context->cpu->flag_struct.rA);
-  
+
   // PrintInstruction(context->frame_factory, "LD", "(C)", "A");
   return instruction_ptr;
 }
@@ -1386,7 +771,7 @@ int LoadDecAHL(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
   context->cpu->flag_struct.rA = context->memory_mapper->Read(context->cpu->rHL);
   context->cpu->rHL--;
-  
+
   // PrintInstruction(context->frame_factory, "LD", "A", "(HL-)");
   return instruction_ptr;
 }
@@ -1395,7 +780,7 @@ int LoadDecHLA(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
   context->memory_mapper->Write(context->cpu->rHL, context->cpu->flag_struct.rA);
   context->cpu->rHL--;
-  
+
   // PrintInstruction(context->frame_factory, "LD", "(HL-)", "A");
   return instruction_ptr;
 }
@@ -1404,7 +789,7 @@ int LoadIncAHL(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
   context->cpu->flag_struct.rA = context->memory_mapper->Read(context->cpu->rHL);
   context->cpu->rHL++;
-  
+
   // PrintInstruction(context->frame_factory, "LD", "A", "(HL+)");
   return instruction_ptr;
 }
@@ -1413,67 +798,53 @@ int LoadIncHLA(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
   context->memory_mapper->Write(context->cpu->rHL, context->cpu->flag_struct.rA);
   context->cpu->rHL++;
-  
+
   // PrintInstruction(context->frame_factory, "LD", "(HL+)", "A");
   return instruction_ptr;
 }
 
 int LoadHNA(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   MemoryMapper* memory_mapper = context->memory_mapper;
   unsigned short address = 0xFF00 + GetParameterValue(memory_mapper, instruction_ptr);
   unsigned char value = context->cpu->flag_struct.rA;
   memory_mapper->Write(address, value);
-  LOG(INFO) << std::hex << 0x0000 + value << " was written to " << std::hex << address;
-  
+
   // PrintInstruction(context->frame_factory, "LD", "(0xff00 +" + Hex(GetParameterValue(memory_mapper, instruction_ptr)) + ")", "A");
   return instruction_ptr + 1;
 }
 
 int LoadHAN(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   MemoryMapper* memory_mapper = context->memory_mapper;
   context->cpu->flag_struct.rA = memory_mapper->Read(0xFF00 + GetParameterValue(memory_mapper, instruction_ptr));
-  
+
   // PrintInstruction(context->frame_factory, "LD", "A", "(0xff00 + " + Hex(GetParameterValue(memory_mapper, instruction_ptr)) + ")");
   return instruction_ptr + 1;
 }
 
-int LoadNN(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  *opcode.reg1 = GetParameterValue16(context->memory_mapper, instruction_ptr);
-  
-  // PrintInstruction(context->frame_factory, "LD", RegisterName16(opcode.reg1, context->cpu), Hex(GetParameterValue16(context->memory_mapper, instruction_ptr)));
-  return instruction_ptr + 2;
-}
-
 int LoadSPHL(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   context->cpu->rSP = context->cpu->rHL;
-  
+
   // PrintInstruction(context->frame_factory, "LD", "SP", "HL");
   return instruction_ptr;
 }
 
 int LoadHLSP(handlers::ExecutorContext* context) {
   int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
   char val = static_cast<char>(GetParameterValue(context->memory_mapper, instruction_ptr));
   if (val < 0) {
-    context->cpu->flag_struct.rF.H = DoesHalfBorrow8(context->cpu->rSP, val);
-    context->cpu->flag_struct.rF.C = DoesBorrow8(context->cpu->rSP, val);
+    DeferHFlag(HALF_BORROW_8, context->cpu->rSP, val, context->cpu);
+    DeferCFlag(BORROW_8, context->cpu->rSP, val, context->cpu);
   } else {
-    context->cpu->flag_struct.rF.H = DoesHalfCarry8(context->cpu->rSP, val);
-    context->cpu->flag_struct.rF.C = DoesCarry8(context->cpu->rSP, val);
+    DeferHFlag(HALF_CARRY_8, context->cpu->rSP, val, context->cpu);
+    DeferCFlag(CARRY_8, context->cpu->rSP, val, context->cpu);
   }
   context->cpu->rHL = context->cpu->rSP + val;
   context->cpu->flag_struct.rF.Z = 0;
   SetNFlag(false, context->cpu);
-  
+
   // PrintInstruction(context->frame_factory, "LDHL", "SP", Hex(GetParameterValue(context->memory_mapper, instruction_ptr)));
   return instruction_ptr + 1;
 }
@@ -1490,22 +861,6 @@ int LoadNNSP(handlers::ExecutorContext* context) {
   return instruction_ptr + 2;
 }
 
-int Push(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  PushRegister(context->memory_mapper, context->cpu, opcode.reg1);
-  // PrintInstruction(context->frame_factory, "Push", RegisterName16(opcode.reg1, context->cpu));
-  return instruction_ptr;
-}
-
-int Pop(handlers::ExecutorContext* context) {
-  int instruction_ptr = *context->instruction_ptr;
-  Opcode opcode = *context->opcode;
-  PopRegister(context->memory_mapper, context->cpu, opcode.reg1);
-  // PrintInstruction(context->frame_factory, "Pop", RegisterName16(opcode.reg1, context->cpu));
-  return instruction_ptr;
-}
-
 int HaltAndCatchFire(handlers::ExecutorContext*) {
   // PrintInstruction(context->frame_factory, "HCF");
   endwin();
@@ -4,54 +4,268 @@
 #include <memory>
 
 #include "backend/memory/memory_mapper.h"
+#include "backend/opcode_executor/alu_tables.h"
+#include "backend/opcode_executor/executor_context.h"
 #include "backend/opcode_executor/opcodes.h"
 #include "backend/opcode_executor/registers.h"
+#include "submodules/glog/src/glog/logging.h"
 
 namespace back_end {
 namespace handlers {
 
+// Conditions tested by the conditional jumps, calls and returns.
+enum Condition {
+  NOT_ZERO,
+  ZERO,
+  NOT_CARRY,
+  CARRY
+};
+
 // Helper functions.
+unsigned char GetParameterValue(memory::MemoryMapper* memory_mapper, int instruction_ptr);
+void SetZFlag(unsigned char register_value, registers::GB_CPU* cpu);
+void SetNFlag(bool performed_subtraction, registers::GB_CPU* cpu);
+unsigned char NthBit(unsigned int byte, int n);
+bool DoesHalfCarry8(unsigned char left, unsigned char right);
+bool DoesHalfBorrow8(unsigned char left, unsigned char right);
+bool DoesBorrow8(unsigned char left, unsigned char right);
+bool DoesCarry8(unsigned char left, unsigned char right);
+bool DoesHalfCarry16(unsigned char left, unsigned char right);
+bool DoesCarry16(unsigned int left, unsigned int right);
 void PushRegister(memory::MemoryMapper* memory_mapper,
                   registers::GB_CPU* cpu, unsigned short* reg);
+void PopRegister(memory::MemoryMapper* memory_mapper,
+                 registers::GB_CPU* cpu, unsigned short* reg);
+
+// Lazy H and C flags. Each FlagOperation is the helper function of the same
+// name applied to a PendingFlag's left and right operands.
+enum FlagOperation {
+  FLAG_READY = 0,
+  HALF_CARRY_8,
+  CARRY_8,
+  HALF_BORROW_8,
+  BORROW_8,
+  HALF_CARRY_16,
+  CARRY_16,
+  HALF_BORROW_16,
+  BORROW_16
+};
+
+void MaterializeHFlag(registers::GB_CPU* cpu);
+void MaterializeCFlag(registers::GB_CPU* cpu);
+
+// Stores every pending flag in rF. Must be called before reading or writing rF
+// or rAF other than through the helpers below.
+inline void MaterializeFlags(registers::GB_CPU* cpu) {
+  if (cpu->pending_h.operation != FLAG_READY) {
+    MaterializeHFlag(cpu);
+  }
+  if (cpu->pending_c.operation != FLAG_READY) {
+    MaterializeCFlag(cpu);
+  }
+}
+
+inline bool GetHFlag(registers::GB_CPU* cpu) {
+  if (cpu->pending_h.operation != FLAG_READY) {
+    MaterializeHFlag(cpu);
+  }
+  return cpu->flag_struct.rF.H;
+}
+
+inline bool GetCFlag(registers::GB_CPU* cpu) {
+  if (cpu->pending_c.operation != FLAG_READY) {
+    MaterializeCFlag(cpu);
+  }
+  return cpu->flag_struct.rF.C;
+}
+
+inline void SetHFlag(bool value, registers::GB_CPU* cpu) {
+  cpu->pending_h.operation = FLAG_READY;
+  cpu->flag_struct.rF.H = value;
+}
+
+inline void SetCFlag(bool value, registers::GB_CPU* cpu) {
+  cpu->pending_c.operation = FLAG_READY;
+  cpu->flag_struct.rF.C = value;
+}
+
+// Copies the flags picked out by mask from an AluResult's flags into rF.
+inline void SetFlags(unsigned char flags, unsigned char mask, registers::GB_CPU* cpu) {
+  if (mask & kZFlag) {
+    cpu->flag_struct.rF.Z = (flags & kZFlag) != 0;
+  }
+  if (mask & kNFlag) {
+    cpu->flag_struct.rF.N = (flags & kNFlag) != 0;
+  }
+  if (mask & kHFlag) {
+    SetHFlag((flags & kHFlag) != 0, cpu);
+  }
+  if (mask & kCFlag) {
+    SetCFlag((flags & kCFlag) != 0, cpu);
+  }
+}
+
+inline void DeferHFlag(FlagOperation operation, unsigned int left, unsigned int right,
+                       registers::GB_CPU* cpu) {
+  cpu->pending_h.operation = operation;
+  cpu->pending_h.left = left;
+  cpu->pending_h.right = right;
+}
+
+inline void DeferCFlag(FlagOperation operation, unsigned int left, unsigned int right,
+                       registers::GB_CPU* cpu) {
+  cpu->pending_c.operation = operation;
+  cpu->pending_c.left = left;
+  cpu->pending_c.right = right;
+}
+
+template<Condition condition>
+bool IsConditionMet(registers::GB_CPU* cpu) {
+  switch (condition) {
+    case NOT_ZERO:
+      return !cpu->flag_struct.rF.Z;
+    case ZERO:
+      return cpu->flag_struct.rF.Z;
+    case NOT_CARRY:
+      return !GetCFlag(cpu);
+    case CARRY:
+      return GetCFlag(cpu);
+  }
+  return false;
+}
 
 // 8 Bit ALU
-int Add8Bit(handlers::ExecutorContext* context);
+void Add8BitImpl(unsigned char value, registers::GB_CPU* cpu);
+void ADC8BitImpl(unsigned char value, registers::GB_CPU* cpu);
+void Sub8BitImpl(unsigned char value, registers::GB_CPU* cpu);
+void SBC8BitImpl(unsigned char value, registers::GB_CPU* cpu);
+void And8BitImpl(unsigned char value, registers::GB_CPU* cpu);
+void Or8BitImpl(unsigned char value, registers::GB_CPU* cpu);
+void Xor8BitImpl(unsigned char value, registers::GB_CPU* cpu);
+void Cp8BitImpl(unsigned char value, registers::GB_CPU* cpu);
+
+template<registers::Register8 reg>
+int Add8Bit(handlers::ExecutorContext* context) {
+  Add8BitImpl(registers::Get8<reg>(context->cpu), context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int ADC8Bit(handlers::ExecutorContext* context) {
+  ADC8BitImpl(registers::Get8<reg>(context->cpu), context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int Sub8Bit(handlers::ExecutorContext* context) {
+  Sub8BitImpl(registers::Get8<reg>(context->cpu), context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int SBC8Bit(handlers::ExecutorContext* context) {
+  SBC8BitImpl(registers::Get8<reg>(context->cpu), context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int And8Bit(handlers::ExecutorContext* context) {
+  And8BitImpl(registers::Get8<reg>(context->cpu), context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int Or8Bit(handlers::ExecutorContext* context) {
+  Or8BitImpl(registers::Get8<reg>(context->cpu), context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int Xor8Bit(handlers::ExecutorContext* context) {
+  Xor8BitImpl(registers::Get8<reg>(context->cpu), context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int Cp8Bit(handlers::ExecutorContext* context) {
+  Cp8BitImpl(registers::Get8<reg>(context->cpu), context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int Inc8Bit(handlers::ExecutorContext* context) {
+  unsigned char& value = registers::Get8<reg>(context->cpu);
+  AluResult result = kIncTable[value];
+  value = AluValue(result);
+  SetFlags(AluFlags(result), kZFlag | kNFlag | kHFlag, context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int Dec8Bit(handlers::ExecutorContext* context) {
+  unsigned char& value = registers::Get8<reg>(context->cpu);
+  AluResult result = kDecTable[value];
+  value = AluValue(result);
+  SetFlags(AluFlags(result), kZFlag | kNFlag | kHFlag, context->cpu);
+  return *context->instruction_ptr;
+}
+
 int Add8BitAddress(handlers::ExecutorContext* context);
 int Add8BitLiteral(handlers::ExecutorContext* context);
-int ADC8Bit(handlers::ExecutorContext* context);
 int ADC8BitAddress(handlers::ExecutorContext* context);
 int ADC8BitLiteral(handlers::ExecutorContext* context);
-int Sub8Bit(handlers::ExecutorContext* context);
 int Sub8BitAddress(handlers::ExecutorContext* context);
 int Sub8BitLiteral(handlers::ExecutorContext* context);
-int SBC8Bit(handlers::ExecutorContext* context);
 int SBC8BitAddress(handlers::ExecutorContext* context);
 int SBC8BitLiteral(handlers::ExecutorContext* context);
-int And8Bit(handlers::ExecutorContext* context);
 int And8BitAddress(handlers::ExecutorContext* context);
 int And8BitLiteral(handlers::ExecutorContext* context);
-int Or8Bit(handlers::ExecutorContext* context);
 int Or8BitAddress(handlers::ExecutorContext* context);
 int Or8BitLiteral(handlers::ExecutorContext* context);
-int Xor8Bit(handlers::ExecutorContext* context);
 int Xor8BitAddress(handlers::ExecutorContext* context);
 int Xor8BitLiteral(handlers::ExecutorContext* context);
-int Cp8Bit(handlers::ExecutorContext* context);
 int Cp8BitAddress(handlers::ExecutorContext* context);
 int Cp8BitLiteral(handlers::ExecutorContext* context);
-int Inc8Bit(handlers::ExecutorContext* context);
 int Inc8BitAddress(handlers::ExecutorContext* context);
-int Dec8Bit(handlers::ExecutorContext* context);
 int Dec8BitAddress(handlers::ExecutorContext* context);
-  
+
 // 16 Bit ALU
-int Add16Bit(handlers::ExecutorContext* context);
+template<registers::Register16 reg>
+int Add16Bit(handlers::ExecutorContext* context) {
+  unsigned short value = registers::Get16<reg>(context->cpu);
+  DeferHFlag(HALF_CARRY_16, context->cpu->rHL, value, context->cpu);
+  DeferCFlag(CARRY_16, context->cpu->rHL, value, context->cpu);
+  context->cpu->rHL += value;
+  SetNFlag(false, context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register16 reg>
+int Inc16Bit(handlers::ExecutorContext* context) {
+  ++registers::Get16<reg>(context->cpu);
+  // No flags are affected by this instruction
+  return *context->instruction_ptr;
+}
+
+template<registers::Register16 reg>
+int Dec16Bit(handlers::ExecutorContext* context) {
+  --registers::Get16<reg>(context->cpu);
+  // No flags are affected by this instruction
+  return *context->instruction_ptr;
+}
+
 int AddSPLiteral(handlers::ExecutorContext* context);
-int Inc16Bit(handlers::ExecutorContext* context);
-int Dec16Bit(handlers::ExecutorContext* context);
 
 // Miscelaneous
-int Swap(handlers::ExecutorContext* context);
+unsigned char SwapImpl(unsigned char value, registers::GB_CPU* cpu);
+
+template<registers::Register8 reg>
+int Swap(handlers::ExecutorContext* context) {
+  unsigned char& value = registers::Get8<reg>(context->cpu);
+  value = SwapImpl(value, context->cpu);
+  return *context->instruction_ptr;
+}
+
 int SwapAddress(handlers::ExecutorContext* context);
 int DAA(handlers::ExecutorContext* context);
 int CPL(handlers::ExecutorContext* context);
@@ -64,62 +278,208 @@ int DI(handlers::ExecutorContext* context);
 int EI(handlers::ExecutorContext* context);
 
 // Rotates & Shifts
+unsigned char RLCImpl(unsigned char value, registers::GB_CPU* cpu);
+unsigned char RLImpl(unsigned char value, registers::GB_CPU* cpu);
+unsigned char RRCImpl(unsigned char value, registers::GB_CPU* cpu);
+unsigned char RRImpl(unsigned char value, registers::GB_CPU* cpu);
+unsigned char SLAImpl(unsigned char value, registers::GB_CPU* cpu);
+unsigned char SRAImpl(unsigned char value, registers::GB_CPU* cpu);
+unsigned char SRLImpl(unsigned char value, registers::GB_CPU* cpu);
+
+template<registers::Register8 reg>
+int RLC(handlers::ExecutorContext* context) {
+  unsigned char& value = registers::Get8<reg>(context->cpu);
+  value = RLCImpl(value, context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int RL(handlers::ExecutorContext* context) {
+  unsigned char& value = registers::Get8<reg>(context->cpu);
+  value = RLImpl(value, context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int RRC(handlers::ExecutorContext* context) {
+  unsigned char& value = registers::Get8<reg>(context->cpu);
+  value = RRCImpl(value, context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int RR(handlers::ExecutorContext* context) {
+  unsigned char& value = registers::Get8<reg>(context->cpu);
+  value = RRImpl(value, context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int SLA(handlers::ExecutorContext* context) {
+  unsigned char& value = registers::Get8<reg>(context->cpu);
+  value = SLAImpl(value, context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int SRA(handlers::ExecutorContext* context) {
+  unsigned char& value = registers::Get8<reg>(context->cpu);
+  value = SRAImpl(value, context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int SRL(handlers::ExecutorContext* context) {
+  unsigned char& value = registers::Get8<reg>(context->cpu);
+  value = SRLImpl(value, context->cpu);
+  return *context->instruction_ptr;
+}
+
 int RLCA(handlers::ExecutorContext* context);
 int RLA(handlers::ExecutorContext* context);
 int RRCA(handlers::ExecutorContext* context);
 int RRA(handlers::ExecutorContext* context);
-int RLC(handlers::ExecutorContext* context);
 int RLCAddress(handlers::ExecutorContext* context);
-int RL(handlers::ExecutorContext* context);
 int RLAddress(handlers::ExecutorContext* context);
-int RRC(handlers::ExecutorContext* context);
 int RRCAddress(handlers::ExecutorContext* context);
-int RR(handlers::ExecutorContext* context);
 int RRAddress(handlers::ExecutorContext* context);
-int SLA(handlers::ExecutorContext* context);
 int SLAAddress(handlers::ExecutorContext* context);
-int SRA(handlers::ExecutorContext* context);
 int SRAAddress(handlers::ExecutorContext* context);
-int SRL(handlers::ExecutorContext* context);
 int SRLAddress(handlers::ExecutorContext* context);
 
 // Bit operators
-int Bit(handlers::ExecutorContext* context);
+// The bit index is not part of the template; it is decoded from the opcode
+// into ExecutorContext::magic.
+template<registers::Register8 reg>
+int Bit(handlers::ExecutorContext* context) {
+  unsigned char bit = NthBit(registers::Get8<reg>(context->cpu), context->magic);
+  SetHFlag(true, context->cpu);
+  SetZFlag(bit, context->cpu);
+  SetNFlag(false, context->cpu);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int Set(handlers::ExecutorContext* context) {
+  registers::Get8<reg>(context->cpu) |= (0x1 << context->magic);
+  return *context->instruction_ptr;
+}
+
+template<registers::Register8 reg>
+int Res(handlers::ExecutorContext* context) {
+  registers::Get8<reg>(context->cpu) &= ~(0x1 << context->magic);
+  return *context->instruction_ptr;
+}
+
 int BitAddress(handlers::ExecutorContext* context);
-int Set(handlers::ExecutorContext* context);
-int Res(handlers::ExecutorContext* context);
+int SetAddress(handlers::ExecutorContext* context);
+int ResAddress(handlers::ExecutorContext* context);
 
 // Jumps
 int Jump(handlers::ExecutorContext* context);
-int JumpConditional(handlers::ExecutorContext* context);
 int JumpHL(handlers::ExecutorContext* context);
 int JumpRelative(handlers::ExecutorContext* context);
-int JumpRelativeConditional(handlers::ExecutorContext* context);
+
+template<Condition condition>
+int JumpConditional(handlers::ExecutorContext* context) {
+  if (IsConditionMet<condition>(context->cpu)) {
+    return Jump(context);
+  }
+  return *context->instruction_ptr;
+}
+
+template<Condition condition>
+int JumpRelativeConditional(handlers::ExecutorContext* context) {
+  if (IsConditionMet<condition>(context->cpu)) {
+    return JumpRelative(context);
+  }
+  return *context->instruction_ptr + 1; // Have to account for the 8-bit parameter
+                                        // whether we use it or not.
+}
 
 // Calls
 int Call(handlers::ExecutorContext* context);
-int CallConditional(handlers::ExecutorContext* context);
+
+template<Condition condition>
+int CallConditional(handlers::ExecutorContext* context) {
+  if (IsConditionMet<condition>(context->cpu)) {
+    return Call(context);
+  }
+  return *context->instruction_ptr;
+}
 
 // Restart
-int Restart(handlers::ExecutorContext* context);
+template<unsigned char address>
+int Restart(handlers::ExecutorContext* context) {
+  registers::GB_CPU* cpu = context->cpu;
+  PushRegister(context->memory_mapper, cpu, &cpu->rPC);
+  return address;
+}
 
 // Returns
 int Return(handlers::ExecutorContext* context);
-int ReturnConditional(handlers::ExecutorContext* context);
 int ReturnInterrupt(handlers::ExecutorContext* context);
 
+template<Condition condition>
+int ReturnConditional(handlers::ExecutorContext* context) {
+  if (IsConditionMet<condition>(context->cpu)) {
+    return Return(context);
+  }
+  return *context->instruction_ptr;
+}
+
 // 8-Bit Loads
-int LoadN(handlers::ExecutorContext* context);
-int LoadRR8Bit(handlers::ExecutorContext* context);
-int LoadRR8BitAddress(handlers::ExecutorContext* context);
-int LoadRR8BitIntoAddress(handlers::ExecutorContext* context);
+template<registers::Register8 reg>
+int LoadN(handlers::ExecutorContext* context) {
+  int instruction_ptr = *context->instruction_ptr;
+  registers::Get8<reg>(context->cpu) = GetParameterValue(context->memory_mapper, instruction_ptr);
+  return instruction_ptr + 1;
+}
+
+template<registers::Register8 destination, registers::Register8 source>
+int LoadRR8Bit(handlers::ExecutorContext* context) {
+  registers::Get8<destination>(context->cpu) = registers::Get8<source>(context->cpu);
+  return *context->instruction_ptr;
+}
+
+// LD r,(HL)
+template<registers::Register8 destination>
+int LoadRR8BitAddress(handlers::ExecutorContext* context) {
+  registers::Get8<destination>(context->cpu) = context->memory_mapper->Read(context->cpu->rHL);
+  return *context->instruction_ptr;
+}
+
+// LD (HL),r
+template<registers::Register8 source>
+int LoadRR8BitIntoAddress(handlers::ExecutorContext* context) {
+  context->memory_mapper->Write(context->cpu->rHL, registers::Get8<source>(context->cpu));
+  return *context->instruction_ptr;
+}
+
+// LD A,(rr)
+template<registers::Register16 address>
+int LoadAN(handlers::ExecutorContext* context) {
+  context->cpu->flag_struct.rA = context->memory_mapper->Read(registers::Get16<address>(context->cpu));
+  return *context->instruction_ptr;
+}
+
+// LD r,A
+template<registers::Register8 destination>
+int LoadNA(handlers::ExecutorContext* context) {
+  registers::Get8<destination>(context->cpu) = context->cpu->flag_struct.rA;
+  return *context->instruction_ptr;
+}
+
+// LD (rr),A
+template<registers::Register16 address>
+int LoadNAAddress(handlers::ExecutorContext* context) {
+  context->memory_mapper->Write(registers::Get16<address>(context->cpu), context->cpu->flag_struct.rA);
+  return *context->instruction_ptr;
+}
+
 int Load8BitLiteral(handlers::ExecutorContext* context);
-int LoadRR16Bit(handlers::ExecutorContext* context);
-int LoadAN(handlers::ExecutorContext* context);
 int LoadAN16BitLiteral(handlers::ExecutorContext* context);
 int LoadAN8BitLiteral(handlers::ExecutorContext* context);
-int LoadNA(handlers::ExecutorContext* context);
-int LoadNAAddress(handlers::ExecutorContext* context);
 int LoadNA16BitLiteral(handlers::ExecutorContext* context);
 int LoadAC(handlers::ExecutorContext* context);
 int LoadCA(handlers::ExecutorContext* context);
@@ -131,12 +491,36 @@ int LoadHNA(handlers::ExecutorContext* context);
 int LoadHAN(handlers::ExecutorContext* context);
 
 // 16-Bit Loads
-int LoadNN(handlers::ExecutorContext* context);
+unsigned short GetParameterValue16(memory::MemoryMapper* memory_mapper, int instruction_ptr);
+
+template<registers::Register16 reg>
+int LoadNN(handlers::ExecutorContext* context) {
+  int instruction_ptr = *context->instruction_ptr;
+  registers::Get16<reg>(context->cpu) = GetParameterValue16(context->memory_mapper, instruction_ptr);
+  return instruction_ptr + 2;
+}
+
+template<registers::Register16 reg>
+int Push(handlers::ExecutorContext* context) {
+  if (reg == registers::rAF) {
+    MaterializeFlags(context->cpu);
+  }
+  PushRegister(context->memory_mapper, context->cpu, &registers::Get16<reg>(context->cpu));
+  return *context->instruction_ptr;
+}
+
+template<registers::Register16 reg>
+int Pop(handlers::ExecutorContext* context) {
+  if (reg == registers::rAF) {
+    MaterializeFlags(context->cpu);
+  }
+  PopRegister(context->memory_mapper, context->cpu, &registers::Get16<reg>(context->cpu));
+  return *context->instruction_ptr;
+}
+
 int LoadSPHL(handlers::ExecutorContext* context);
 int LoadHLSP(handlers::ExecutorContext* context);
 int LoadNNSP(handlers::ExecutorContext* context);
-int Push(handlers::ExecutorContext* context);
-int Pop(handlers::ExecutorContext* context);
 
 // Bonus
 int HaltAndCatchFire(handlers::ExecutorContext* context);
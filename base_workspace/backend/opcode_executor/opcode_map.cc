@@ -8,366 +8,378 @@ namespace opcodes {
 
 using std::map;
 using std::vector;
-using registers::GB_CPU;
 using namespace handlers;
+using namespace registers;
 
+map<unsigned short, Opcode> CreateOpcodeMap() {
+  const vector<Opcode> opcodes = {
+    {0x06, LoadN<rB>, 8},
+    {0x0e, LoadN<rC>, 8},
+    {0x16, LoadN<rD>, 8},
+    {0x1e, LoadN<rE>, 8},
+    {0x26, LoadN<rH>, 8},
+    {0x2e, LoadN<rL>, 8},
+    {0x7f, LoadRR8Bit<rA, rA>, 4},
+    {0x78, LoadRR8Bit<rA, rB>, 4},
+    {0x79, LoadRR8Bit<rA, rC>, 4},
+    {0x7a, LoadRR8Bit<rA, rD>, 4},
+    {0x7b, LoadRR8Bit<rA, rE>, 4},
+    {0x7c, LoadRR8Bit<rA, rH>, 4},
+    {0x7d, LoadRR8Bit<rA, rL>, 4},
+    {0x40, LoadRR8Bit<rB, rB>, 4},
+    {0x41, LoadRR8Bit<rB, rC>, 4},
+    {0x42, LoadRR8Bit<rB, rD>, 4},
+    {0x43, LoadRR8Bit<rB, rE>, 4},
+    {0x44, LoadRR8Bit<rB, rH>, 4},
+    {0x45, LoadRR8Bit<rB, rL>, 4},
+    {0x48, LoadRR8Bit<rC, rB>, 4},
+    {0x49, LoadRR8Bit<rC, rC>, 4},
+    {0x4a, LoadRR8Bit<rC, rD>, 4},
+    {0x4b, LoadRR8Bit<rC, rE>, 4},
+    {0x4c, LoadRR8Bit<rC, rH>, 4},
+    {0x4d, LoadRR8Bit<rC, rL>, 4},
+    {0x50, LoadRR8Bit<rD, rB>, 4},
+    {0x51, LoadRR8Bit<rD, rC>, 4},
+    {0x52, LoadRR8Bit<rD, rD>, 4},
+    {0x53, LoadRR8Bit<rD, rE>, 4},
+    {0x54, LoadRR8Bit<rD, rH>, 4},
+    {0x55, LoadRR8Bit<rD, rL>, 4},
+    {0x58, LoadRR8Bit<rE, rB>, 4},
+    {0x59, LoadRR8Bit<rE, rC>, 4},
+    {0x5a, LoadRR8Bit<rE, rD>, 4},
+    {0x5b, LoadRR8Bit<rE, rE>, 4},
+    {0x5c, LoadRR8Bit<rE, rH>, 4},
+    {0x5d, LoadRR8Bit<rE, rL>, 4},
+    {0x60, LoadRR8Bit<rH, rB>, 4},
+    {0x61, LoadRR8Bit<rH, rC>, 4},
+    {0x62, LoadRR8Bit<rH, rD>, 4},
+    {0x63, LoadRR8Bit<rH, rE>, 4},
+    {0x64, LoadRR8Bit<rH, rH>, 4},
+    {0x65, LoadRR8Bit<rH, rL>, 4},
+    {0x68, LoadRR8Bit<rL, rB>, 4},
+    {0x69, LoadRR8Bit<rL, rC>, 4},
+    {0x6a, LoadRR8Bit<rL, rD>, 4},
+    {0x6b, LoadRR8Bit<rL, rE>, 4},
+    {0x6c, LoadRR8Bit<rL, rH>, 4},
+    {0x6d, LoadRR8Bit<rL, rL>, 4},
+    {0x7e, LoadRR8BitAddress<rA>, 8},
+    {0x46, LoadRR8BitAddress<rB>, 8},
+    {0x4e, LoadRR8BitAddress<rC>, 8},
+    {0x56, LoadRR8BitAddress<rD>, 8},
+    {0x5e, LoadRR8BitAddress<rE>, 8},
+    {0x66, LoadRR8BitAddress<rH>, 8},
+    {0x6e, LoadRR8BitAddress<rL>, 8},
+    {0x70, LoadRR8BitIntoAddress<rB>, 8},
+    {0x71, LoadRR8BitIntoAddress<rC>, 8},
+    {0x72, LoadRR8BitIntoAddress<rD>, 8},
+    {0x73, LoadRR8BitIntoAddress<rE>, 8},
+    {0x74, LoadRR8BitIntoAddress<rH>, 8},
+    {0x75, LoadRR8BitIntoAddress<rL>, 8},
+    {0x36, Load8BitLiteral, 12},
+    {0x0A, LoadAN<rBC>, 8},
+    {0x1A, LoadAN<rDE>, 8},
+    {0xFA, LoadAN16BitLiteral, 16},
+    {0x3E, LoadAN8BitLiteral, 8},
+    {0x47, LoadNA<rB>, 4},
+    {0x4F, LoadNA<rC>, 4},
+    {0x57, LoadNA<rD>, 4},
+    {0x5F, LoadNA<rE>, 4},
+    {0x67, LoadNA<rH>, 4},
+    {0x6F, LoadNA<rL>, 4},
+    {0x02, LoadNAAddress<rBC>, 8},
+    {0x12, LoadNAAddress<rDE>, 8},
+    {0x77, LoadNAAddress<rHL>, 8},
+    {0xEA, LoadNA16BitLiteral, 8},
+    {0xF2, LoadAC, 8},
+    {0xE2, LoadCA, 8},
+    {0x3A, LoadDecAHL, 8},
+    {0x32, LoadDecHLA, 8},
+    {0x2A, LoadIncAHL, 8},
+    {0x22, LoadIncHLA, 8},
+    {0xE0, LoadHNA, 12},
+    {0xF0, LoadHAN, 12},
+    {0x01, LoadNN<rBC>, 12},
+    {0x11, LoadNN<rDE>, 12},
+    {0x21, LoadNN<rHL>, 12},
+    {0x31, LoadNN<rSP>, 12},
+    {0xF9, LoadSPHL, 8},
+    {0xF8, LoadHLSP, 12},
+    {0x08, LoadNNSP, 20},
+    {0xF5, Push<rAF>, 16},
+    {0xC5, Push<rBC>, 16},
+    {0xD5, Push<rDE>, 16},
+    {0xE5, Push<rHL>, 16},
+    {0xF1, Pop<rAF>, 12},
+    {0xC1, Pop<rBC>, 12},
+    {0xD1, Pop<rDE>, 12},
+    {0xE1, Pop<rHL>, 12},
+    {0x87, Add8Bit<rA>, 4},
+    {0x80, Add8Bit<rB>, 4},
+    {0x81, Add8Bit<rC>, 4},
+    {0x82, Add8Bit<rD>, 4},
+    {0x83, Add8Bit<rE>, 4},
+    {0x84, Add8Bit<rH>, 4},
+    {0x85, Add8Bit<rL>, 4},
+    {0x86, Add8BitAddress, 8},
+    {0xC6, Add8BitLiteral, 8},
+    {0x8F, ADC8Bit<rA>, 4},
+    {0x88, ADC8Bit<rB>, 4},
+    {0x89, ADC8Bit<rC>, 4},
+    {0x8A, ADC8Bit<rD>, 4},
+    {0x8B, ADC8Bit<rE>, 4},
+    {0x8C, ADC8Bit<rH>, 4},
+    {0x8D, ADC8Bit<rL>, 4},
+    {0x8E, ADC8BitAddress, 8},
+    {0xCE, ADC8BitLiteral, 8},
+    {0x97, Sub8Bit<rA>, 4},
+    {0x90, Sub8Bit<rB>, 4},
+    {0x91, Sub8Bit<rC>, 4},
+    {0x92, Sub8Bit<rD>, 4},
+    {0x93, Sub8Bit<rE>, 4},
+    {0x94, Sub8Bit<rH>, 4},
+    {0x95, Sub8Bit<rL>, 4},
+    {0x96, Sub8BitAddress, 8},
+    {0xD6, Sub8BitLiteral, 8},
+    {0x9F, SBC8Bit<rA>, 4},
+    {0x98, SBC8Bit<rB>, 4},
+    {0x99, SBC8Bit<rC>, 4},
+    {0x9A, SBC8Bit<rD>, 4},
+    {0x9B, SBC8Bit<rE>, 4},
+    {0x9C, SBC8Bit<rH>, 4},
+    {0x9D, SBC8Bit<rL>, 4},
+    {0x9E, SBC8BitAddress, 8},
+    {0xDE, SBC8BitLiteral, 8},
+    {0xA7, And8Bit<rA>, 4},
+    {0xA0, And8Bit<rB>, 4},
+    {0xA1, And8Bit<rC>, 4},
+    {0xA2, And8Bit<rD>, 4},
+    {0xA3, And8Bit<rE>, 4},
+    {0xA4, And8Bit<rH>, 4},
+    {0xA5, And8Bit<rL>, 4},
+    {0xA6, And8BitAddress, 8},
+    {0xE6, And8BitLiteral, 8},
+    {0xB7, Or8Bit<rA>, 4},
+    {0xB0, Or8Bit<rB>, 4},
+    {0xB1, Or8Bit<rC>, 4},
+    {0xB2, Or8Bit<rD>, 4},
+    {0xB3, Or8Bit<rE>, 4},
+    {0xB4, Or8Bit<rH>, 4},
+    {0xB5, Or8Bit<rL>, 4},
+    {0xB6, Or8BitAddress, 8},
+    {0xF6, Or8BitLiteral, 8},
+    {0xAF, Xor8Bit<rA>, 4},
+    {0xA8, Xor8Bit<rB>, 4},
+    {0xA9, Xor8Bit<rC>, 4},
+    {0xAA, Xor8Bit<rD>, 4},
+    {0xAB, Xor8Bit<rE>, 4},
+    {0xAC, Xor8Bit<rH>, 4},
+    {0xAD, Xor8Bit<rL>, 4},
+    {0xAE, Xor8BitAddress, 8},
+    {0xEE, Xor8BitLiteral, 8},
+    {0xBF, Cp8Bit<rA>, 4},
+    {0xB8, Cp8Bit<rB>, 4},
+    {0xB9, Cp8Bit<rC>, 4},
+    {0xBA, Cp8Bit<rD>, 4},
+    {0xBB, Cp8Bit<rE>, 4},
+    {0xBC, Cp8Bit<rH>, 4},
+    {0xBD, Cp8Bit<rL>, 4},
+    {0xBE, Cp8BitAddress, 8},
+    {0xFE, Cp8BitLiteral, 8},
+    {0x3C, Inc8Bit<rA>, 4},
+    {0x04, Inc8Bit<rB>, 4},
+    {0x0C, Inc8Bit<rC>, 4},
+    {0x14, Inc8Bit<rD>, 4},
+    {0x1C, Inc8Bit<rE>, 4},
+    {0x24, Inc8Bit<rH>, 4},
+    {0x2C, Inc8Bit<rL>, 4},
+    {0x34, Inc8BitAddress, 12},
+    {0x3D, Dec8Bit<rA>, 4},
+    {0x05, Dec8Bit<rB>, 4},
+    {0x0D, Dec8Bit<rC>, 4},
+    {0x15, Dec8Bit<rD>, 4},
+    {0x1D, Dec8Bit<rE>, 4},
+    {0x25, Dec8Bit<rH>, 4},
+    {0x2D, Dec8Bit<rL>, 4},
+    {0x35, Dec8BitAddress, 12},
+    {0x09, Add16Bit<rBC>, 8},
+    {0x19, Add16Bit<rDE>, 8},
+    {0x29, Add16Bit<rHL>, 8},
+    {0x39, Add16Bit<rSP>, 8},
+    {0xE8, AddSPLiteral, 16},
+    {0x03, Inc16Bit<rBC>, 8},
+    {0x13, Inc16Bit<rDE>, 8},
+    {0x23, Inc16Bit<rHL>, 8},
+    {0x33, Inc16Bit<rSP>, 8},
+    {0x0B, Dec16Bit<rBC>, 8},
+    {0x1B, Dec16Bit<rDE>, 8},
+    {0x2B, Dec16Bit<rHL>, 8},
+    {0x3B, Dec16Bit<rSP>, 8},
+    {0xCB37, Swap<rA>, 8},
+    {0xCB30, Swap<rB>, 8},
+    {0xCB31, Swap<rC>, 8},
+    {0xCB32, Swap<rD>, 8},
+    {0xCB33, Swap<rE>, 8},
+    {0xCB34, Swap<rH>, 8},
+    {0xCB35, Swap<rL>, 8},
+    {0xCB36, SwapAddress, 16},
+    {0x27, DAA, 4},
+    {0x2F, CPL, 4},
+    {0x3F, CCF, 4},
+    {0x37, SCF, 4},
+    {0x00, NOP, 4},
+    {0x76, Halt, 4},
+    {0x1000, Stop, 4},
+    {0xF3, DI, 4},
+    {0xFB, EI, 4},
+    {0x07, RLCA, 4},
+    {0x17, RLA, 4},
+    {0x0F, RRCA, 4},
+    {0x1F, RRA, 4},
+    {0xCB07, RLC<rA>, 8},
+    {0xCB00, RLC<rB>, 8},
+    {0xCB01, RLC<rC>, 8},
+    {0xCB02, RLC<rD>, 8},
+    {0xCB03, RLC<rE>, 8},
+    {0xCB04, RLC<rH>, 8},
+    {0xCB05, RLC<rL>, 8},
+    {0xCB06, RLCAddress, 16},
+    {0xCB17, RL<rA>, 8},
+    {0xCB10, RL<rB>, 8},
+    {0xCB11, RL<rC>, 8},
+    {0xCB12, RL<rD>, 8},
+    {0xCB13, RL<rE>, 8},
+    {0xCB14, RL<rH>, 8},
+    {0xCB15, RL<rL>, 8},
+    {0xCB16, RLAddress, 16},
+    {0xCB0F, RRC<rA>, 8},
+    {0xCB08, RRC<rB>, 8},
+    {0xCB09, RRC<rC>, 8},
+    {0xCB0A, RRC<rD>, 8},
+    {0xCB0B, RRC<rE>, 8},
+    {0xCB0C, RRC<rH>, 8},
+    {0xCB0D, RRC<rL>, 8},
+    {0xCB0E, RRCAddress, 16},
+    {0xCB1F, RR<rA>, 8},
+    {0xCB18, RR<rB>, 8},
+    {0xCB19, RR<rC>, 8},
+    {0xCB1A, RR<rD>, 8},
+    {0xCB1B, RR<rE>, 8},
+    {0xCB1C, RR<rH>, 8},
+    {0xCB1D, RR<rL>, 8},
+    {0xCB1E, RRAddress, 16},
+    {0xCB27, SLA<rA>, 8},
+    {0xCB20, SLA<rB>, 8},
+    {0xCB21, SLA<rC>, 8},
+    {0xCB22, SLA<rD>, 8},
+    {0xCB23, SLA<rE>, 8},
+    {0xCB24, SLA<rH>, 8},
+    {0xCB25, SLA<rL>, 8},
+    {0xCB26, SLAAddress, 16},
+    {0xCB2F, SRA<rA>, 8},
+    {0xCB28, SRA<rB>, 8},
+    {0xCB29, SRA<rC>, 8},
+    {0xCB2A, SRA<rD>, 8},
+    {0xCB2B, SRA<rE>, 8},
+    {0xCB2C, SRA<rH>, 8},
+    {0xCB2D, SRA<rL>, 8},
+    {0xCB2E, SRAAddress, 16},
+    {0xCB3F, SRL<rA>, 8},
+    {0xCB38, SRL<rB>, 8},
+    {0xCB39, SRL<rC>, 8},
+    {0xCB3A, SRL<rD>, 8},
+    {0xCB3B, SRL<rE>, 8},
+    {0xCB3C, SRL<rH>, 8},
+    {0xCB3D, SRL<rL>, 8},
+    {0xCB3E, SRLAddress, 16},
+    {0xCB47, Bit<rA>, 8},
+    {0xCB40, Bit<rB>, 8},
+    {0xCB41, Bit<rC>, 8},
+    {0xCB42, Bit<rD>, 8},
+    {0xCB43, Bit<rE>, 8},
+    {0xCB44, Bit<rH>, 8},
+    {0xCB45, Bit<rL>, 8},
+    {0xCB46, BitAddress, 16},
+    {0xCBC7, Set<rA>, 8},
+    {0xCBC0, Set<rB>, 8},
+    {0xCBC1, Set<rC>, 8},
+    {0xCBC2, Set<rD>, 8},
+    {0xCBC3, Set<rE>, 8},
+    {0xCBC4, Set<rH>, 8},
+    {0xCBC5, Set<rL>, 8},
+    {0xCBC6, SetAddress, 16},
+    {0xCB87, Res<rA>, 8},
+    {0xCB80, Res<rB>, 8},
+    {0xCB81, Res<rC>, 8},
+    {0xCB82, Res<rD>, 8},
+    {0xCB83, Res<rE>, 8},
+    {0xCB84, Res<rH>, 8},
+    {0xCB85, Res<rL>, 8},
+    {0xCB86, ResAddress, 16},
+    {0xC3, Jump, 12},
+    {0xC2, JumpConditional<NOT_ZERO>, 12},
+    {0xCA, JumpConditional<ZERO>, 12},
+    {0xD2, JumpConditional<NOT_CARRY>, 12},
+    {0xDA, JumpConditional<CARRY>, 12},
+    {0xE9, JumpHL, 4},
+    {0x18, JumpRelative, 8},
+    {0x20, JumpRelativeConditional<NOT_ZERO>, 8},
+    {0x28, JumpRelativeConditional<ZERO>, 8},
+    {0x30, JumpRelativeConditional<NOT_CARRY>, 8},
+    {0x38, JumpRelativeConditional<CARRY>, 8},
+    {0xCD, Call, 12},
+    {0xC4, CallConditional<NOT_ZERO>, 12},
+    {0xCC, CallConditional<ZERO>, 12},
+    {0xD4, CallConditional<NOT_CARRY>, 12},
+    {0xDC, CallConditional<CARRY>, 12},
+    {0xC7, Restart<0x00>, 32},
+    {0xCF, Restart<0x08>, 32},
+    {0xD7, Restart<0x10>, 32},
+    {0xDF, Restart<0x18>, 32},
+    {0xE7, Restart<0x20>, 32},
+    {0xEF, Restart<0x28>, 32},
+    {0xF7, Restart<0x30>, 32},
+    {0xFF, Restart<0x38>, 32},
+    {0xC9, Return, 8},
+    {0xC0, ReturnConditional<NOT_ZERO>, 8},
+    {0xC8, ReturnConditional<ZERO>, 8},
+    {0xD0, ReturnConditional<NOT_CARRY>, 8},
+    {0xD8, ReturnConditional<CARRY>, 8},
+    {0xD9, ReturnInterrupt, 8},
+    // XXX: This should be removed before distribution!!!
+    {0xDD, HaltAndCatchFire, 8},
+  };
 
-map<unsigned short, Opcode> CreateOpcodeMap(GB_CPU* cpu) {
-  unsigned short* rA = (unsigned short*) &cpu->flag_struct.rA;
-  unsigned short* rB = (unsigned short*) &cpu->bc_struct.rB;
-  unsigned short* rC = (unsigned short*) &cpu->bc_struct.rC;
-  unsigned short* rD = (unsigned short*) &cpu->de_struct.rD;
-  unsigned short* rE = (unsigned short*) &cpu->de_struct.rE;
-  unsigned short* rH = (unsigned short*) &cpu->hl_struct.rH;
-  unsigned short* rL = (unsigned short*) &cpu->hl_struct.rL;
-  unsigned short* rAF = &cpu->rAF;
-  unsigned short* rBC = &cpu->rBC;
-  unsigned short* rDE = &cpu->rDE;
-  unsigned short* rHL = &cpu->rHL;
-  unsigned short* rSP = &cpu->rSP;
+  return ToMap(opcodes);
+}
 
-const vector<vector<Opcode>> opcodes = {
-    ToList1({{0x06, rB, 8},
-            {0x0e, rC, 8},
-            {0x16, rD, 8},
-            {0x1e, rE, 8},
-            {0x26, rH, 8},
-            {0x2e, rL, 8}}, LoadN),
-    ToList2({{0x7f, rA, rA, 4},
-            {0x78, rA, rB, 4},
-            {0x79, rA, rC, 4},
-            {0x7a, rA, rD, 4},
-            {0x7b, rA, rE, 4},
-            {0x7c, rA, rH, 4},
-            {0x7d, rA, rL, 4},
-            {0x40, rB, rB, 4},
-            {0x41, rB, rC, 4},
-            {0x42, rB, rD, 4},
-            {0x43, rB, rE, 4},
-            {0x44, rB, rH, 4},
-            {0x45, rB, rL, 4},
-            {0x48, rC, rB, 4},
-            {0x49, rC, rC, 4},
-            {0x4a, rC, rD, 4},
-            {0x4b, rC, rE, 4},
-            {0x4c, rC, rH, 4},
-            {0x4d, rC, rL, 4},
-            {0x50, rD, rB, 4},
-            {0x51, rD, rC, 4},
-            {0x52, rD, rD, 4},
-            {0x53, rD, rE, 4},
-            {0x54, rD, rH, 4},
-            {0x55, rD, rL, 4},
-            {0x58, rE, rB, 4},
-            {0x59, rE, rC, 4},
-            {0x5a, rE, rD, 4},
-            {0x5b, rE, rE, 4},
-            {0x5c, rE, rH, 4},
-            {0x5d, rE, rL, 4},
-            {0x60, rH, rB, 4},
-            {0x61, rH, rC, 4},
-            {0x62, rH, rD, 4},
-            {0x63, rH, rE, 4},
-            {0x64, rH, rH, 4},
-            {0x65, rH, rL, 4},
-            {0x68, rL, rB, 4},
-            {0x69, rL, rC, 4},
-            {0x6a, rL, rD, 4},
-            {0x6b, rL, rE, 4},
-            {0x6c, rL, rH, 4},
-            {0x6d, rL, rL, 4}}, LoadRR8Bit),
-    ToList2({{0x7e, rA, rHL, 8},
-            {0x46, rB, rHL, 8},
-            {0x4e, rC, rHL, 8},
-            {0x56, rD, rHL, 8},
-            {0x5e, rE, rHL, 8},
-            {0x66, rH, rHL, 8},
-            {0x6e, rL, rHL, 8}}, LoadRR8BitAddress),
-    ToList2({{0x70, rHL, rB, 8},
-            {0x71, rHL, rC, 8},
-            {0x72, rHL, rD, 8},
-            {0x73, rHL, rE, 8},
-            {0x74, rHL, rH, 8},
-            {0x75, rHL, rL, 8}}, LoadRR8BitIntoAddress),
-    ToList1({{0x36, rHL, 12}}, Load8BitLiteral),
-    ToList1({{0x0A, rBC, 8},
-            {0x1A, rDE, 8}}, LoadAN),
-    ToList1({{0xFA, nullptr, 16}}, LoadAN16BitLiteral),
-    ToList1({{0x3E, nullptr, 8}}, LoadAN8BitLiteral),
-    ToList1({{0x47, rB, 4},
-            {0x4F, rC, 4},
-            {0x57, rD, 4},
-            {0x5F, rE, 4},
-            {0x67, rH, 4},
-            {0x6F, rL, 4}}, LoadNA),
-    ToList1({{0x02, rBC, 8},
-            {0x12, rDE, 8},
-            {0x77, rHL, 8}}, LoadNAAddress),
-    ToList1({{0xEA, nullptr, 8}}, LoadNA16BitLiteral),
-    ToList1({{0xF2, nullptr, 8}}, LoadAC),
-    ToList1({{0xE2, nullptr, 8}}, LoadCA),
-    ToList1({{0x3A, rHL, 8}}, LoadDecAHL),
-    ToList1({{0x32, rHL, 8}}, LoadDecHLA),
-    ToList1({{0x2A, rHL, 8}}, LoadIncAHL),
-    ToList1({{0x22, rHL, 8}}, LoadIncHLA),
-    ToList1({{0xE0, nullptr, 12}}, LoadHNA),
-    ToList1({{0xF0, nullptr, 12}}, LoadHAN),
-    ToList1({{0x01, rBC, 12},
-            {0x11, rDE, 12},
-            {0x21, rHL, 12},
-            {0x31, rSP, 12}}, LoadNN),
-    ToList1({{0xF9, nullptr, 8}}, LoadSPHL),
-    ToList1({{0xF8, nullptr, 12}}, LoadHLSP),
-    ToList1({{0x08, nullptr, 20}}, LoadNNSP),
-    ToList1({{0xF5, rAF, 16},
-            {0xC5, rBC, 16},
-            {0xD5, rDE, 16},
-            {0xE5, rHL, 16}}, Push),
-    ToList1({{0xF1, rAF, 12},
-            {0xC1, rBC, 12},
-            {0xD1, rDE, 12},
-            {0xE1, rHL, 12}}, Pop),
-    ToList1({{0x87, rA, 4},
-            {0x80, rB, 4},
-            {0x81, rC, 4},
-            {0x82, rD, 4},
-            {0x83, rE, 4},
-            {0x84, rH, 4},
-            {0x85, rL, 4}}, Add8Bit),
-    ToList1({{0x86, rHL, 8}}, Add8BitAddress),
-    ToList1({{0xC6, nullptr, 8}}, Add8BitLiteral),
-    ToList1({{0x8F, rA, 4},
-            {0x88, rB, 4},
-            {0x89, rC, 4},
-            {0x8A, rD, 4},
-            {0x8B, rE, 4},
-            {0x8C, rH, 4},
-            {0x8D, rL, 4}}, ADC8Bit),
-    ToList1({{0x8E, rHL, 8}}, ADC8BitAddress),
-    ToList1({{0xCE, nullptr, 8}}, ADC8BitLiteral),
-    ToList1({{0x97, rA, 4},
-            {0x90, rB, 4},
-            {0x91, rC, 4},
-            {0x92, rD, 4},
-            {0x93, rE, 4},
-            {0x94, rH, 4},
-            {0x95, rL, 4}}, Sub8Bit),
-    ToList1({{0x96, rHL, 8}}, Sub8BitAddress),
-    ToList1({{0xD6, nullptr, 8}}, Sub8BitLiteral),
-    ToList1({{0x9F, rA, 4},
-            {0x98, rB, 4},
-            {0x99, rC, 4},
-            {0x9A, rD, 4},
-            {0x9B, rE, 4},
-            {0x9C, rH, 4},
-            {0x9D, rL, 4}}, SBC8Bit),
-    ToList1({{0x9E, rHL, 8}}, SBC8BitAddress),
-    ToList1({{0xDE, nullptr, 8}}, SBC8BitLiteral),
-    ToList1({{0xA7, rA, 4},
-            {0xA0, rB, 4},
-            {0xA1, rC, 4},
-            {0xA2, rD, 4},
-            {0xA3, rE, 4},
-            {0xA4, rH, 4},
-            {0xA5, rL, 4}}, And8Bit),
-    ToList1({{0xA6, rHL, 8}}, And8BitAddress),
-    ToList1({{0xE6, nullptr, 8}}, And8BitLiteral),
-    ToList1({{0xB7, rA, 4},
-            {0xB0, rB, 4},
-            {0xB1, rC, 4},
-            {0xB2, rD, 4},
-            {0xB3, rE, 4},
-            {0xB4, rH, 4},
-            {0xB5, rL, 4}}, Or8Bit),
-    ToList1({{0xB6, rHL, 8}}, Or8BitAddress),
-    ToList1({{0xF6, nullptr, 8}}, Or8BitLiteral),
-    ToList1({{0xAF, rA, 4},
-            {0xA8, rB, 4},
-            {0xA9, rC, 4},
-            {0xAA, rD, 4},
-            {0xAB, rE, 4},
-            {0xAC, rH, 4},
-            {0xAD, rL, 4}}, Xor8Bit),
-    ToList1({{0xAE, rHL, 8}}, Xor8BitAddress),
-    ToList1({{0xEE, nullptr, 8}}, Xor8BitLiteral),
-    ToList1({{0xBF, rA, 4},
-            {0xB8, rB, 4},
-            {0xB9, rC, 4},
-            {0xBA, rD, 4},
-            {0xBB, rE, 4},
-            {0xBC, rH, 4},
-            {0xBD, rL, 4}}, Cp8Bit),
-    ToList1({{0xBE, rHL, 8}}, Cp8BitAddress),
-    ToList1({{0xFE, nullptr, 8}}, Cp8BitLiteral),
-    ToList1({{0x3C, rA, 4},
-            {0x04, rB, 4},
-            {0x0C, rC, 4},
-            {0x14, rD, 4},
-            {0x1C, rE, 4},
-            {0x24, rH, 4},
-            {0x2C, rL, 4}}, Inc8Bit),
-    ToList1({{0x34, rHL, 12}}, Inc8BitAddress),
-    ToList1({{0x3D, rA, 4},
-            {0x05, rB, 4},
-            {0x0D, rC, 4},
-            {0x15, rD, 4},
-            {0x1D, rE, 4},
-            {0x25, rH, 4},
-            {0x2D, rL, 4}}, Dec8Bit),
-    ToList1({{0x35, rHL, 12}}, Dec8BitAddress),
-    ToList1({{0x09, rBC, 8},
-            {0x19, rDE, 8},
-            {0x29, rHL, 8},
-            {0x39, rSP, 8}}, Add16Bit),
-    ToList1({{0xE8, nullptr, 16}}, AddSPLiteral),
-    ToList1({{0x03, rBC, 8},
-            {0x13, rDE, 8},
-            {0x23, rHL, 8},
-            {0x33, rSP, 8}}, Inc16Bit),
-    ToList1({{0x0B, rBC, 8},
-            {0x1B, rDE, 8},
-            {0x2B, rHL, 8},
-            {0x3B, rSP, 8}}, Dec16Bit),
-    ToList1({{0xCB37, rA, 8},
-            {0xCB30, rB, 8},
-            {0xCB31, rC, 8},
-            {0xCB32, rD, 8},
-            {0xCB33, rE, 8},
-            {0xCB34, rH, 8},
-            {0xCB35, rL, 8}}, Swap),
-    ToList1({{0xCB36, rHL, 16}}, SwapAddress),
-    ToList1({{0x27, nullptr, 4}}, DAA),
-    ToList1({{0x2F, nullptr, 4}}, CPL),
-    ToList1({{0x3F, nullptr, 4}}, CCF),
-    ToList1({{0x37, nullptr, 4}}, SCF),
-    ToList1({{0x00, nullptr, 4}}, NOP),
-    ToList1({{0x76, nullptr, 4}}, Halt),
-    ToList1({{0x1000, nullptr, 4}}, Stop),
-    ToList1({{0xF3, nullptr, 4}}, DI),
-    ToList1({{0xFB, nullptr, 4}}, EI),
-    ToList1({{0x07, nullptr, 4}}, RLCA),
-    ToList1({{0x17, nullptr, 4}}, RLA),
-    ToList1({{0x0F, nullptr, 4}}, RRCA),
-    ToList1({{0x1F, nullptr, 4}}, RRA),
-    ToList1({{0xCB07, rA, 8},
-            {0xCB00, rB, 8},
-            {0xCB01, rC, 8},
-            {0xCB02, rD, 8},
-            {0xCB03, rE, 8},
-            {0xCB04, rH, 8},
-            {0xCB05, rL, 8}}, RLC),
-    ToList1({{0xCB06, rHL, 16}}, RLCAddress),
-    ToList1({{0xCB17, rA, 8},
-            {0xCB10, rB, 8},
-            {0xCB11, rC, 8},
-            {0xCB12, rD, 8},
-            {0xCB13, rE, 8},
-            {0xCB14, rH, 8},
-            {0xCB15, rL, 8}}, RL),
-    ToList1({{0xCB16, rHL, 16}}, RLAddress),
-    ToList1({{0xCB0F, rA, 8},
-            {0xCB08, rB, 8},
-            {0xCB09, rC, 8},
-            {0xCB0A, rD, 8},
-            {0xCB0B, rE, 8},
-            {0xCB0C, rH, 8},
-            {0xCB0D, rL, 8}}, RRC),
-    ToList1({{0xCB0E, rHL, 16}}, RRCAddress),
-    ToList1({{0xCB1F, rA, 8},
-            {0xCB18, rB, 8},
-            {0xCB19, rC, 8},
-            {0xCB1A, rD, 8},
-            {0xCB1B, rE, 8},
-            {0xCB1C, rH, 8},
-            {0xCB1D, rL, 8}}, RR),
-    ToList1({{0xCB1E, rHL, 16}}, RRAddress),
-    ToList1({{0xCB27, rA, 8},
-            {0xCB20, rB, 8},
-            {0xCB21, rC, 8},
-            {0xCB22, rD, 8},
-            {0xCB23, rE, 8},
-            {0xCB24, rH, 8},
-            {0xCB25, rL, 8}}, SLA),
-    ToList1({{0xCB26, rHL, 16}}, SLAAddress),
-    ToList1({{0xCB2F, rA, 8},
-            {0xCB28, rB, 8},
-            {0xCB29, rC, 8},
-            {0xCB2A, rD, 8},
-            {0xCB2B, rE, 8},
-            {0xCB2C, rH, 8},
-            {0xCB2D, rL, 8}}, SRA),
-    ToList1({{0xCB2E, rHL, 16}}, SRAAddress),
-    ToList1({{0xCB3F, rA, 8},
-            {0xCB38, rB, 8},
-            {0xCB39, rC, 8},
-            {0xCB3A, rD, 8},
-            {0xCB3B, rE, 8},
-            {0xCB3C, rH, 8},
-            {0xCB3D, rL, 8}}, SRL),
-    ToList1({{0xCB3E, rHL, 16}}, SRLAddress),
-    ToList1({{0xCB47, rA, 8},
-            {0xCB40, rB, 8},
-            {0xCB41, rC, 8},
-            {0xCB42, rD, 8},
-            {0xCB43, rE, 8},
-            {0xCB44, rH, 8},
-            {0xCB45, rL, 8}}, Bit),
-    ToList1({{0xCB46, rHL, 16}}, BitAddress),
-    ToList1({{0xCBC7, rA, 8},
-            {0xCBC0, rB, 8},
-            {0xCBC1, rC, 8},
-            {0xCBC2, rD, 8},
-            {0xCBC3, rE, 8},
-            {0xCBC4, rH, 8},
-            {0xCBC5, rL, 8},
-            {0xCBC6, rHL, 16}}, Set),
-    ToList1({{0xCB87, rA, 8},
-            {0xCB80, rB, 8},
-            {0xCB81, rC, 8},
-            {0xCB82, rD, 8},
-            {0xCB83, rE, 8},
-            {0xCB84, rH, 8},
-            {0xCB85, rL, 8},
-            {0xCB86, rHL, 16}}, Res),
-    ToList1({{0xC3, nullptr, 12}}, Jump),
-    /* TODO: pass in the proper register to JP cc,nn */
-    ToList1({{0xC2, nullptr, 12},
-            {0xCA, nullptr, 12},
-            {0xD2, nullptr, 12},
-            {0xDA, nullptr, 12}}, JumpConditional),
-    ToList1({{0xE9, rHL, 4}}, JumpHL),
-    ToList1({{0x18, nullptr, 8}}, JumpRelative),
-    /* TODO: pass in the proper register to JR cc,nn */
-    ToList1({{0x20, nullptr, 8},
-            {0x28, nullptr, 8},
-            {0x30, nullptr, 8},
-            {0x38, nullptr, 8}}, JumpRelativeConditional),
-    ToList1({{0xCD, nullptr, 12}}, Call),
-    /* TODO: pass in the proper register to CALL cc,nn */
-    ToList1({{0xC4, nullptr, 12},
-            {0xCC, nullptr, 12},
-            {0xD4, nullptr, 12},
-            {0xDC, nullptr, 12}}, CallConditional),
-    ToList1({{0xC7, nullptr, 32},
-            {0xCF, nullptr, 32},
-            {0xD7, nullptr, 32},
-            {0xDF, nullptr, 32},
-            {0xE7, nullptr, 32},
-            {0xEF, nullptr, 32},
-            {0xF7, nullptr, 32},
-            {0xFF, nullptr, 32}}, Restart),
-    ToList1({{0xC9, nullptr, 8}}, Return),
-    /* TODO: pass in the proper register to RET cc */
-    ToList1({{0xC0, nullptr, 8},
-            {0xC8, nullptr, 8},
-            {0xD0, nullptr, 8},
-            {0xD8, nullptr, 8}}, ReturnConditional),
-    ToList1({{0xD9, nullptr, 8}}, ReturnInterrupt),
-    // XXX: This should be removed before distribution!!!
-    ToList1({{0xDD, nullptr, 8}}, HaltAndCatchFire)
-};
+namespace {
+OpcodeTable* CreateOpcodeTable() {
+  OpcodeTable* table = new OpcodeTable();
+  for (const auto& entry : CreateOpcodeMap()) {
+    unsigned short opcode_name = entry.first;
+    unsigned char lower = opcode_name & 0x00ff;
+    if (opcode_name == 0x1000) {
+      table->stop = entry.second;
+    } else if ((opcode_name >> 8) == 0xCB && (lower & 0b11000000) > 0) {
+      // BIT, SET and RES encode the bit index in bits 3 through 5.
+      for (int bit = 0; bit < 8; bit++) {
+        table->cb_prefixed[lower | (bit << 3)] = entry.second;
+      }
+    } else if ((opcode_name >> 8) == 0xCB) {
+      table->cb_prefixed[lower] = entry.second;
+    } else {
+      table->primary[lower] = entry.second;
+    }
+  }
+  return table;
+}
+} // namespace
 
-  return ToMap(Flatten(opcodes));
+const OpcodeTable& GetOpcodeTable() {
+  // Never deallocated; it is shared by every executor for the life of the
+  // process.
+  static const OpcodeTable* table = CreateOpcodeTable();
+  return *table;
 }
 
 } // namespace opcodes
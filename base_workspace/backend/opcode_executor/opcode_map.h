@@ -11,22 +11,22 @@
 namespace back_end {
 namespace opcodes {
 
-extern unsigned char* rA; 
-extern unsigned char* rB; 
-extern unsigned char* rC; 
-extern unsigned char* rD; 
-extern unsigned char* rE; 
-extern unsigned char* rF; 
-extern unsigned char* rH; 
-extern unsigned char* rL; 
-extern unsigned char* rAF;
-extern unsigned char* rBC;
-extern unsigned char* rDE;
-extern unsigned char* rHL;
-extern unsigned char* rPC;
-extern unsigned char* rSP;
+std::map<unsigned short, Opcode> CreateOpcodeMap();
 
-std::map<unsigned short, Opcode> CreateOpcodeMap(registers::GB_CPU* cpu);
+// Dense dispatch tables indexed directly by the fetched opcode byte. An entry
+// with a null handler is an opcode that does not exist. BIT, SET and RES are
+// duplicated across every bit index so the CB table can be indexed by the raw
+// byte following the 0xCB prefix.
+//
+// The tables are built once and shared by every OpcodeExecutor; handlers take
+// the CPU from their ExecutorContext, so entries need no per-instance fixup.
+struct OpcodeTable {
+  Opcode primary[256];
+  Opcode cb_prefixed[256];
+  Opcode stop;
+};
+
+const OpcodeTable& GetOpcodeTable();
 
 } // namespace opcodes
 } // namespace back_end
@@ -0,0 +1,145 @@
+#include "backend/opcode_executor/opcode_executor.h"
+
+// Recognizes loops that wait for something outside the CPU to change, e.g.
+//
+//   wait: LDH A,(0x44) ; LY
+//         CP 0x90
+//         JR NZ,wait
+//
+// Once such a loop has been round once, every time after does exactly the same
+// until one of the values it reads changes, so the Clocktroller can move the
+// clock on to that point instead of running it. That only holds if the loop
+// writes no memory, reads only memory that changes at a scheduled event, is a
+// straight line back to its top, and any register it reads before it writes is
+// one it never writes, so that the first time around leaves it as it will stay.
+
+namespace back_end {
+namespace handlers {
+
+namespace {
+const int kMaxPollingLoopInstructions = 8;
+
+// The registers a polling loop may change, for following what it reads first.
+const int kRegisterA = 1 << 0;
+const int kFlagZ = 1 << 1;
+const int kFlagC = 1 << 2;
+
+// Everything but the IO ports only changes when the CPU writes it, and the
+// CPU only leaves the loop for an interrupt, which only a scheduled event
+// requests. Of the IO ports, only IF, STAT and LY are known to change at
+// nothing else; the joypad, for one, changes whenever it likes.
+bool IsPollable(unsigned short address) {
+  return address < 0xff00 || address >= 0xff80 ||
+      address == 0xff0f || address == 0xff41 || address == 0xff44;
+}
+} // namespace
+
+int OpcodeExecutor::PollingLoopCycles() {
+  const unsigned short head = cpu_.rPC;
+  unsigned short address = head;
+  int cycles = 0;
+  int written = 0;
+  int read_first = 0;
+  for (int i = 0; i < kMaxPollingLoopInstructions; i++) {
+    DecodedInstruction decoded = Decode(address);
+    if (decoded.opcode == nullptr) {
+      return 0;
+    }
+    unsigned short operand = address + decoded.length;
+    unsigned short next = operand;
+    int reads = 0;
+    int writes = 0;
+    bool polls = false;
+    unsigned short polled = 0;
+    bool branches = false;
+    unsigned short target = 0;
+    switch (decoded.opcode_name) {
+      case 0xf0: // LDH A,(n)
+        polls = true;
+        polled = 0xff00 | memory_mapper_->Read(operand);
+        writes = kRegisterA;
+        next += 1;
+        break;
+      case 0xfa: // LD A,(nn)
+        polls = true;
+        polled = memory_mapper_->Read(operand) | memory_mapper_->Read(operand + 1) << 8;
+        writes = kRegisterA;
+        next += 2;
+        break;
+      case 0x0a: // LD A,(BC)
+      case 0x1a: // LD A,(DE)
+      case 0x7e: // LD A,(HL)
+        polls = true;
+        polled = decoded.opcode_name == 0x0a ? cpu_.rBC : decoded.opcode_name == 0x1a ? cpu_.rDE : cpu_.rHL;
+        writes = kRegisterA;
+        break;
+      case 0xfe: // CP n
+        reads = kRegisterA;
+        writes = kFlagZ | kFlagC;
+        next += 1;
+        break;
+      case 0xbe: // CP (HL)
+        polls = true;
+        polled = cpu_.rHL;
+        reads = kRegisterA;
+        writes = kFlagZ | kFlagC;
+        break;
+      case 0xe6: // AND n
+      case 0xf6: // OR n
+        next += 1;
+        // Fall through.
+      case 0xa7: // AND A
+      case 0xb7: // OR A
+        reads = kRegisterA;
+        writes = kRegisterA | kFlagZ | kFlagC;
+        break;
+      case 0x18: // JR n
+      case 0x20: // JR NZ,n
+      case 0x28: // JR Z,n
+      case 0x30: // JR NC,n
+      case 0x38: // JR C,n
+        branches = true;
+        target = operand + 1 + static_cast<signed char>(memory_mapper_->Read(operand));
+        reads = decoded.opcode_name == 0x18 ? 0 : decoded.opcode_name < 0x30 ? kFlagZ : kFlagC;
+        break;
+      case 0xc3: // JP nn
+      case 0xc2: // JP NZ,nn
+      case 0xca: // JP Z,nn
+      case 0xd2: // JP NC,nn
+      case 0xda: // JP C,nn
+        branches = true;
+        target = memory_mapper_->Read(operand) | memory_mapper_->Read(operand + 1) << 8;
+        reads = decoded.opcode_name == 0xc3 ? 0 : decoded.opcode_name < 0xd0 ? kFlagZ : kFlagC;
+        break;
+      default:
+        // BIT b,A and BIT b,(HL).
+        if ((decoded.opcode_name & 0xffc7) == 0xcb47) {
+          reads = kRegisterA;
+        } else if ((decoded.opcode_name & 0xffc7) == 0xcb46) {
+          polls = true;
+          polled = cpu_.rHL;
+        } else {
+          return 0;
+        }
+        writes = kFlagZ;
+        break;
+    }
+    if (polls && !IsPollable(polled)) {
+      return 0;
+    }
+    read_first |= reads & ~written;
+    written |= writes;
+    cycles += decoded.opcode->clock_cycles;
+    if (branches) {
+      if (target != head || (read_first & written) != 0) {
+        return 0;
+      }
+      return cycles;
+    }
+    address = next;
+  }
+  return 0;
+}
+
+} // namespace handlers
+} // namespace back_end
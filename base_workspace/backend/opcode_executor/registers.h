@@ -4,6 +4,17 @@
 namespace back_end {
 namespace registers {
 
+// An H or C flag that has not been worked out yet. The 16-bit arithmetic only
+// records what the flag depends on, since most flags are overwritten before
+// anything looks at them; handlers::MaterializeFlags computes it and stores it
+// in rF.
+struct PendingFlag {
+  // A handlers::FlagOperation, or 0 if rF already holds the flag.
+  unsigned char operation = 0;
+  unsigned int left;
+  unsigned int right;
+};
+
 struct GB_CPU {
 	union {
 		struct {
@@ -46,8 +57,35 @@ struct GB_CPU {
 
 	unsigned short rPC;
 	unsigned short rSP;	
+
+	// Only the ALU helpers in opcode_handlers.h touch these; anything else
+	// reading or writing rF or rAF calls handlers::MaterializeFlags first.
+	PendingFlag pending_h;
+	PendingFlag pending_c;
 };
 
+// Register selectors used to fix an opcode handler's operands at compile time,
+// e.g. Add8Bit<rB> is ADD A,B.
+enum Register8 { rA, rB, rC, rD, rE, rH, rL };
+enum Register16 { rAF, rBC, rDE, rHL, rSP, rPC };
+
+template<Register8 reg> unsigned char& Get8(GB_CPU* cpu);
+template<> inline unsigned char& Get8<rA>(GB_CPU* cpu) { return cpu->flag_struct.rA; }
+template<> inline unsigned char& Get8<rB>(GB_CPU* cpu) { return cpu->bc_struct.rB; }
+template<> inline unsigned char& Get8<rC>(GB_CPU* cpu) { return cpu->bc_struct.rC; }
+template<> inline unsigned char& Get8<rD>(GB_CPU* cpu) { return cpu->de_struct.rD; }
+template<> inline unsigned char& Get8<rE>(GB_CPU* cpu) { return cpu->de_struct.rE; }
+template<> inline unsigned char& Get8<rH>(GB_CPU* cpu) { return cpu->hl_struct.rH; }
+template<> inline unsigned char& Get8<rL>(GB_CPU* cpu) { return cpu->hl_struct.rL; }
+
+template<Register16 reg> unsigned short& Get16(GB_CPU* cpu);
+template<> inline unsigned short& Get16<rAF>(GB_CPU* cpu) { return cpu->rAF; }
+template<> inline unsigned short& Get16<rBC>(GB_CPU* cpu) { return cpu->rBC; }
+template<> inline unsigned short& Get16<rDE>(GB_CPU* cpu) { return cpu->rDE; }
+template<> inline unsigned short& Get16<rHL>(GB_CPU* cpu) { return cpu->rHL; }
+template<> inline unsigned short& Get16<rSP>(GB_CPU* cpu) { return cpu->rSP; }
+template<> inline unsigned short& Get16<rPC>(GB_CPU* cpu) { return cpu->rPC; }
+
 } // namespace registers
 } // namespace back_end
 #endif // TURBO_SANTA_COMMON_BACK_END_REGISTERS_H_
@@ -0,0 +1,274 @@
+#include "backend/opcode_executor/opcode_executor.h"
+
+#include "backend/opcode_executor/opcode_handlers.h"
+#include "submodules/glog/src/glog/logging.h"
+
+#if !defined(__GNUC__)
+#error "The threaded interpreter needs labels as values (GCC or Clang)."
+#endif
+
+// A single function interpreter for builds with THREADED_INTERPRETER defined.
+//
+// Every opcode ends with its own copy of the fetch and an indirect jump
+// through a table of label addresses, so the branch predictor learns what
+// tends to follow each opcode rather than having one call site for all of
+// them. Loads between registers, immediate loads, 16-bit increments and
+// decrements, JP nn and JR n are done inline on registers held in locals.
+// Everything else, and any opcode whose table entry is not the handler the
+// inline version was written against, flushes the locals back to the GB_CPU
+// and calls its handler as ReadInstruction would.
+
+namespace back_end {
+namespace handlers {
+
+using opcodes::Opcode;
+using opcodes::OpcodeHandler;
+using registers::rA;
+using registers::rB;
+using registers::rC;
+using registers::rD;
+using registers::rE;
+using registers::rH;
+using registers::rL;
+using registers::rBC;
+using registers::rDE;
+using registers::rHL;
+using registers::rSP;
+
+namespace {
+// How many instructions may run before control goes back to the Clocktroller,
+// which has to look in now and again to see if it has been paused or killed.
+const int kMaxInstructionsPerCall = 64;
+
+template<registers::Register8 destination, registers::Register8 source>
+bool IsLoad(OpcodeHandler handler) {
+  return handler == &LoadRR8Bit<destination, source> ||
+      (source == rA && handler == &LoadNA<destination>);
+}
+} // namespace
+
+// X(local, Register8, encoding) for the registers LD r,r' can name.
+#define THREADED_REGISTERS(X) \
+    X(a, rA, 7) X(b, rB, 0) X(c, rC, 1) X(d, rD, 2) X(e, rE, 3) X(h, rH, 4) X(l, rL, 5)
+
+#define THREADED_SOURCES(X, dst, DST, dst_code) \
+    X(dst, DST, dst_code, a, rA, 7) X(dst, DST, dst_code, b, rB, 0) X(dst, DST, dst_code, c, rC, 1) \
+    X(dst, DST, dst_code, d, rD, 2) X(dst, DST, dst_code, e, rE, 3) X(dst, DST, dst_code, h, rH, 4) \
+    X(dst, DST, dst_code, l, rL, 5)
+
+#define THREADED_LOADS(X) \
+    THREADED_SOURCES(X, a, rA, 7) THREADED_SOURCES(X, b, rB, 0) THREADED_SOURCES(X, c, rC, 1) \
+    THREADED_SOURCES(X, d, rD, 2) THREADED_SOURCES(X, e, rE, 3) THREADED_SOURCES(X, h, rH, 4) \
+    THREADED_SOURCES(X, l, rL, 5)
+
+// X(high, low, Register16, encoding) for BC, DE and HL.
+#define THREADED_PAIRS(X) X(b, c, rBC, 0) X(d, e, rDE, 1) X(h, l, rHL, 2)
+
+int OpcodeExecutor::RunThreaded() {
+  // Label addresses only exist inside this function, so the table is filled
+  // in on the first call. Index 256 is for CB prefixed instructions and STOP.
+  void** dispatch = threaded_dispatch_;
+  if (!threaded_dispatch_ready_) {
+    const Opcode* primary = opcode_table_->primary;
+    for (int i = 0; i < 257; i++) {
+      dispatch[i] = &&generic;
+    }
+    if (primary[0x00].handler == &NOP) {
+      dispatch[0x00] = &&nop;
+    }
+#define SET_LOAD(dst, DST, dst_code, src, SRC, src_code) \
+    if (IsLoad<DST, SRC>(primary[0x40 | dst_code << 3 | src_code].handler)) { \
+      dispatch[0x40 | dst_code << 3 | src_code] = &&load_##dst##_##src; \
+    }
+    THREADED_LOADS(SET_LOAD)
+#undef SET_LOAD
+#define SET_LOAD_LITERAL(reg, REG, code) \
+    if (primary[0x06 | code << 3].handler == &LoadN<REG>) { \
+      dispatch[0x06 | code << 3] = &&load_##reg##_literal; \
+    }
+    THREADED_REGISTERS(SET_LOAD_LITERAL)
+#undef SET_LOAD_LITERAL
+#define SET_PAIR_OPS(high, low, PAIR, code) \
+    if (primary[0x01 | code << 4].handler == &LoadNN<PAIR>) { \
+      dispatch[0x01 | code << 4] = &&load_##high##low##_literal; \
+    } \
+    if (primary[0x03 | code << 4].handler == &Inc16Bit<PAIR>) { \
+      dispatch[0x03 | code << 4] = &&inc_##high##low; \
+    } \
+    if (primary[0x0b | code << 4].handler == &Dec16Bit<PAIR>) { \
+      dispatch[0x0b | code << 4] = &&dec_##high##low; \
+    }
+    THREADED_PAIRS(SET_PAIR_OPS)
+#undef SET_PAIR_OPS
+    if (primary[0x31].handler == &LoadNN<rSP>) {
+      dispatch[0x31] = &&load_sp_literal;
+    }
+    if (primary[0x33].handler == &Inc16Bit<rSP>) {
+      dispatch[0x33] = &&inc_sp;
+    }
+    if (primary[0x3b].handler == &Dec16Bit<rSP>) {
+      dispatch[0x3b] = &&dec_sp;
+    }
+    if (primary[0xc3].handler == &Jump) {
+      dispatch[0xc3] = &&jump;
+    }
+    if (primary[0x18].handler == &JumpRelative) {
+      dispatch[0x18] = &&jump_relative;
+    }
+    threaded_dispatch_ready_ = true;
+  }
+
+  memory::MemoryMapper* memory_mapper = memory_mapper_.get();
+  unsigned char a = cpu_.flag_struct.rA;
+  unsigned char b = cpu_.bc_struct.rB;
+  unsigned char c = cpu_.bc_struct.rC;
+  unsigned char d = cpu_.de_struct.rD;
+  unsigned char e = cpu_.de_struct.rE;
+  unsigned char h = cpu_.hl_struct.rH;
+  unsigned char l = cpu_.hl_struct.rL;
+  unsigned short sp = cpu_.rSP;
+  unsigned short pc = cpu_.rPC;
+  const DecodedInstruction* decoded;
+  DecodedInstruction decoded_now;
+  int cycles;
+  int executed = 0;
+
+#define FLUSH() \
+    cpu_.flag_struct.rA = a; cpu_.bc_struct.rB = b; cpu_.bc_struct.rC = c; \
+    cpu_.de_struct.rD = d; cpu_.de_struct.rE = e; cpu_.hl_struct.rH = h; \
+    cpu_.hl_struct.rL = l; cpu_.rSP = sp; cpu_.rPC = pc
+
+#define RELOAD() \
+    a = cpu_.flag_struct.rA; b = cpu_.bc_struct.rB; c = cpu_.bc_struct.rC; \
+    d = cpu_.de_struct.rD; e = cpu_.de_struct.rE; h = cpu_.hl_struct.rH; \
+    l = cpu_.hl_struct.rL; sp = cpu_.rSP; pc = cpu_.rPC
+
+// Fetches the instruction at pc and jumps to it. The cycles are read now
+// since the instruction may write over its own decode cache entry.
+#define DISPATCH() \
+    decoded = decode_cache_.Lookup(pc); \
+    if (decoded == nullptr) { \
+      decoded_now = DecodeInstruction(pc); \
+      if (decoded_now.opcode == nullptr) { \
+        pc += decoded_now.length; \
+        FLUSH(); \
+        return -1; \
+      } \
+      decode_cache_.Insert(pc, decoded_now); \
+      decoded = &decoded_now; \
+    } \
+    cycles = decoded->opcode->clock_cycles; \
+    goto *dispatch[decoded->length == 1 ? decoded->opcode_name : 256]
+
+// Same rules as FinishInstruction for carrying on to the next instruction.
+#define NEXT() \
+    if (cycle_listener_ == nullptr || ++executed == kMaxInstructionsPerCall) { \
+      FLUSH(); \
+      return cycles; \
+    } \
+    cycle_listener_->OnCycles(cycles); \
+    if (interrupt_master_enable_ && CheckInterrupts()) { \
+      FLUSH(); \
+      return 0; \
+    } \
+    DISPATCH()
+
+  DISPATCH();
+
+generic:
+  FLUSH();
+  if (ExecuteDecoded(*decoded, pc) == -1) {
+    return -1;
+  }
+  RELOAD();
+  NEXT();
+
+nop:
+  pc += 1;
+  NEXT();
+
+#define LOAD(dst, DST, dst_code, src, SRC, src_code) \
+load_##dst##_##src: \
+  dst = src; \
+  pc += 1; \
+  NEXT();
+  THREADED_LOADS(LOAD)
+#undef LOAD
+
+#define LOAD_LITERAL(reg, REG, code) \
+load_##reg##_literal: \
+  reg = memory_mapper->Read(pc + 1); \
+  pc += 2; \
+  NEXT();
+  THREADED_REGISTERS(LOAD_LITERAL)
+#undef LOAD_LITERAL
+
+#define PAIR_OPS(high, low, PAIR, code) \
+load_##high##low##_literal: \
+  low = memory_mapper->Read(pc + 1); \
+  high = memory_mapper->Read(pc + 2); \
+  pc += 3; \
+  NEXT(); \
+inc_##high##low: \
+  if (++low == 0) { \
+    ++high; \
+  } \
+  pc += 1; \
+  NEXT(); \
+dec_##high##low: \
+  if (low-- == 0) { \
+    --high; \
+  } \
+  pc += 1; \
+  NEXT();
+  THREADED_PAIRS(PAIR_OPS)
+#undef PAIR_OPS
+
+load_sp_literal:
+  sp = memory_mapper->Read(pc + 2) << 8 | memory_mapper->Read(pc + 1);
+  pc += 3;
+  NEXT();
+
+inc_sp:
+  ++sp;
+  pc += 1;
+  NEXT();
+
+dec_sp:
+  --sp;
+  pc += 1;
+  NEXT();
+
+jump: {
+  // Same order of reads as GetAddress16.
+  unsigned char upper = memory_mapper->Read(pc + 2);
+  unsigned char lower = memory_mapper->Read(pc + 1);
+  pc = upper << 8 | lower;
+  NEXT();
+}
+
+jump_relative: {
+  int target = pc + 2 + static_cast<signed char>(memory_mapper->Read(pc + 1));
+  if (target == -1) {
+    // JumpRelative returns the same thing, which reads as a failed handler.
+    pc += 1;
+    FLUSH();
+    return -1;
+  }
+  pc = target;
+  NEXT();
+}
+
+#undef NEXT
+#undef DISPATCH
+#undef RELOAD
+#undef FLUSH
+}
+
+#undef THREADED_PAIRS
+#undef THREADED_LOADS
+#undef THREADED_SOURCES
+#undef THREADED_REGISTERS
+
+} // namespace handlers
+} // namespace back_end
@@ -6,7 +6,7 @@
 #include "backend/opcode_executor/opcode_executor.h"
 #include "backend/opcode_executor/registers.h"
 #include "backend/memory/memory_mapper.h"
-#include "backend/memory/mbc.h"
+#include "backend/memory/save_state.h"
 
 namespace test_harness {
 using std::string;
@@ -14,7 +14,9 @@ using std::to_string;
 using std::unique_ptr;
 using std::vector;
 using back_end::memory::MemoryMapper;
-using back_end::memory::MBC;
+using back_end::memory::StateReader;
+using back_end::memory::StateWriter;
+using back_end::handlers::MaterializeFlags;
 using back_end::registers::GB_CPU;
 using ::testing::AssertionResult;
 using ::testing::AssertionSuccess;
@@ -22,6 +24,9 @@ using ::testing::AssertionFailure;
 using ::testing::Message;
 
 namespace {
+// Cleared between tests, since that is where they put their code.
+const int kCodeSize = 0x4000;
+
 AssertionResult ExpectRegisterEquals(unsigned short expected, unsigned short actual, const string& name) {
   if (expected != actual) {
     Message failure_message;
@@ -33,6 +38,17 @@ AssertionResult ExpectRegisterEquals(unsigned short expected, unsigned short act
 }
 } // namespace
 
+TestMachine::TestMachine() {
+  primary_flags_.Init();
+  add_memory_segment(&low_);
+  add_memory_segment(&high_);
+  unique_ptr<MemoryMapper> memory_mapper(new MemoryMapper());
+  memory_mapper->RegisterModule(primary_flags_);
+  memory_mapper->RegisterModule(*this);
+  executor_ = unique_ptr<back_end::handlers::OpcodeExecutor>(
+      new back_end::handlers::OpcodeExecutor(std::move(memory_mapper), &primary_flags_));
+}
+
 void TestHarness::SetMemoryState(const vector<MemoryAddressValuePair>& memory_diff_list) {
   for (const MemoryAddressValuePair& memory_diff : memory_diff_list) {
     SetMemoryState(memory_diff);
@@ -40,7 +56,7 @@ void TestHarness::SetMemoryState(const vector<MemoryAddressValuePair>& memory_di
 }
 
 void TestHarness::SetMemoryState(const MemoryAddressValuePair& memory_diff) {
-  MemoryMapper* memory_mapper = &parser_->memory_mapper_;
+  MemoryMapper* memory_mapper = parser_->memory_mapper_.get();
   memory_mapper->Write(memory_diff.address, memory_diff.value);
 }
 
@@ -63,7 +79,7 @@ AssertionResult TestHarness::AssertRegisterState(const vector<RegisterNameValueP
 
 AssertionResult TestHarness::AssertMemoryState(const vector<MemoryAddressValuePair>&  memory_diff_list) {
   for (const MemoryAddressValuePair& memory_diff : memory_diff_list) {
-    MemoryMapper* memory_mapper = &parser_->memory_mapper_;
+    MemoryMapper* memory_mapper = parser_->memory_mapper_.get();
     unsigned char actual_value = memory_mapper->Read(memory_diff.address);
     if (memory_diff.value != actual_value) {
       Message failure_message;
@@ -76,38 +92,38 @@ AssertionResult TestHarness::AssertMemoryState(const vector<MemoryAddressValuePa
 }
 
 unsigned int TestHarness::ExecuteInstruction(unsigned char instruction) {
-  parser_->memory_mapper_.mbc_->ForceWrite(instruction_ptr(), instruction); // We put the instruction in right before it gets called.
+  parser_->memory_mapper_->Write(instruction_ptr(), instruction); // We put the instruction in right before it gets called.
   return parser_->ReadInstruction();
 }
 
 unsigned int TestHarness::ExecuteInstruction(unsigned short instruction) {
   unsigned char lsb = (unsigned char)(0x00FF & instruction);
   unsigned char msb = (unsigned char)((0xFF00 & instruction) >> 8);
-  parser_->memory_mapper_.mbc_->ForceWrite(instruction_ptr(), msb);
-  parser_->memory_mapper_.mbc_->ForceWrite(instruction_ptr() + 1, lsb);
+  parser_->memory_mapper_->Write(instruction_ptr(), msb);
+  parser_->memory_mapper_->Write(instruction_ptr() + 1, lsb);
   return parser_->ReadInstruction();
 }
 
 unsigned int TestHarness::ExecuteInstruction(unsigned char instruction, unsigned short value) {
-    parser_->memory_mapper_.mbc_->ForceWrite(instruction_ptr(), instruction); // We put the instruction in right before it gets called.
+    parser_->memory_mapper_->Write(instruction_ptr(), instruction); // We put the instruction in right before it gets called.
     // TODO(Deigo): Make sure that we are actually MSB.
-    parser_->memory_mapper_.mbc_->ForceWrite(instruction_ptr() + 1, static_cast<unsigned char>(value >> 8));
-    parser_->memory_mapper_.mbc_->ForceWrite(instruction_ptr() + 2, static_cast<unsigned char>(value));
+    parser_->memory_mapper_->Write(instruction_ptr() + 1, static_cast<unsigned char>(value >> 8));
+    parser_->memory_mapper_->Write(instruction_ptr() + 2, static_cast<unsigned char>(value));
     return parser_->ReadInstruction();
 }
 
 unsigned int TestHarness::ExecuteInstruction(unsigned char instruction, unsigned char value) {
-    parser_->memory_mapper_.mbc_->ForceWrite(instruction_ptr(), instruction); // We put the instruction in right before it gets called.
-    parser_->memory_mapper_.mbc_->ForceWrite(instruction_ptr() + 1, value);
+    parser_->memory_mapper_->Write(instruction_ptr(), instruction); // We put the instruction in right before it gets called.
+    parser_->memory_mapper_->Write(instruction_ptr() + 1, value);
     return parser_->ReadInstruction();
 }
 
 void TestHarness::LoadROM(const vector<TestROM>& test_rom) {
-  MBC* mbc = parser_->memory_mapper_.mbc_.get();
+  MemoryMapper* memory_mapper = parser_->memory_mapper_.get();
   for (const TestROM& segment : test_rom) {
     unsigned short address = segment.start_address;
     for (unsigned char instruction : segment.instructions) {
-      mbc->ForceWrite(address, instruction);
+      memory_mapper->Write(address, instruction);
       address++;
     }
   }
@@ -130,9 +146,24 @@ void TestHarness::LoadAndRunROM(const vector<TestROM>& test_rom) {
   Run(instruction_number_to_run);
 }
 
+vector<unsigned char> TestHarness::State() {
+  StateWriter counter;
+  parser_->SaveState(&counter);
+  vector<unsigned char> state(counter.size());
+  StateWriter writer(state.data(), state.size());
+  parser_->SaveState(&writer);
+  return state;
+}
+
+void TestHarness::LoadState(const vector<unsigned char>& state) {
+  StateReader reader(state.data(), state.size());
+  parser_->LoadState(&reader);
+}
+
 AssertionResult TestHarness::ValidateRegister(const RegisterNameValuePair& register_diff) {
   unsigned short value = register_diff.register_value;
   GB_CPU* cpu = &parser_->cpu_;
+  MaterializeFlags(cpu);
   switch (register_diff.register_name) {
     case RegisterNameValuePair::B:
       return ExpectRegisterEquals(value, cpu->bc_struct.rB, "B");
@@ -176,7 +207,7 @@ AssertionResult TestHarness::ValidateRegister(const RegisterNameValuePair& regis
 
 bool TestHarness::VerifyCorrectInstruction(const vector<unsigned char>& instruction) {
   for (unsigned long i = 0; i < instruction.size(); i++) {
-    if (parser_->memory_mapper_.Read(i) != instruction[i]) {
+    if (parser_->memory_mapper_->Read(i) != instruction[i]) {
       return false;
     }
   }
@@ -184,8 +215,8 @@ bool TestHarness::VerifyCorrectInstruction(const vector<unsigned char>& instruct
 }
 
 void TestHarness::ClearParser() {
-  for (int i = 0; i < MBC::kROMBank0Size; i++) {
-    parser_->memory_mapper_.mbc_->ForceWrite(i, 0x00);
+  for (int i = 0; i < kCodeSize; i++) {
+    parser_->memory_mapper_->Write(i, 0x00);
   }
   typedef RegisterNameValuePair::RegisterName R;
   SetRegisterState({
@@ -210,7 +241,7 @@ void TestHarness::ClearParser() {
 
 bool TestHarness::SetInitialState(const DiffState& state_diff) {
   for (unsigned long i = 0; i < state_diff.memory.size(); i++) {
-    parser_->memory_mapper_.Write(state_diff.memory[i].address, state_diff.memory[i].value);
+    parser_->memory_mapper_->Write(state_diff.memory[i].address, state_diff.memory[i].value);
   }
 
   for (const RegisterNameValuePair& register_diff : state_diff.registers) {
@@ -224,6 +255,7 @@ bool TestHarness::SetInitialState(const DiffState& state_diff) {
 bool TestHarness::SetRegisterState(const RegisterNameValuePair& state_diff) {
   unsigned short value = state_diff.register_value;
   GB_CPU* cpu = &parser_->cpu_;
+  MaterializeFlags(cpu);
   switch (state_diff.register_name) {
     case RegisterNameValuePair::B:
       cpu->bc_struct.rB = value;
@@ -285,7 +317,7 @@ bool TestHarness::LoadROM(const vector<InstructionExpectedStatePair>& instructio
   int i = 0;
   for (const InstructionExpectedStatePair& instruction : instructions) {
     for (unsigned char byte : instruction.instruction) {
-      parser_->memory_mapper_.Write(i, byte);
+      parser_->memory_mapper_->Write(i, byte);
       i++;
     }
   }
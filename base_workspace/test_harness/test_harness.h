@@ -4,12 +4,30 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include "backend/memory/module.h"
+#include "backend/memory/primary_flags.h"
+#include "backend/memory/ram_segment.h"
 #include "backend/opcode_executor/opcode_executor.h"
 #include "submodules/googletest/include/gtest/gtest.h"
 #include "test_harness/test_harness_utils.h"
 
 namespace test_harness {
 
+// An OpcodeExecutor on RAM everywhere but the IO ports, so that a TestHarness
+// can put code and data anywhere, with interrupts off and every register 0.
+class TestMachine : public back_end::memory::Module {
+    public:
+        TestMachine();
+
+        back_end::handlers::OpcodeExecutor* executor() { return executor_.get(); }
+
+    private:
+        back_end::memory::PrimaryFlags primary_flags_;
+        back_end::memory::RAMSegment low_{0x0000, 0xfeff};
+        back_end::memory::RAMSegment high_{0xff80, 0xfffe};
+        std::unique_ptr<back_end::handlers::OpcodeExecutor> executor_;
+};
+
 class TestHarness : public ::testing::Test {
     public:
         void SetMemoryState(const std::vector<MemoryAddressValuePair>& memory_diff);
@@ -36,6 +54,10 @@ class TestHarness : public ::testing::Test {
         void Run(int instruction_number_to_run);
         void LoadAndRunROM(const std::vector<TestROM>& test_rom);
         unsigned short instruction_ptr() { return parser_->cpu_.rPC; }
+        // The registers, IME and all of memory, as OpcodeExecutor::SaveState
+        // saves them, which works out any pending flags first.
+        std::vector<unsigned char> State();
+        void LoadState(const std::vector<unsigned char>& state);
 
     protected:
         TestHarness(back_end::handlers::OpcodeExecutor* parser) : parser_(parser) {}